@@ -17,10 +17,12 @@
 #include "mpslib.h"
 
 #include <stdio.h> /* fflush, printf, putchar */
+#include <stdlib.h> /* free, malloc */
 
 
 /* These values have been tuned in the hope of getting one dynamic collection. */
 #define testArenaSIZE     ((size_t)1000*1024)
+#define cardsGrainMIN     ((size_t)4096) /* likely minimum grain size */
 #define gen1SIZE          ((size_t)20)
 #define gen2SIZE          ((size_t)85)
 #define avLEN             3
@@ -30,6 +32,8 @@
 #define collectionsCOUNT  37
 #define rampSIZE          9
 #define initTestFREQ      6000
+#define protRootsPAGES    16
+#define protAlignMIN      ((size_t)1 << 16) /* at least the page size */
 
 /* testChain -- generation parameters for the test */
 
@@ -45,6 +49,8 @@ static mps_arena_t arena;
 static mps_ap_t ap;
 static mps_addr_t exactRoots[exactRootsCOUNT];
 static mps_addr_t ambigRoots[ambigRootsCOUNT];
+static mps_addr_t *protRoots;   /* page-aligned, see main */
+static size_t protRootsCount;
 static size_t scale;            /* Overall scale factor. */
 static unsigned long nCollsStart;
 static unsigned long nCollsDone;
@@ -130,11 +136,12 @@ static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
 
 /* test -- the body of the test */
 
-static void test(mps_pool_class_t pool_class, size_t roots_count)
+static void test(mps_pool_class_t pool_class, size_t roots_count,
+                 size_t extend_by)
 {
   mps_fmt_t format;
   mps_chain_t chain;
-  mps_root_t exactRoot, ambigRoot;
+  mps_root_t exactRoot, ambigRoot, protRoot;
   unsigned long objs; size_t i;
   mps_word_t collections, rampSwitch;
   mps_alloc_pattern_t ramp = mps_alloc_pattern_ramp();
@@ -143,12 +150,22 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
   mps_addr_t busy_init;
   mps_pool_t pool;
   int described = 0; 
+  size_t pauses, over;
+  double total, max;
 
   die(dylan_fmt(&format, arena), "fmt_create");
   die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
 
-  die(mps_pool_create(&pool, arena, pool_class, format, chain),
-      "pool_create(amc)");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    if (extend_by > 0) {
+      MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, extend_by);
+      MPS_ARGS_ADD(args, MPS_KEY_LARGE_SIZE, extend_by);
+    }
+    die(mps_pool_create_k(&pool, arena, pool_class, args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
 
   die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
   die(mps_ap_create(&busy_ap, pool, mps_rank_exact()), "BufferCreate 2");
@@ -157,6 +174,8 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
     exactRoots[i] = objNULL;
   for(i = 0; i < ambigRootsCOUNT; ++i)
     ambigRoots[i] = rnd_addr();
+  for(i = 0; i < protRootsCount; ++i)
+    protRoots[i] = objNULL;
 
   die(mps_root_create_table_masked(&exactRoot, arena,
                                    mps_rank_exact(), (mps_rm_t)0,
@@ -167,6 +186,11 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
                             mps_rank_ambig(), (mps_rm_t)0,
                             &ambigRoots[0], ambigRootsCOUNT),
       "root_create_table(ambig)");
+  die(mps_root_create_area_tagged(&protRoot, arena, mps_rank_exact(),
+                                  MPS_RM_PROT | MPS_RM_PROT_PAGES,
+                                  &protRoots[0], &protRoots[protRootsCount],
+                                  mps_scan_area_tagged, (mps_word_t)1, 0),
+      "root_create_area_tagged(prot)");
 
   /* create an ap, and leave it busy */
   die(mps_reserve(&busy_init, busy_ap, 64), "mps_reserve busy");
@@ -221,6 +245,9 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
              || (dylan_check(exactRoots[i])
                  && mps_arena_has_addr(arena, exactRoots[i])),
              "all roots check");
+      for (i = 0; i < protRootsCount; ++i)
+        cdie(protRoots[i] == objNULL || dylan_check(protRoots[i]),
+             "protected roots check");
       cdie(!mps_arena_has_addr(arena, NULL),
            "NULL in arena");
 
@@ -264,6 +291,7 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
       if (exactRoots[i] != objNULL)
         cdie(dylan_check(exactRoots[i]), "dying root check");
       exactRoots[i] = make(roots_count);
+      protRoots[rnd() % protRootsCount] = exactRoots[i];
       if (exactRoots[(exactRootsCOUNT-1) - i] != objNULL)
         dylan_write(exactRoots[(exactRootsCOUNT-1) - i],
                     exactRoots, exactRootsCOUNT);
@@ -288,19 +316,151 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
 
   (void)mps_commit(busy_ap, busy_init, 64);
   mps_arena_park(arena);
+
+  /* The collections must have measured the rate of scanning. */
+  Insist(mps_arena_scan_rate(arena) > 0.0);
+  Insist(mps_arena_reclaim_rate(arena) >= 0.0);
+  Insist(mps_pool_scan_rate(pool, mps_rank_exact()) >= 0.0);
+  Insist(mps_arena_pause_achieved(arena) >= 0.0);
+  printf("\nscan rate %g B/s, reclaim rate %g B/s, exact pool scan rate %g B/s\n",
+         mps_arena_scan_rate(arena), mps_arena_reclaim_rate(arena),
+         mps_pool_scan_rate(pool, mps_rank_exact()));
+  printf("pause time %g s, achieved %g s\n",
+         mps_arena_pause_time(arena), mps_arena_pause_achieved(arena));
+  mps_arena_pause_stats(arena, &pauses, &over, &total, &max);
+  Insist(over <= pauses);
+  Insist(0.0 <= max && max <= total);
+  printf("pauses %lu, over %lu, total %g s, max %g s\n",
+         (unsigned long)pauses, (unsigned long)over, total, max);
+
   mps_ap_destroy(busy_ap);
   mps_ap_destroy(ap);
   mps_root_destroy(exactRoot);
   mps_root_destroy(ambigRoot);
+  mps_root_destroy(protRoot);
   mps_pool_destroy(pool);
   mps_chain_destroy(chain);
   mps_fmt_destroy(format);
   mps_arena_release(arena);
 }
 
+/* segInGen -- is the segment containing addr in generation i of chain? */
+
+static Bool segInGen(mps_chain_t chain, Index i, mps_addr_t addr)
+{
+  GenDesc gen = ChainGen((Chain)chain, i);
+  Ring node, next;
+  Seg seg;
+
+  if (!SegOfAddr(&seg, (Arena)arena, (Addr)addr))
+    return FALSE;
+  RING_FOR(node, &gen->segRing, next) {
+    GCSeg gcseg = RING_ELT(GCSeg, genRing, node);
+    if (&gcseg->segStruct == seg)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+
+/* test_pretenure -- check that a pretenured AP changes generation
+ *
+ * Allocates a list that stays alive through an allocation point with
+ * MPS_KEY_AP_PRETENURE, so that all of its segments survive, and
+ * checks that after a collection the allocation point allocates in
+ * the next generation.  See design/poolamc/#pretenure.auto.
+ */
+
+#define pretenureSLOTS 32
+
+static mps_addr_t pretenureList;
+
+static mps_addr_t pretenureCons(mps_ap_t pap)
+{
+  mps_word_t v;
+  die(make_dylan_vector(&v, pap, pretenureSLOTS), "make_dylan_vector");
+  DYLAN_VECTOR_SLOT((mps_word_t *)v, 0) = (mps_word_t)pretenureList;
+  pretenureList = (mps_addr_t)v;
+  return pretenureList;
+}
+
+static void test_pretenure(void)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t pap;
+  mps_root_t root;
+  mps_addr_t obj;
+  Seg seg;
+  Addr segBase;
+  Count segs;
+  size_t i;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_AP_PRETENURE, TRUE);
+    die(mps_ap_create_k(&pap, pool, args), "ap_create");
+  } MPS_ARGS_END(args);
+  pretenureList = objNULL;
+  die(mps_root_create_table_masked(&root, arena, mps_rank_exact(),
+                                   (mps_rm_t)0, &pretenureList, 1,
+                                   (mps_word_t)1),
+      "root_create_table(pretenure)");
+
+  /* Park the arena so that the only collection is the one below. */
+  mps_arena_park(arena);
+  obj = pretenureCons(pap);
+  Insist(segInGen(chain, 0, obj));
+
+  /* Fill enough segments for the survival of the allocation point to
+     be measured when they are collected. */
+  cdie(SegOfAddr(&seg, (Arena)arena, (Addr)obj), "SegOfAddr");
+  segBase = SegBase(seg);
+  segs = 0;
+  while (segs < 2 * AMC_PRETENURE_SAMPLE) {
+    obj = pretenureCons(pap);
+    cdie(SegOfAddr(&seg, (Arena)arena, (Addr)obj), "SegOfAddr");
+    if (SegBase(seg) != segBase) {
+      segBase = SegBase(seg);
+      ++segs;
+    }
+  }
+
+  /* Everything survives, so once the allocation point has used up its
+     current buffer it should allocate in the second generation. */
+  mps_arena_collect(arena);
+  obj = pretenureCons(pap);
+  cdie(SegOfAddr(&seg, (Arena)arena, (Addr)obj), "SegOfAddr");
+  segBase = SegBase(seg);
+  for (i = 0; SegBase(seg) == segBase; ++i) {
+    Insist(i < 1000000);
+    obj = pretenureCons(pap);
+    cdie(SegOfAddr(&seg, (Arena)arena, (Addr)obj), "SegOfAddr");
+  }
+  Insist(segInGen(chain, 1, obj));
+  printf("\nPretenured allocation point moved to generation 1.\n");
+
+  mps_arena_release(arena);
+  mps_root_destroy(root);
+  mps_ap_destroy(pap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+}
+
+
 int main(int argc, char *argv[])
 {
-  size_t i, grainSize;
+  size_t i, grainSize, protAlign;
+  void *protRootsBlock;
   mps_thr_t thread;
 
   testlib_init(argc, argv);
@@ -310,6 +470,15 @@ int main(int argc, char *argv[])
   grainSize = rnd_grain(scale * testArenaSIZE);
   printf("Picked scale=%lu grainSize=%lu\n", (unsigned long)scale, (unsigned long)grainSize);
 
+  /* The protected roots span several pages, and are aligned so that
+     protecting them doesn't protect anything else. */
+  protAlign = grainSize < protAlignMIN ? protAlignMIN : grainSize;
+  protRootsCount = protRootsPAGES * protAlign / sizeof(mps_addr_t);
+  protRootsBlock = malloc(protRootsCount * sizeof(mps_addr_t) + protAlign);
+  cdie(protRootsBlock != NULL, "malloc");
+  protRoots = (mps_addr_t *)(((mps_word_t)protRootsBlock + protAlign - 1)
+                             & ~(mps_word_t)(protAlign - 1));
+
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, scale * testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, grainSize);
@@ -318,11 +487,16 @@ int main(int argc, char *argv[])
   mps_message_type_enable(arena, mps_message_type_gc());
   mps_message_type_enable(arena, mps_message_type_gc_start());
   die(mps_thread_reg(&thread, arena), "thread_reg");
-  test(mps_class_amc(), exactRootsCOUNT);
-  test(mps_class_amcz(), 0);
+  test(mps_class_amc(), exactRootsCOUNT, 0);
+  test(mps_class_amcz(), 0, 0);
+  /* Large segments, so that they get cards: see design/seg/#card. */
+  test(mps_class_amc(), exactRootsCOUNT,
+       16 * (grainSize < cardsGrainMIN ? cardsGrainMIN : grainSize));
+  test_pretenure();
   mps_thread_dereg(thread);
   report();
   mps_arena_destroy(arena);
+  free(protRootsBlock);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
@@ -8,6 +8,7 @@
 #include "fmthe.h"
 #include "fmtdytst.h"
 #include "testlib.h"
+#include "mpm.h"
 #include "mpslib.h"
 #include "mpscamc.h"
 #include "mpsavm.h"
@@ -37,6 +38,12 @@
 static mps_gen_param_s testChain[genCOUNT] = {
   { gen1SIZE, 0.85 }, { gen2SIZE, 0.45 } };
 
+/* tuneLimits -- limits for tuning the generations in test_tune */
+
+static mps_gen_limit_s tuneLimits[genCOUNT] = {
+  { gen1SIZE / 2, gen1SIZE * 2, 0.0, 0.99 },
+  { gen2SIZE / 2, gen2SIZE * 2, 0.0, 1.0 } };
+
 
 /* objNULL needs to be odd so that it's ignored in exactRoots. */
 #define objNULL           ((mps_addr_t)MPS_WORD_CONST(0xDECEA5ED))
@@ -241,6 +248,96 @@ static void *test(mps_arena_t arena, mps_pool_class_t pool_class,
 }
 
 
+/* tuneCheck -- check the generations are within their limits
+ *
+ * Returns the capacity of the first generation.
+ */
+
+static size_t tuneCheck(mps_chain_t chain)
+{
+  size_t i;
+  for (i = 0; i < genCOUNT; ++i) {
+    GenDesc gen = ChainGen((Chain)chain, i);
+    Insist(tuneLimits[i].mps_min_capacity <= gen->capacity);
+    Insist(gen->capacity <= tuneLimits[i].mps_max_capacity);
+    Insist(tuneLimits[i].mps_min_mortality <= gen->mortality);
+    Insist(gen->mortality <= tuneLimits[i].mps_max_mortality);
+  }
+  return ChainGen((Chain)chain, 0)->capacity;
+}
+
+
+/* test_tune -- check that generation tuning respects the limits
+ *
+ * First keeps everything alive, so that the capacity of the first
+ * generation grows to its greatest, then lets everything die, so that
+ * it shrinks to its least, checking after every collection that the
+ * capacity and mortality of each generation are within the limits
+ * set by MPS_KEY_CHAIN_LIMITS.  See design/strategy/#policy.tune.
+ */
+
+#define tuneCOLLECTIONS 50
+
+static void test_tune(mps_arena_t arena)
+{
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_root_t exactRoot;
+  size_t i, j, capacity;
+
+  die(EnsureHeaderFormat(&format, arena), "fmt_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN_LIMITS, tuneLimits);
+    die(mps_chain_create_k(&chain, arena, genCOUNT, testChain, args),
+        "chain_create");
+  } MPS_ARGS_END(args);
+  die(mps_pool_create(&pool, arena, mps_class_amc(), format, chain),
+      "pool_create(amc)");
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
+  for(i = 0; i < exactRootsCOUNT; ++i)
+    exactRoots[i] = objNULL;
+  die(mps_root_create_table_masked(&exactRoot, arena,
+                                   mps_rank_exact(), (mps_rm_t)0,
+                                   &exactRoots[0], exactRootsCOUNT,
+                                   (mps_word_t)1),
+      "root_create_table(exact)");
+
+  /* Everything allocated since the last collection survives. */
+  capacity = tuneCheck(chain);
+  for (i = 0; i < tuneCOLLECTIONS
+         && capacity < tuneLimits[0].mps_max_capacity; ++i) {
+    for (j = 0; j < exactRootsCOUNT; ++j)
+      exactRoots[j] = make(0);
+    mps_arena_collect(arena);
+    capacity = tuneCheck(chain);
+  }
+  Insist(capacity == tuneLimits[0].mps_max_capacity);
+  printf("\nCapacity grew to %lu kB after %lu collections.\n",
+         (unsigned long)capacity, (unsigned long)i);
+
+  /* Nothing survives. */
+  for (j = 0; j < exactRootsCOUNT; ++j)
+    exactRoots[j] = objNULL;
+  for (i = 0; i < tuneCOLLECTIONS
+         && capacity > tuneLimits[0].mps_min_capacity; ++i) {
+    for (j = 0; j < exactRootsCOUNT; ++j)
+      (void)make(0);
+    mps_arena_collect(arena);
+    capacity = tuneCheck(chain);
+  }
+  Insist(capacity == tuneLimits[0].mps_min_capacity);
+  printf("Capacity shrank to %lu kB after %lu collections.\n",
+         (unsigned long)capacity, (unsigned long)i);
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(exactRoot);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_release(arena);
+}
+
+
 int main(int argc, char *argv[])
 {
   mps_arena_t arena;
@@ -257,6 +354,7 @@ int main(int argc, char *argv[])
   die(mps_thread_reg(&thread, arena), "thread_reg");
   test(arena, mps_class_amc(), exactRootsCOUNT);
   test(arena, mps_class_amcz(), 0);
+  test_tune(arena);
   mps_thread_dereg(thread);
   mps_arena_destroy(arena);
 
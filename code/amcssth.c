@@ -8,12 +8,17 @@
  * runs mps_arena_formatted_objects_walk(). This checks that walking
  * works while the other threads continue to allocate in the
  * background.
+ *
+ * The test is run twice: once with the threads doing the collection
+ * work as they allocate, and once with a background collector thread
+ * (MPS_KEY_ARENA_BACKGROUND).
  */
 
 #include "fmtdy.h"
 #include "fmtdytst.h"
 #include "testlib.h"
 #include "testthr.h"
+#include "mpm.h"
 #include "mpslib.h"
 #include "mpscamc.h"
 #include "mpsavm.h"
@@ -268,7 +273,59 @@ static void test_pool(const char *name, mps_pool_t pool, size_t roots_count)
     testthr_join(&kids[i], NULL);
 }
 
-static void test_arena(void)
+/* test_exempt -- check that an exempt allocation point doesn't pay
+ *
+ * Allocates through an allocation point created with
+ * MPS_KEY_AP_EXEMPT and an ordinary one, with the ordinary one doing
+ * most of the allocation, and checks that the debt of the exempt one
+ * is never paid while collections go on, because the ordinary one
+ * keeps the arena from falling behind.  See design/buffer/#poll.exempt.
+ */
+
+#define exemptCOLLECTIONS 4
+#define exemptRATIO       4
+
+static void test_exempt(mps_pool_t pool, size_t roots_count)
+{
+  mps_ap_t ap, exempt_ap;
+  Buffer buffer, exempt;
+  double debt, exemptDebt;
+  mps_word_t start = mps_collections(arena);
+  unsigned long paid = 0;
+  size_t i;
+
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_AP_EXEMPT, TRUE);
+    die(mps_ap_create_k(&exempt_ap, pool, args), "BufferCreate(exempt)");
+  } MPS_ARGS_END(args);
+  buffer = BufferOfAP(ap);
+  exempt = BufferOfAP(exempt_ap);
+
+  debt = buffer->debt;
+  exemptDebt = exempt->debt;
+  while (mps_collections(arena) < start + exemptCOLLECTIONS) {
+    for (i = 0; i < exemptRATIO; ++i) {
+      churn(ap, roots_count);
+      if (buffer->debt < debt)
+        ++paid;
+      debt = buffer->debt;
+    }
+    churn(exempt_ap, roots_count);
+    Insist(exempt->debt >= exemptDebt);
+    exemptDebt = exempt->debt;
+  }
+  Insist(paid > 0);
+  printf("\nExempt allocation point owes %lu bytes; "
+         "the other paid %lu times.\n",
+         (unsigned long)exemptDebt, paid);
+
+  mps_ap_destroy(exempt_ap);
+  mps_ap_destroy(ap);
+}
+
+
+static void test_arena(mps_bool_t background)
 {
   size_t i;
   mps_fmt_t format;
@@ -278,9 +335,12 @@ static void test_arena(void)
   mps_pool_t amc_pool, amcz_pool;
   void *marker = &marker;
 
+  printf("\n====== background: %s ======\n", background ? "yes" : "no");
+
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, rnd_grain(testArenaSIZE));
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND, background);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
   } MPS_ARGS_END(args);
   mps_message_type_enable(arena, mps_message_type_gc());
@@ -314,6 +374,7 @@ static void test_arena(void)
 
   test_pool("AMC", amc_pool, exactRootsCOUNT);
   test_pool("AMCZ", amcz_pool, 0);
+  test_exempt(amc_pool, exactRootsCOUNT);
 
   mps_arena_park(arena);
   mps_pool_destroy(amc_pool);
@@ -330,7 +391,8 @@ static void test_arena(void)
 int main(int argc, char *argv[])
 {
   testlib_init(argc, argv);
-  test_arena();
+  test_arena(FALSE);
+  test_arena(TRUE);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
@@ -18,7 +18,13 @@
 #include "mps.h"
 #include "mpm.h"
 
-#include <stdio.h> /* fflush, printf */
+#include <stdio.h> /* fclose, fflush, fopen, fputs, printf, sprintf */
+#include <string.h> /* strstr */
+
+#if defined(MPS_OS_LI)
+#include <sys/stat.h> /* mkdir */
+#include <unistd.h> /* getpid, rmdir, unlink */
+#endif
 
 
 #define exactRootsCOUNT 50
@@ -197,6 +203,169 @@ static void test_pool(mps_pool_class_t pool_class, mps_arg_s args[],
 }
 
 
+/* test_pressure -- check that memory pressure starts collections
+ *
+ * Points the arena's pressure monitor at a directory of fake control
+ * group files, and checks that collections are started because of
+ * memory pressure when, and only when, the files show it.  See
+ * design/arena/#pressure.
+ */
+
+#if defined(MPS_OS_LI)
+
+#define pressureARENA_SIZE ((size_t)64 << 20)
+#define pressureSTEP       ((size_t)4 << 20)
+#define pressureMAX        ((size_t)256 << 20)
+#define pressureSLOTS      62
+#define pressureCHECK      ((size_t)1 << 20)
+
+static char pressureDir[64];
+
+static void pressure_write(const char *name, const char *contents)
+{
+  char path[128];
+  FILE *f;
+
+  sprintf(path, "%s/%s", pressureDir, name);
+  f = fopen(path, "w");
+  cdie(f != NULL, "fopen");
+  cdie(fputs(contents, f) != EOF, "fputs");
+  cdie(fclose(f) == 0, "fclose");
+}
+
+static void pressure_unlink(const char *name)
+{
+  char path[128];
+  sprintf(path, "%s/%s", pressureDir, name);
+  cdie(unlink(path) == 0, "unlink");
+}
+
+static void pressure_stall(const char *avg10)
+{
+  char contents[128];
+  sprintf(contents, "some avg10=%s avg60=0.00 avg300=0.00 total=0\n"
+          "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n", avg10);
+  pressure_write("memory.pressure", contents);
+}
+
+/* pressure_collections -- count collections started by pressure */
+
+static unsigned pressure_collections(mps_arena_t pressureArena)
+{
+  unsigned count = 0;
+  mps_message_t message;
+
+  while (mps_message_get(&message, pressureArena,
+                         mps_message_type_gc_start())) {
+    if (strstr(mps_message_gc_start_why(pressureArena, message),
+               "short of memory") != NULL)
+      ++count;
+    mps_message_discard(pressureArena, message);
+  }
+  return count;
+}
+
+/* pressure_alloc -- allocate, and count pressure collections
+ *
+ * Allocates limit bytes of garbage, or if stop is true, stops as soon
+ * as a collection has been started by pressure.
+ */
+
+static unsigned pressure_alloc(mps_arena_t pressureArena, mps_ap_t pap,
+                               size_t limit, mps_bool_t stop)
+{
+  size_t size, objSize = (pressureSLOTS + 2) * sizeof(mps_word_t);
+  unsigned count = 0;
+
+  for (size = 0; size < limit; size += objSize) {
+    mps_word_t v;
+    die(make_dylan_vector(&v, pap, pressureSLOTS), "make_dylan_vector");
+    if (size / pressureCHECK != (size + objSize) / pressureCHECK) {
+      count += pressure_collections(pressureArena);
+      if (stop && count > 0)
+        break;
+    }
+  }
+  return count + pressure_collections(pressureArena);
+}
+
+static void test_pressure(void)
+{
+  mps_arena_t pressureArena;
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t pap;
+  mps_res_t res;
+  static mps_gen_param_s bigChain[1] = { { 1000000, 0.9 } };
+  char missing[96];
+
+  printf("\n\n*** Memory pressure\n");
+  sprintf(pressureDir, "/tmp/amsss-%lu", (unsigned long)getpid());
+  cdie(mkdir(pressureDir, 0700) == 0, "mkdir");
+
+  /* A directory that can't be read is an error. */
+  sprintf(missing, "%s/missing", pressureDir);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_PRESSURE_PATH, missing);
+    res = mps_arena_create_k(&pressureArena, mps_arena_class_vm(), args);
+  } MPS_ARGS_END(args);
+  cdie(res == MPS_RES_IO, "arena_create with missing pressure path");
+
+  pressure_write("memory.current", "104857600\n");
+  pressure_write("memory.max", "max\n");
+  pressure_stall("0.00");
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, pressureARENA_SIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_PRESSURE_PATH, pressureDir);
+    die(mps_arena_create_k(&pressureArena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  mps_message_type_enable(pressureArena, mps_message_type_gc_start());
+  die(mps_fmt_create_A(&format, pressureArena, dylan_fmt_A()),
+      "fmt_create");
+  die(mps_chain_create(&chain, pressureArena, 1, bigChain), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, pressureArena, mps_class_ams(), args),
+        "pool_create");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&pap, pool, mps_rank_exact()), "ap_create");
+
+  /* No pressure: no pressure collections. */
+  cdie(pressure_alloc(pressureArena, pap, pressureSTEP, FALSE) == 0,
+       "collection without pressure");
+
+  /* Tasks stalled on memory. */
+  pressure_stall("25.00");
+  cdie(pressure_alloc(pressureArena, pap, pressureMAX, TRUE) > 0,
+       "no collection for stall");
+
+  /* Memory in use near the limit. */
+  pressure_stall("0.00");
+  pressure_write("memory.max", "110000000\n");
+  (void)pressure_collections(pressureArena);
+  cdie(pressure_alloc(pressureArena, pap, pressureMAX, TRUE) > 0,
+       "no collection for memory.max");
+
+  mps_arena_park(pressureArena);
+  mps_ap_destroy(pap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(pressureArena);
+
+  pressure_unlink("memory.current");
+  pressure_unlink("memory.max");
+  pressure_unlink("memory.pressure");
+  cdie(rmdir(pressureDir) == 0, "rmdir");
+}
+
+#endif /* MPS_OS_LI */
+
+
 int main(int argc, char *argv[])
 {
   int i;
@@ -242,6 +411,10 @@ int main(int argc, char *argv[])
   mps_thread_dereg(thread);
   mps_arena_destroy(arena);
 
+#if defined(MPS_OS_LI)
+  test_pressure();
+#endif
+
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
 }
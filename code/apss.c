@@ -243,6 +243,8 @@ int main(int argc, char *argv[])
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, 2 * testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, FALSE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, arena_grain_size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_HUGE_PAGES, TRUE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SPARE_DECAY, 0.001);
     test(mps_arena_class_vm(), args, arena_grain_size, &bothOptions);
   } MPS_ARGS_END(args);
 
@@ -7,6 +7,8 @@
 
 #include "tract.h"
 #include "poolmv.h"
+#include "bg.h"
+#include "press.h"
 #include "mpm.h"
 #include "cbs.h"
 #include "bt.h"
@@ -179,16 +181,32 @@ Bool ArenaCheck(Arena arena)
    */
   CHECKL(arena->committed <= arena->commitLimit);
   CHECKL(arena->spareCommitted <= arena->committed);
+  CHECKL(0.0 <= arena->spareDecay);
+  /* no check for arena->spareDecayLast (Clock) */
+  CHECKL(arena->purgeTimeMax <= arena->purgeTime);
   CHECKL(0.0 <= arena->pauseTime);
+  CHECKL(BoolCheck(arena->backgroundWanted));
+  if (arena->background != NULL)
+    CHECKD_NOSIG(Background, arena->background);
+  if (arena->pressure != NULL)
+    CHECKD_NOSIG(Pressure, arena->pressure);
 
   CHECKL(arena->zoneShift == ZoneShiftUNSET
          || ShiftCheck(arena->zoneShift));
   CHECKL(ArenaGrainSizeCheck(arena->grainSize));
+  CHECKL(1 <= arena->nodes);
+  CHECKL(arena->nodes <= MPS_WORD_WIDTH);
 
   /* Stripes can't be smaller than grains. */
   CHECKL(arena->zoneShift == ZoneShiftUNSET
          || ((Size)1 << arena->zoneShift) >= arena->grainSize);
 
+  /* Fine zones divide zones.  See <design/arena/#zone.fine>. */
+  CHECKL(arena->zoneFineBits <= MPS_WORD_SHIFT);
+  CHECKL(arena->fineZoneShift == ZoneShiftUNSET
+         || arena->fineZoneShift <= arena->zoneShift);
+  CHECKL(arena->zoneFineBits > 0 || arena->usedFineZones == ZoneSetEMPTY);
+
   if (arena->lastTract == NULL) {
     CHECKL(arena->lastTractBase == (Addr)0);
   } else {
@@ -202,6 +220,10 @@ Bool ArenaCheck(Arena arena)
   /* Can't use CHECKD_NOSIG because TreeEMPTY is NULL. */
   CHECKL(TreeCheck(ArenaChunkTree(arena)));
   /* TODO: check that the chunkRing and chunkTree have identical members */
+  CHECKL(ShiftCheck(arena->chunkMapShift));
+  CHECKL(arena->chunkMapShift >= ChunkMapMinSHIFT);
+  CHECKL(AddrIsAligned(arena->chunkMapBase,
+                       (Align)1 << arena->chunkMapShift));
   /* nothing to check for chunkSerial */
   
   CHECKL(LocusCheck(arena));
@@ -222,9 +244,13 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
 {
   Res res;
   Bool zoned = ARENA_DEFAULT_ZONED;
+  Count zones = ARENA_DEFAULT_ZONES;
   Size commitLimit = ARENA_DEFAULT_COMMIT_LIMIT;
   Size spareCommitLimit = ARENA_DEFAULT_SPARE_COMMIT_LIMIT;
+  double spareDecay = ARENA_DEFAULT_SPARE_DECAY;
   double pauseTime = ARENA_DEFAULT_PAUSE_TIME;
+  Bool background = ARENA_DEFAULT_BACKGROUND;
+  Index i;
   mps_arg_s arg;
 
   AVER(arena != NULL);
@@ -232,12 +258,24 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   
   if (ArgPick(&arg, args, MPS_KEY_ARENA_ZONED))
     zoned = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_ZONES)) {
+    zones = arg.val.count;
+    /* See <design/arena/#zone.fine>. */
+    if (!SizeIsP2((Size)zones) || zones < MPS_WORD_WIDTH
+        || zones > (Count)MPS_WORD_WIDTH * MPS_WORD_WIDTH)
+      return ResPARAM;
+  }
   if (ArgPick(&arg, args, MPS_KEY_COMMIT_LIMIT))
     commitLimit = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_SPARE_COMMIT_LIMIT))
     spareCommitLimit = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_SPARE_DECAY))
+    spareDecay = arg.val.d;
+  AVER(0.0 <= spareDecay);
   if (ArgPick(&arg, args, MPS_KEY_PAUSE_TIME))
     pauseTime = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_BACKGROUND))
+    background = arg.val.b;
 
   /* Superclass init */
   InstInit(CouldBeA(Inst, arena));
@@ -247,20 +285,37 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->commitLimit = commitLimit;
   arena->spareCommitted = (Size)0;
   arena->spareCommitLimit = spareCommitLimit;
+  arena->spareDecay = spareDecay;
+  arena->spareDecayLast = ClockNow();
+  arena->purgeCount = 0;
+  arena->purgeTime = 0;
+  arena->purgeTimeMax = 0;
   arena->pauseTime = pauseTime;
+  arena->backgroundWanted = BOOLOF(background);
+  arena->background = NULL;
+  arena->pressure = NULL;
   arena->grainSize = grainSize;
+  arena->nodes = 1; /* may be overridden by arena class init */
   /* zoneShift must be overridden by arena class init */
   arena->zoneShift = ZoneShiftUNSET;
+  arena->zoneFineBits = SizeLog2((Size)zones) - MPS_WORD_SHIFT;
+  arena->fineZoneShift = ZoneShiftUNSET;
   arena->poolReady = FALSE;     /* <design/arena/#pool.ready> */
   arena->lastTract = NULL;
   arena->lastTractBase = NULL;
   arena->hasFreeLand = FALSE;
   arena->freeZones = ZoneSetUNIV;
+  for (i = 0; i < NELEMS(arena->zoneAllocated); ++i)
+    arena->zoneAllocated[i] = 0;
   arena->zoned = zoned;
 
   arena->primary = NULL;
   RingInit(ArenaChunkRing(arena));
   arena->chunkTree = TreeEMPTY;
+  arena->chunkMapBase = (Addr)0;
+  arena->chunkMapShift = ChunkMapMinSHIFT;
+  for (i = 0; i < ChunkMapLENGTH; ++i)
+    arena->chunkMap[i] = NULL;
   arena->chunkSerial = (Serial)0;
   
   LocusInit(arena);
@@ -308,6 +363,8 @@ failGlobalsInit:
  * exist on all platforms. */
 
 ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
+ARG_DEFINE_KEY(ARENA_HUGE_PAGES, Bool);
+ARG_DEFINE_KEY(ARENA_NUMA_NODES, Count);
 
 
 /* ArenaCreate -- create the arena and call initializers */
@@ -315,9 +372,13 @@ ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
 ARG_DEFINE_KEY(ARENA_GRAIN_SIZE, Size);
 ARG_DEFINE_KEY(ARENA_SIZE, Size);
 ARG_DEFINE_KEY(ARENA_ZONED, Bool);
+ARG_DEFINE_KEY(ARENA_ZONES, Count);
 ARG_DEFINE_KEY(COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(SPARE_COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(PAUSE_TIME, double);
+ARG_DEFINE_KEY(ARENA_BACKGROUND, Bool);
+ARG_DEFINE_KEY(ARENA_PRESSURE_PATH, String);
+ARG_DEFINE_KEY(ARENA_SPARE_DECAY, double);
 
 static Res arenaFreeLandInit(Arena arena)
 {
@@ -359,6 +420,7 @@ failLandInit:
 Res ArenaCreate(Arena *arenaReturn, ArenaClass klass, ArgList args)
 {
   Arena arena;
+  ArgStruct arg;
   Res res;
 
   AVER(arenaReturn != NULL);
@@ -377,6 +439,13 @@ Res ArenaCreate(Arena *arenaReturn, ArenaClass klass, ArgList args)
   /* Zone shift must have been set up by klass->create() */
   AVER(ShiftCheck(arena->zoneShift));
 
+  /* Each zone divides into 2^zoneFineBits fine zones, each no smaller
+     than a byte.  See <design/arena/#zone.fine>. */
+  if (arena->zoneShift > arena->zoneFineBits)
+    arena->fineZoneShift = arena->zoneShift - arena->zoneFineBits;
+  else
+    arena->fineZoneShift = 0;
+
   /* TODO: Consider how each of the stages below could be incorporated
      into arena initialization, rather than tacked on here. */
 
@@ -398,10 +467,30 @@ Res ArenaCreate(Arena *arenaReturn, ArenaClass klass, ArgList args)
   if (res != ResOK)
     goto failGlobalsCompleteCreate;
 
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_PRESSURE_PATH)) {
+    res = ArenaPressureStart(arena, arg.val.string);
+    if (res != ResOK)
+      goto failPressureStart;
+  }
+
+  if (arena->backgroundWanted) {
+    res = ArenaBackgroundStart(arena);
+    if (res != ResOK)
+      goto failBackgroundStart;
+  }
+
   AVERT(Arena, arena);
   *arenaReturn = arena;
   return ResOK;
 
+failBackgroundStart:
+failPressureStart:
+  GlobalsPrepareToDestroy(ArenaGlobals(arena));
+  ControlFinish(arena);
+  arenaFreeLandFinish(arena);
+  klass->destroy(arena);
+  return res;
+
 failGlobalsCompleteCreate:
   ControlFinish(arena);
 failControlInit:
@@ -542,13 +631,23 @@ static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "commitLimit      $W\n", (WriteFW)arena->commitLimit,
                "spareCommitted   $W\n", (WriteFW)arena->spareCommitted,
                "spareCommitLimit $W\n", (WriteFW)arena->spareCommitLimit,
+               "purgeCount       $U\n", (WriteFU)arena->purgeCount,
+               "purgeTime        $W\n", (WriteFW)arena->purgeTime,
+               "purgeTimeMax     $W\n", (WriteFW)arena->purgeTimeMax,
+               "background       $P\n", (WriteFP)arena->background,
+               "pressure         $P\n", (WriteFP)arena->pressure,
                "zoneShift        $U\n", (WriteFU)arena->zoneShift,
+               "fineZoneShift    $U\n", (WriteFU)arena->fineZoneShift,
                "grainSize        $W\n", (WriteFW)arena->grainSize,
+               "nodes            $U\n", (WriteFU)arena->nodes,
                "lastTract        $P\n", (WriteFP)arena->lastTract,
                "lastTractBase    $P\n", (WriteFP)arena->lastTractBase,
                "primary          $P\n", (WriteFP)arena->primary,
                "hasFreeLand      $S\n", WriteFYesNo(arena->hasFreeLand),
                "freeZones        $B\n", (WriteFB)arena->freeZones,
+               "sharedZones      $B\n", (WriteFB)arena->sharedZones,
+               "usedFineZones    $B\n", (WriteFB)arena->usedFineZones,
+               "ambigBlacklist   $B\n", (WriteFB)arena->ambigBlacklist,
                "zoned            $S\n", WriteFYesNo(arena->zoned),
                NULL);
   if (res != ResOK)
@@ -707,6 +806,77 @@ Res ControlDescribe(Arena arena, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* arenaChunkMapAdd -- point chunk map entries at a chunk
+ *
+ * Sets each entry of the chunk map that covers some of the chunk's
+ * address space to point to the chunk.  If replace is FALSE, only
+ * empty entries are set; otherwise any chunk that was there is
+ * replaced.  The chunk must be covered by the map.  See
+ * <design/arena/#chunk.map>.
+ */
+
+static void arenaChunkMapAdd(Arena arena, Chunk chunk, Bool replace)
+{
+  Word i, first, last;
+
+  first = ChunkMapIndex(arena, chunk->base);
+  last = ChunkMapIndex(arena, AddrSub(chunk->limit, 1));
+  AVER(first <= last);
+  AVER(last < ChunkMapLENGTH);
+  for (i = first; i <= last; ++i)
+    if (replace || arena->chunkMap[i] == NULL)
+      arena->chunkMap[i] = chunk;
+}
+
+
+/* arenaChunkMapCovers -- is a chunk covered by the chunk map? */
+
+static Bool arenaChunkMapCovers(Arena arena, Chunk chunk)
+{
+  return chunk->base >= arena->chunkMapBase
+    && ChunkMapIndex(arena, AddrSub(chunk->limit, 1)) < ChunkMapLENGTH;
+}
+
+
+/* arenaChunkMapRebuild -- cover all the chunks with the chunk map
+ *
+ * Chooses the smallest entry size that lets the map cover the address
+ * space from the lowest chunk base to the highest chunk limit, and
+ * then adds every chunk.  See <design/arena/#chunk.map.size>.
+ */
+
+static void arenaChunkMapRebuild(Arena arena)
+{
+  Ring node, next;
+  Word low = (Word)-1, high = 0;
+  Shift shift;
+  Index i;
+
+  RING_FOR(node, ArenaChunkRing(arena), next) {
+    Chunk chunk = RING_ELT(Chunk, arenaRing, node);
+    if ((Word)chunk->base < low)
+      low = (Word)chunk->base;
+    if ((Word)chunk->limit - 1 > high)
+      high = (Word)chunk->limit - 1;
+  }
+  AVER(low <= high);
+
+  shift = ChunkMapMinSHIFT;
+  while ((high - WordAlignDown(low, (Word)1 << shift)) >> shift
+         >= ChunkMapLENGTH)
+    ++shift;
+  arena->chunkMapBase = (Addr)WordAlignDown(low, (Word)1 << shift);
+  arena->chunkMapShift = shift;
+
+  for (i = 0; i < ChunkMapLENGTH; ++i)
+    arena->chunkMap[i] = NULL;
+  RING_FOR(node, ArenaChunkRing(arena), next) {
+    Chunk chunk = RING_ELT(Chunk, arenaRing, node);
+    arenaChunkMapAdd(arena, chunk, TRUE);
+  }
+}
+
+
 /* ArenaChunkInsert -- insert chunk into arena's chunk tree and ring,
  * update the total reserved address space, and set the primary chunk
  * if not already set.
@@ -727,6 +897,10 @@ void ArenaChunkInsert(Arena arena, Chunk chunk) {
   TreeBalance(&updatedTree);
   arena->chunkTree = updatedTree;
   RingAppend(ArenaChunkRing(arena), &chunk->arenaRing);
+  if (arenaChunkMapCovers(arena, chunk))
+    arenaChunkMapAdd(arena, chunk, TRUE);
+  else
+    arenaChunkMapRebuild(arena);
 
   arena->reserved += ChunkReserved(chunk);
 
@@ -745,10 +919,30 @@ void ArenaChunkInsert(Arena arena, Chunk chunk) {
 void ArenaChunkRemoved(Arena arena, Chunk chunk)
 {
   Size size;
+  Word i, first, last;
+  Ring node, next;
 
   AVERT(Arena, arena);
   AVERT(Chunk, chunk);
 
+  /* Remove the chunk from the chunk map, and give the entries it
+     shared to the other chunks that overlap them.  The chunk is still
+     on the ring, but the tree may be being traversed.  See
+     <design/arena/#chunk.map.maintain>. */
+  AVER(arenaChunkMapCovers(arena, chunk));
+  first = ChunkMapIndex(arena, chunk->base);
+  last = ChunkMapIndex(arena, AddrSub(chunk->limit, 1));
+  for (i = first; i <= last; ++i)
+    if (arena->chunkMap[i] == chunk)
+      arena->chunkMap[i] = NULL;
+  RING_FOR(node, ArenaChunkRing(arena), next) {
+    Chunk other = RING_ELT(Chunk, arenaRing, node);
+    if (other != chunk
+        && ChunkMapIndex(arena, other->base) <= last
+        && ChunkMapIndex(arena, AddrSub(other->limit, 1)) >= first)
+      arenaChunkMapAdd(arena, other, FALSE);
+  }
+
   size = ChunkReserved(chunk);
   AVER(arena->reserved >= size);
   arena->reserved -= size;
@@ -1014,24 +1208,79 @@ void ArenaFreeLandDelete(Arena arena, Addr base, Addr limit)
 }
 
 
-/* ArenaFreeLandAlloc -- allocate a continguous range of tracts of
+/* arenaAllocRange -- make memory available in a range of address
+ * space just deleted from the free land
+ *
+ * oldRange is the block of the free land that contained range, so
+ * that the range can be put back if there's no memory for it.
+ */
+
+static Res arenaAllocRange(Tract *tractReturn, Arena arena, Range range,
+                           Range oldRange, Pool pool)
+{
+  Chunk chunk = NULL; /* suppress uninit warning */
+  Bool b;
+  Index baseIndex;
+  Count pages;
+  ZoneSet usedZones;
+  Res res;
+
+  b = ChunkOfAddr(&chunk, arena, RangeBase(range));
+  AVER(b);
+  AVER(RangeIsAligned(range, ChunkPageSize(chunk)));
+  baseIndex = INDEX_OF_ADDR(chunk, RangeBase(range));
+  pages = ChunkSizeToPages(chunk, RangeSize(range));
+
+  res = Method(Arena, arena, pagesMarkAllocated)(arena, chunk, baseIndex, pages, pool);
+  if (res != ResOK)
+    goto failMark;
+
+  /* See <design/arena/#zone.recycle>. */
+  usedZones = ZoneSizeAdd(arena->zoneAllocated, arena,
+                          RangeBase(range), RangeLimit(range));
+  if (usedZones != ZoneSetEMPTY) {
+    arena->freeZones = ZoneSetDiff(arena->freeZones, usedZones);
+    EVENT2(ArenaUseFreeZone, arena, usedZones);
+  }
+
+  *tractReturn = PageTract(ChunkPage(chunk, baseIndex));
+  return ResOK;
+
+failMark:
+   {
+     Res insertRes = arenaFreeLandInsertExtend(oldRange, arena, range);
+     AVER(insertRes == ResOK); /* We only just deleted it. */
+     /* If the insert does fail, we lose some address space permanently. */
+   }
+   return res;
+}
+
+
+/* ArenaFreeLandAllocFine -- allocate a continguous range of tracts of
  * size bytes from the arena's free land.
  *
- * size, zones, and high are as for LandFindInZones.
+ * size, zones, fineZones, and high are as for LandFindInZones.
  *
  * If successful, mark the allocated tracts as belonging to pool, set
  * *tractReturn to point to the first tract in the range, and return
  * ResOK.
+ *
+ * ArenaFreeLandAlloc is the same, with no preference for fine zones.
  */
 
 Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
                        Bool high, Size size, Pool pool)
+{
+  return ArenaFreeLandAllocFine(tractReturn, arena, zones, ZoneSetUNIV,
+                                high, size, pool);
+}
+
+Res ArenaFreeLandAllocFine(Tract *tractReturn, Arena arena,
+                           ZoneSet zones, ZoneSet fineZones,
+                           Bool high, Size size, Pool pool)
 {
   RangeStruct range, oldRange;
-  Chunk chunk = NULL; /* suppress uninit warning */
-  Bool found, b;
-  Index baseIndex;
-  Count pages;
+  Bool found;
   Res res;
   
   AVER(tractReturn != NULL);
@@ -1042,13 +1291,15 @@ Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
   AVER(arena == PoolArena(pool));
   AVER(SizeIsArenaGrains(size, arena));
   
-  if (!arena->zoned)
+  if (!arena->zoned) {
     zones = ZoneSetUNIV;
+    fineZones = ZoneSetUNIV;
+  }
 
   /* Step 1. Find a range of address space. */
   
   res = LandFindInZones(&found, &range, &oldRange, ArenaFreeLand(arena),
-                        size, zones, high);
+                        size, zones, fineZones, high);
 
   if (res == ResLIMIT) { /* found block, but couldn't store info */
     RangeStruct pageRange;
@@ -1057,7 +1308,7 @@ Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
       return res;
     arenaExcludePage(arena, &pageRange);
     res = LandFindInZones(&found, &range, &oldRange, ArenaFreeLand(arena),
-                          size, zones, high);
+                          size, zones, fineZones, high);
     AVER(res != ResLIMIT);
   }
 
@@ -1070,31 +1321,7 @@ Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
   
   /* Step 2. Make memory available in the address space range. */
 
-  b = ChunkOfAddr(&chunk, arena, RangeBase(&range));
-  AVER(b);
-  AVER(RangeIsAligned(&range, ChunkPageSize(chunk)));
-  baseIndex = INDEX_OF_ADDR(chunk, RangeBase(&range));
-  pages = ChunkSizeToPages(chunk, RangeSize(&range));
-
-  res = Method(Arena, arena, pagesMarkAllocated)(arena, chunk, baseIndex, pages, pool);
-  if (res != ResOK)
-    goto failMark;
-
-  arena->freeZones = ZoneSetDiff(arena->freeZones,
-                                 ZoneSetOfRange(arena,
-                                                RangeBase(&range),
-                                                RangeLimit(&range)));
-
-  *tractReturn = PageTract(ChunkPage(chunk, baseIndex));
-  return ResOK;
-
-failMark:
-   {
-     Res insertRes = arenaFreeLandInsertExtend(&oldRange, arena, &range);
-     AVER(insertRes == ResOK); /* We only just deleted it. */
-     /* If the insert does fail, we lose some address space permanently. */
-   }
-   return res;
+  return arenaAllocRange(tractReturn, arena, &range, &oldRange, pool);
 }
 
 
@@ -1146,6 +1373,7 @@ void ArenaFree(Addr base, Size size, Pool pool)
   Addr wholeBase;
   Size wholeSize;
   RangeStruct range, oldRange;
+  ZoneSet freedZones;
 
   AVERT(Pool, pool);
   AVER(base != NULL);
@@ -1165,6 +1393,14 @@ void ArenaFree(Addr base, Size size, Pool pool)
   wholeBase = base;
   wholeSize = size;
 
+  /* Zones with nothing left in them are free again.  See
+     <design/arena/#zone.recycle>. */
+  freedZones = ZoneSizeSub(arena->zoneAllocated, arena, base, limit);
+  if (freedZones != ZoneSetEMPTY) {
+    arena->freeZones = ZoneSetUnion(arena->freeZones, freedZones);
+    EVENT2(ArenaFreeZone, arena, freedZones);
+  }
+
   RangeInit(&range, base, limit);
 
   arenaFreeLandInsertSteal(&oldRange, arena, &range); /* may update range */
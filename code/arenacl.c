@@ -436,6 +436,7 @@ static void ClientArenaFree(Addr base, Size size, Pool pool)
 
   AVER(BTIsSetRange(chunk->allocTable, baseIndex, limitIndex));
   BTResRange(chunk->allocTable, baseIndex, limitIndex);
+  ChunkSetColourRange(chunk, baseIndex, limitIndex, PageColourFREE);
 
   AVER(arena->committed >= size);
   arena->committed -= size;
@@ -20,6 +20,7 @@
 #include "mpslib.h"
 #include "mpsavm.h"
 #include "mpsacl.h"
+#include "mpscmvff.h"
 
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* malloc */
@@ -402,6 +403,71 @@ static void testAllocAndIterate(Arena arena, Pool pool,
 }
 
 
+/* testZoneRecycle -- check that zones are free again once emptied
+ *
+ * See <design/arena/#zone.recycle>.  Some free zones may be entirely
+ * taken up by the chunk's own tables, so try each of them in turn.
+ */
+
+static void testZoneRecycle(Arena arena, Pool pool)
+{
+  Size size = ArenaGrainSize(arena);
+  Count recycled = 0;
+  Index z;
+
+  for (z = 0; z < MPS_WORD_WIDTH; ++z) {
+    LocusPrefStruct pref;
+    ZoneSet zone = (ZoneSet)1 << z;
+    Addr base;
+
+    if (!ZoneSetIsMember(arena->freeZones, z))
+      continue;
+    LocusPrefInit(&pref);
+    LocusPrefExpress(&pref, LocusPrefZONESET, &zone);
+    die(ArenaAlloc(&base, &pref, size, pool), "ArenaAlloc");
+    if (ZoneSetHasAddr(arena, zone, base)) {
+      cdie(!ZoneSetIsMember(arena->freeZones, z), "zone in use");
+      ArenaFree(base, size, pool);
+      cdie(ZoneSetIsMember(arena->freeZones, z), "zone recycled");
+      ++recycled;
+    } else {
+      ArenaFree(base, size, pool);
+    }
+  }
+  printf("%lu zones recycled.\n", (unsigned long)recycled);
+  cdie(recycled > 0, "no zones recycled");
+}
+
+
+/* testLargeFree -- check that a large range is unmapped when freed
+ *
+ * See <design/arena/#large.free>.
+ */
+
+static void testLargeFree(Arena arena, Pool pool)
+{
+  Size size = SizeArenaGrains(4 * ARENA_LARGE_SIZE, arena);
+  LocusPrefStruct pref;
+  Addr base;
+  Size limit, committed;
+
+  LocusPrefInit(&pref);
+
+  /* With no room for spare pages, a large range is returned to the
+     operating system as soon as it is freed. */
+  limit = ArenaSpareCommitLimit(arena);
+  ArenaSetSpareCommitLimit(arena, 0);
+  committed = ArenaCommitted(arena);
+  die(ArenaAlloc(&base, &pref, size, pool), "ArenaAlloc");
+  ArenaFree(base, size, pool);
+  cdie(ArenaCommitted(arena) <= committed, "large free unmapped");
+  die(ArenaAlloc(&base, &pref, size, pool), "ArenaAlloc");
+  ArenaFree(base, size, pool);
+  cdie(ArenaCommitted(arena) <= committed, "large free unmapped again");
+  ArenaSetSpareCommitLimit(arena, limit);
+}
+
+
 static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
 {
   Arena arena; Pool pool;
@@ -429,6 +495,11 @@ static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
   testAllocAndIterate(arena, pool, pageSize, tractsPerPage,
                       &allocatorSegStruct);
 
+  if (zoned)
+    testZoneRecycle(arena, pool);
+
+  testLargeFree(arena, pool);
+
   die(ArenaDescribe(arena, mps_lib_get_stdout(), 0), "ArenaDescribe");
   die(ArenaDescribeTracts(arena, mps_lib_get_stdout(), 0),
       "ArenaDescribeTracts");
@@ -438,6 +509,92 @@ static void testPageTable(ArenaClass klass, Size size, Addr addr, Bool zoned)
 }
 
 
+#define TEST_ARENA_SIZE              ((Size)16<<22)
+
+
+/* testNodes -- check that NUMA node preferences are honoured
+ *
+ * Fake a topology of several nodes (binding memory to nodes that
+ * don't exist fails harmlessly) and check that allocations preferring
+ * a node land in that node's zones, whether the preference comes from
+ * the locus or from the pool.  See <design/arena/#numa>.
+ */
+
+#define testNodesCOUNT 4
+
+static void testNodes(void)
+{
+  ArenaClass klass = (ArenaClass)mps_arena_class_vm();
+  Arena arena;
+  Pool pool;
+  Buffer buffer;
+  Size size;
+  Addr base;
+  Index node;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_NUMA_NODES, 0);
+    die(ArenaCreate(&arena, klass, args), "ArenaCreate");
+  } MPS_ARGS_END(args);
+  printf("%lu NUMA nodes detected.\n", (unsigned long)arena->nodes);
+  cdie(arena->nodes >= 1, "nodes detected");
+  ArenaDestroy(arena);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, TEST_ARENA_SIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_NUMA_NODES, testNodesCOUNT);
+    die(ArenaCreate(&arena, klass, args), "ArenaCreate");
+  } MPS_ARGS_END(args);
+  cdie(arena->nodes == testNodesCOUNT, "nodes");
+  size = ArenaGrainSize(arena);
+
+  die(PoolCreate(&pool, arena, PoolClassMV(), argsNone), "PoolCreate");
+  for (node = 0; node < testNodesCOUNT; ++node) {
+    LocusPrefStruct pref;
+    LocusPrefInit(&pref);
+    LocusPrefExpress(&pref, LocusPrefNODE, &node);
+    die(ArenaAlloc(&base, &pref, size, pool), "ArenaAlloc");
+    cdie(ZoneSetHasAddr(arena, ZoneSetOfNode(arena, node), base),
+         "locus node");
+    ArenaFree(base, size, pool);
+  }
+  PoolDestroy(pool);
+
+  node = testNodesCOUNT - 1;
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_NUMA_NODE, node);
+    die(PoolCreate(&pool, arena, PoolClassMV(), args), "PoolCreate");
+  } MPS_ARGS_END(args);
+  die(ArenaAlloc(&base, LocusPrefDefault(), size, pool), "ArenaAlloc");
+  cdie(ZoneSetHasAddr(arena, ZoneSetOfNode(arena, node), base),
+       "pool node");
+  ArenaFree(base, size, pool);
+  PoolDestroy(pool);
+
+  /* An allocation point's node overrides the pool's for its fills,
+     without changing the pool's. */
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_NUMA_NODE, node);
+    die(PoolCreate(&pool, arena, (PoolClass)mps_class_mvff(), args),
+        "PoolCreate");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_NUMA_NODE, 0);
+    die(BufferCreate(&buffer, PoolDefaultBufferClass(pool), pool, TRUE,
+                     args), "BufferCreate");
+  } MPS_ARGS_END(args);
+  die(BufferReserve(&base, buffer, size), "BufferReserve");
+  cdie(ZoneSetHasAddr(arena, ZoneSetOfNode(arena, 0), base),
+       "buffer node");
+  cdie(pool->node == node, "pool node kept");
+  (void)BufferCommit(buffer, base, size);
+  BufferDestroy(buffer);
+  PoolDestroy(pool);
+
+  ArenaDestroy(arena);
+}
+
+
 /* testSize -- test arena size overflow
  *
  * Just try allocating larger arenas, doubling the size each time, until
@@ -464,7 +621,6 @@ static void testSize(Size size)
 }
 
 
-#define TEST_ARENA_SIZE              ((Size)16<<22)
 
 
 int main(int argc, char *argv[])
@@ -475,6 +631,7 @@ int main(int argc, char *argv[])
 
   testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0, TRUE);
   testPageTable((ArenaClass)mps_arena_class_vm(), TEST_ARENA_SIZE, 0, FALSE);
+  testNodes();
 
   block = malloc(TEST_ARENA_SIZE);
   cdie(block != NULL, "malloc");
@@ -45,6 +45,8 @@ typedef struct VMChunkStruct {
   VMStruct vmStruct;            /* virtual memory descriptor */
   Addr overheadMappedLimit;     /* limit of pages mapped for overhead */
   SparseArrayStruct pages;      /* to manage backing store of page table */
+  BT hugeAdvised;               /* runs with current huge page advice */
+  BT hugeRefused;               /* runs that have held scanned pages */
   Sig sig;                      /* <design/sig/> */
 } VMChunkStruct;
 
@@ -59,6 +61,29 @@ typedef struct VMChunkStruct {
   MustBeA(VMArena, ChunkArena(VMChunk2Chunk(vmchunk)))
 
 
+/* saPagesLength -- length of a chunk's sparse array 'pages' table
+ *
+ * The table has a bit for each VM page occupied by the page table, and
+ * the grain may be larger than the VM page.  See .overhead.sa-pages.
+ */
+
+#define saPagesLength(pageTableSize, vmPageSize) \
+  ((Count)((pageTableSize) / (vmPageSize)))
+
+
+/* hugeRuns -- number of huge page runs in a chunk of a given size
+ * hugeRunOfPage -- index of the huge page run containing a page
+ *
+ * See <design/arena/#huge.run>.
+ */
+
+#define hugeRuns(size) \
+  ((Count)(SizeAlignUp(size, VM_HUGE_PAGE_SIZE) / VM_HUGE_PAGE_SIZE))
+#define hugeRunOfPage(chunk, pi) \
+  ((Index)(AddrOffset((chunk)->base, PageIndexBase(chunk, pi)) \
+           / VM_HUGE_PAGE_SIZE))
+
+
 /* VMArena
  *
  * See <design/arena/#coop-vm.struct.vmarena> for description.
@@ -112,7 +137,15 @@ static Bool VMChunkCheck(VMChunk vmchunk)
   CHECKL(AddrAdd(vmchunk->pages.mapped, BTSize(chunk->pages)) <=
          vmchunk->overheadMappedLimit);
   CHECKL(chunk->base < (Addr)vmchunk->pages.pages);
-  CHECKL(AddrAdd(vmchunk->pages.pages, BTSize(chunk->pageTablePages)) <=
+  CHECKL(AddrAdd(vmchunk->pages.pages,
+                 BTSize(saPagesLength(chunk->pageTablePages << chunk->pageShift,
+                                      VMPageSize(VMChunkVM(vmchunk))))) <=
+         vmchunk->overheadMappedLimit);
+  CHECKL(chunk->base < (Addr)vmchunk->hugeAdvised);
+  CHECKL(AddrAdd(vmchunk->hugeAdvised, BTSize(hugeRuns(ChunkSize(chunk)))) <=
+         vmchunk->overheadMappedLimit);
+  CHECKL(chunk->base < (Addr)vmchunk->hugeRefused);
+  CHECKL(AddrAdd(vmchunk->hugeRefused, BTSize(hugeRuns(ChunkSize(chunk)))) <=
          vmchunk->overheadMappedLimit);
   /* .improve.check-table: Could check the consistency of the tables. */
   
@@ -240,6 +273,24 @@ static Res vmArenaMap(VMArena vmArena, VM vm, Addr base, Addr limit)
   if (res != ResOK)
     return res;
   arena->committed += size;
+
+  /* .map.bind: Mapping afresh loses the memory policy, so bind each
+     zone stripe to the node of its zone.  The arena's first mappings
+     are made before the zone shift is known, but those hold only the
+     arena and chunk structures.  Binding is a hint, so failure (for
+     example, on a machine with fewer nodes than the arena was told
+     to use) is ignored.  See <design/arena/#numa>. */
+  if (arena->nodes > 1 && arena->zoneShift != ZoneShiftUNSET) {
+    Size stripe = (Size)1 << arena->zoneShift;
+    Addr addr = base;
+    while (addr < limit) {
+      Addr next = AddrAlignUp(AddrAdd(addr, 1), stripe);
+      if (next > limit || next < addr)
+        next = limit;
+      (void)VMBind(vm, addr, next, AddrZone(arena, addr) % arena->nodes);
+      addr = next;
+    }
+  }
   return ResOK;
 }
 
@@ -336,7 +387,7 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
   Addr overheadLimit;
   void *p;
   Res res;
-  BT saMapped, saPages;
+  BT saMapped, saPages, hugeAdvised, hugeRefused;
 
   /* chunk is supposed to be uninitialized, so don't check it. */
   vmChunk = Chunk2VMChunk(chunk);
@@ -349,10 +400,23 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
   saMapped = p;
   
   /* .overhead.sa-pages: Chunk overhead for sparse array 'pages' table. */
-  res = BootAlloc(&p, boot, BTSize(chunk->pageTablePages), MPS_PF_ALIGN);
+  res = BootAlloc(&p, boot,
+                  BTSize(saPagesLength(chunk->pageTablePages << chunk->pageShift,
+                                       VMPageSize(VMChunkVM(vmChunk)))),
+                  MPS_PF_ALIGN);
   if (res != ResOK)
     goto failSaPages;
   saPages = p;
+
+  /* .overhead.huge: Chunk overhead for the huge page advice tables. */
+  res = BootAlloc(&p, boot, BTSize(hugeRuns(ChunkSize(chunk))), MPS_PF_ALIGN);
+  if (res != ResOK)
+    goto failHugeAdvised;
+  hugeAdvised = p;
+  res = BootAlloc(&p, boot, BTSize(hugeRuns(ChunkSize(chunk))), MPS_PF_ALIGN);
+  if (res != ResOK)
+    goto failHugeRefused;
+  hugeRefused = p;
   
   overheadLimit = AddrAdd(chunk->base, (Size)BootAllocated(boot));
 
@@ -379,12 +443,19 @@ static Res VMChunkInit(Chunk chunk, BootBlock boot)
                   chunk->pages,
                   saMapped, saPages, VMChunkVM(vmChunk));
 
+  BTResRange(hugeAdvised, 0, hugeRuns(ChunkSize(chunk)));
+  BTResRange(hugeRefused, 0, hugeRuns(ChunkSize(chunk)));
+  vmChunk->hugeAdvised = hugeAdvised;
+  vmChunk->hugeRefused = hugeRefused;
+
   return ResOK;
 
   /* .no-clean: No clean-ups needed for boot, as we will discard the chunk. */
 failTableMap:
-failSaPages:
 failAllocPageTable:
+failHugeRefused:
+failHugeAdvised:
+failSaPages:
 failSaMapped:
   return res;
 }
@@ -489,7 +560,7 @@ static Res vmArenaChunkSize(Size *chunkSizeReturn, VMArena vmArena, Size size)
   Shift grainShift;             /* The corresponding Shift. */
   Count pages;                  /* Number of usable pages in chunk. */
   Size pageTableSize;           /* Size of the page table. */
-  Count pageTablePages;         /* Number of pages in the page table. */
+  Size vmPageSize;              /* Operating system page size. */
   Size chunkSize;               /* Size of the chunk. */
   Size overhead;                /* Total overheads for the chunk. */
 
@@ -499,6 +570,7 @@ static Res vmArenaChunkSize(Size *chunkSizeReturn, VMArena vmArena, Size size)
 
   grainSize = ArenaGrainSize(MustBeA(AbstractArena, vmArena));
   grainShift = SizeLog2(grainSize);
+  vmPageSize = VMPageSize(VMArenaVM(vmArena));
 
   overhead = 0;
   do {
@@ -512,13 +584,19 @@ static Res vmArenaChunkSize(Size *chunkSizeReturn, VMArena vmArena, Size size)
     pages = chunkSize >> grainShift;
     overhead += SizeAlignUp(BTSize(pages), MPS_PF_ALIGN);
 
+    /* See <code/tract.c#overhead.colour>. */
+    overhead += SizeAlignUp(pages * sizeof(PageColour), MPS_PF_ALIGN);
+
     /* See .overhead.sa-mapped. */
     overhead += SizeAlignUp(BTSize(pages), MPS_PF_ALIGN);
 
     /* See .overhead.sa-pages. */
     pageTableSize = SizeAlignUp(pages * sizeof(PageUnion), grainSize);
-    pageTablePages = pageTableSize >> grainShift;
-    overhead += SizeAlignUp(BTSize(pageTablePages), MPS_PF_ALIGN);
+    overhead += SizeAlignUp(BTSize(saPagesLength(pageTableSize, vmPageSize)),
+                            MPS_PF_ALIGN);
+
+    /* See .overhead.huge. */
+    overhead += 2 * SizeAlignUp(BTSize(hugeRuns(chunkSize)), MPS_PF_ALIGN);
 
     /* See .overhead.page-table. */
     overhead = SizeAlignUp(overhead, grainSize);
@@ -557,6 +635,7 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   VMStruct vmStruct;
   VM vm = &vmStruct;
   Chunk chunk;
+  Count nodes = ARENA_DEFAULT_NUMA_NODES;
   mps_arg_s arg;
   char vmParams[VMParamSize];
   
@@ -576,6 +655,14 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
     /* There has to be enough room in the chunk for a full complement of
        zones. Make it easier to write portable programs by rounding up. */
     size = grainSize * MPS_WORD_WIDTH;
+
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_NUMA_NODES))
+    nodes = arg.val.count;
+  if (nodes == 0)
+    nodes = NodeCount();
+  if (nodes > MPS_WORD_WIDTH)
+    /* Each node needs at least one zone. */
+    nodes = MPS_WORD_WIDTH;
   
   /* Parse remaining arguments, if any, into VM parameters. We must do
      this into some stack-allocated memory for the moment, since we
@@ -605,6 +692,7 @@ static Res VMArenaCreate(Arena *arenaReturn, ArgList args)
   
   arena->reserved = VMReserved(vm);
   arena->committed = VMMapped(vm);
+  arena->nodes = nodes;
 
   /* Copy VM descriptor into its place in the arena. */
   VMCopy(VMArenaVM(vmArena), vm);
@@ -835,6 +923,156 @@ static void pageDescUnmap(VMChunk vmChunk, Index basePI, Index limitPI)
 }
 
 
+/* pagesHugeMapped -- note that pages have been mapped
+ *
+ * Mapping pages discards the operating system's huge page advice for
+ * them, so the advice for the runs containing them is no longer
+ * current.  See <design/arena/#huge.run>.
+ */
+
+static void pagesHugeMapped(VMChunk vmChunk, Index basePI, Index limitPI)
+{
+  Chunk chunk = VMChunk2Chunk(vmChunk);
+  AVER(basePI < limitPI);
+  BTResRange(vmChunk->hugeAdvised, hugeRunOfPage(chunk, basePI),
+             hugeRunOfPage(chunk, limitPI - 1) + 1);
+}
+
+
+/* pagesAdviseHuge -- advise the OS on huge pages for allocated pages
+ *
+ * Segments of pools that don't scan are never protected by the shield,
+ * so they can be backed by huge pages.  Segments of other pools are
+ * protected a segment at a time, and each mprotect would split a huge
+ * page, so runs that hold them are advised against.  Only runs whose
+ * advice isn't current are advised.  See <design/arena/#huge.run>.
+ */
+
+static void pagesAdviseHuge(VMChunk vmChunk, Index basePI, Index limitPI,
+                            Pool pool)
+{
+  Chunk chunk = VMChunk2Chunk(vmChunk);
+  Bool scanned = Method(Pool, pool, scan) != PoolNoScan;
+  Index run, limitRun;
+
+  AVER(basePI < limitPI);
+
+  limitRun = hugeRunOfPage(chunk, limitPI - 1) + 1;
+  for (run = hugeRunOfPage(chunk, basePI); run < limitRun; ++run) {
+    if (scanned && !BTGet(vmChunk->hugeRefused, run)) {
+      BTSet(vmChunk->hugeRefused, run);
+      BTRes(vmChunk->hugeAdvised, run);
+    }
+    if (!BTGet(vmChunk->hugeAdvised, run)) {
+      Addr base = AddrAdd(chunk->base, run * VM_HUGE_PAGE_SIZE);
+      Addr limit = AddrAdd(base, VM_HUGE_PAGE_SIZE);
+      if (limit > chunk->limit)
+        limit = chunk->limit;
+      VMAdviseHuge(VMChunkVM(vmChunk), base, limit,
+                   !BTGet(vmChunk->hugeRefused, run));
+      BTSet(vmChunk->hugeAdvised, run);
+    }
+  }
+}
+
+
+/* pagesRemapSpare -- move spare pages into place for allocation
+ *
+ * Called by pagesMarkAllocated when mapping the unmapped pages from
+ * basePI to limitPI in vmChunk would exceed the commit limit.  Moves
+ * the oldest spare pages, from any chunk, into place with VMRemap, so
+ * that committed memory is reused rather than purged and then mapped
+ * again.  Spare pages from excludeBase to excludeLimit in vmChunk are
+ * about to be allocated where they are, so they are left alone.  On
+ * failure, any pages already moved are returned to the operating
+ * system.  See <design/arena/#spare.remap>.
+ */
+
+static Res pagesRemapSpare(VMChunk vmChunk, Index basePI, Index limitPI,
+                           Index excludeBase, Index excludeLimit)
+{
+  Chunk chunk = VMChunk2Chunk(vmChunk);
+  Arena arena = ChunkArena(chunk);
+  VMArena vmArena = VMChunkVMArena(vmChunk);
+  Index pi = basePI;
+  Ring node;
+  Res res = ResCOMMIT_LIMIT;
+
+  AVER(basePI < limitPI);
+  AVER(excludeBase <= basePI);
+  AVER(limitPI <= excludeLimit);
+
+  /* Mapping the page descriptors isn't checked against the commit
+     limit, so it may have been exceeded already. */
+  if (arena->committed > arena->commitLimit
+      || arena->spareCommitted < ChunkPagesToSize(chunk, limitPI - basePI))
+    return ResCOMMIT_LIMIT;
+
+  /* Remapping would carry pages into stripes belonging to other NUMA
+     nodes.  See <design/arena/#numa.remap>. */
+  if (arena->nodes > 1)
+    return ResCOMMIT_LIMIT;
+
+  /* As in arenaUnmapSpare, take the oldest spare pages first, and step
+     around the ring only past the pages that are left alone. */
+  node = &vmArena->spareRing;
+  while (RingNext(node) != &vmArena->spareRing && pi < limitPI) {
+    Ring next = RingNext(node);
+    Page page = PageOfSpareRing(next);
+    Chunk srcChunk = NULL; /* suppress uninit warning */
+    VMChunk srcVMChunk;
+    Index srcPI, srcBase, srcLimit, lo, hi, i;
+    Bool b;
+
+    b = ChunkOfAddr(&srcChunk, arena, (Addr)page);
+    AVER(b);
+    srcVMChunk = Chunk2VMChunk(srcChunk);
+    srcPI = (Index)(page - srcChunk->pageTable);
+    lo = 0;
+    hi = srcChunk->pages;
+    if (srcChunk == chunk) {
+      if (excludeBase <= srcPI && srcPI < excludeLimit) {
+        node = next;
+        continue;
+      }
+      if (srcPI < excludeBase)
+        hi = excludeBase;
+      else
+        lo = excludeLimit;
+    }
+
+    /* Take as long a run of spare pages around this one as needed. */
+    srcBase = srcPI;
+    srcLimit = srcPI + 1;
+    while (srcLimit - srcBase < limitPI - pi && srcLimit < hi
+           && pageState(srcVMChunk, srcLimit) == PageStateSPARE)
+      ++srcLimit;
+    while (srcLimit - srcBase < limitPI - pi && srcBase > lo
+           && pageState(srcVMChunk, srcBase - 1) == PageStateSPARE)
+      --srcBase;
+
+    res = VMRemap(VMChunkVM(vmChunk), PageIndexBase(chunk, pi),
+                  PageIndexBase(chunk, pi + (srcLimit - srcBase)),
+                  VMChunkVM(srcVMChunk), PageIndexBase(srcChunk, srcBase));
+    if (res != ResOK)
+      goto failRemap;
+    for (i = srcBase; i < srcLimit; ++i)
+      sparePageRelease(srcVMChunk, i);
+    pageDescUnmap(srcVMChunk, srcBase, srcLimit);
+    pi += srcLimit - srcBase;
+  }
+  if (pi == limitPI)
+    return ResOK;
+  res = ResCOMMIT_LIMIT;
+
+failRemap:
+  if (basePI < pi)
+    vmArenaUnmap(vmArena, VMChunkVM(vmChunk),
+                 PageIndexBase(chunk, basePI), PageIndexBase(chunk, pi));
+  return res;
+}
+
+
 /* pagesMarkAllocated -- Mark the pages allocated */
 
 static Res pagesMarkAllocated(VMArena vmArena, VMChunk vmChunk,
@@ -863,20 +1101,24 @@ static Res pagesMarkAllocated(VMArena vmArena, VMChunk vmChunk,
       goto failSAMap;
     res = vmArenaMap(vmArena, VMChunkVM(vmChunk),
                      PageIndexBase(chunk, j), PageIndexBase(chunk, k));
+    if (res == ResCOMMIT_LIMIT)
+      res = pagesRemapSpare(vmChunk, j, k, basePI, limitPI);
     if (res != ResOK)
       goto failVMMap;
+    pagesHugeMapped(vmChunk, j, k);
     for (i = j; i < k; ++i) {
       PageInit(chunk, i);
       PageAlloc(chunk, i, pool);
     }
     cursor = k;
     if (cursor == limitPI)
-      return ResOK;
+      break;
   }
   for (i = cursor; i < limitPI; ++i) {
     sparePageRelease(vmChunk, i);
     PageAlloc(chunk, i, pool);
   }
+  pagesAdviseHuge(vmChunk, basePI, limitPI, pool);
   return ResOK;
 
 failVMMap:
@@ -917,9 +1159,9 @@ static Res VMPagesMarkAllocated(Arena arena, Chunk chunk,
   while (res != ResOK) {
     /* Try purging spare pages in the hope that the OS will give them back
        at the new address.  Will eventually run out of spare pages, so this
-       loop will terminate. */
-    /* TODO: Investigate implementing VMRemap so that we can guarantee
-       success if we have enough spare pages. */
+       loop will terminate.  This is only needed if pagesRemapSpare
+       couldn't move spare pages into place, for example because the
+       platform has no VMRemap. */
     if (VMPurgeSpare(arena, pages * ChunkPageSize(chunk)) == 0)
       break;
     res = pagesMarkAllocated(vmArena,
@@ -1043,9 +1285,27 @@ static Size arenaUnmapSpare(Arena arena, Size size, Chunk filter)
   return purged;
 }
 
+/* VMPurgeSpare -- return spare pages to the OS
+ *
+ * Records the time taken, since purging happens with the arena lock
+ * held.  See <design/arena/#spare.decay>.
+ */
+
 static Size VMPurgeSpare(Arena arena, Size size)
 {
-  return arenaUnmapSpare(arena, size, NULL);
+  Clock start, time;
+  Size purged;
+
+  start = ClockNow();
+  purged = arenaUnmapSpare(arena, size, NULL);
+  if (purged > 0) {
+    time = ClockNow() - start;
+    ++arena->purgeCount;
+    arena->purgeTime += time;
+    if (time > arena->purgeTimeMax)
+      arena->purgeTimeMax = time;
+  }
+  return purged;
 }
 
 
@@ -1065,6 +1325,7 @@ static void VMFree(Addr base, Size size, Pool pool)
   Arena arena;
   VMArena vmArena;
   Chunk chunk = NULL;           /* suppress "may be used uninitialized" */
+  VMChunk vmChunk;
   Count pages;
   Index pi, piBase, piLimit;
   Bool foundChunk;
@@ -1081,6 +1342,7 @@ static void VMFree(Addr base, Size size, Pool pool)
 
   foundChunk = ChunkOfAddr(&chunk, arena, base);
   AVER(foundChunk);
+  vmChunk = Chunk2VMChunk(chunk);
 
   /* Calculate the number of pages in the region */
   pages = ChunkSizeToPages(chunk, size);
@@ -1089,6 +1351,22 @@ static void VMFree(Addr base, Size size, Pool pool)
   AVER(piBase < piLimit);
   AVER(piLimit <= chunk->pages);
 
+  /* A large span that won't fit among the spare pages goes straight
+     back to the OS, rather than each of its pages being made spare
+     only to be purged again below.  See <design/arena/#large.free>. */
+  if (size >= ARENA_LARGE_SIZE
+      && arena->spareCommitted + size > arena->spareCommitLimit) {
+    for (pi = piBase; pi < piLimit; ++pi) {
+      Tract tract = PageTract(ChunkPage(chunk, pi));
+      AVER(TractPool(tract) == pool);
+      TractFinish(tract);
+      PageFree(chunk, pi);
+    }
+    vmArenaUnmap(vmArena, VMChunkVM(vmChunk), base, AddrAdd(base, size));
+    pageDescUnmap(vmChunk, piBase, piLimit);
+    return;
+  }
+
   /* loop from pageBase to pageLimit-1 inclusive */
   /* Finish each Tract found, then convert them to spare pages. */
   for(pi = piBase; pi < piLimit; ++pi) {
@@ -1106,6 +1384,7 @@ static void VMFree(Addr base, Size size, Pool pool)
   }
   arena->spareCommitted += ChunkPagesToSize(chunk, piLimit - piBase);
   BTResRange(chunk->allocTable, piBase, piLimit);
+  ChunkSetColourRange(chunk, piBase, piLimit, PageColourFREE);
 
   /* Consider returning memory to the OS. */
   /* TODO: Chunks are only destroyed when ArenaCompact is called, and
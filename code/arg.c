@@ -81,6 +81,11 @@ Bool ArgCheckPointer(Arg arg) {
   return TRUE;
 }
 
+Bool ArgCheckString(Arg arg) {
+  CHECKL(arg->val.string != NULL);
+  return TRUE;
+}
+
 Bool ArgCheckRankSet(Arg arg) {
   CHECKL(COMPATTYPE(RankSet, unsigned));
   CHECKL(RankSetCheck(arg->val.u));
@@ -52,6 +52,7 @@ extern Bool ArgCheckAlign(Arg arg);
 extern Bool ArgCheckBool(Arg arg);
 extern Bool ArgCheckCount(Arg arg);
 extern Bool ArgCheckPointer(Arg arg);
+extern Bool ArgCheckString(Arg arg);
 extern Bool ArgCheckRankSet(Arg arg);
 extern Bool ArgCheckRank(Arg arg);
 extern Bool ArgCheckdouble(Arg arg);
@@ -0,0 +1,108 @@
+/* bg.h: BACKGROUND COLLECTOR THREAD
+ *
+ *  $Id$
+ *  Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ *  .purpose: Provides a thread that does collection work for an
+ *  arena, so that the mutator threads don't have to.  See
+ *  <design/arena/#background>.  The thread itself is platform
+ *  specific (see bgix.c, bgw3.c, bgan.c); the work it does is in
+ *  ArenaBackgroundStep in global.c.
+ */
+
+#ifndef bg_h
+#define bg_h
+
+#include "mpmtypes.h"
+
+
+#define BackgroundSig   ((Sig)0x519BA6C0) /* SIGnature BAckGround COllector */
+
+
+/* BackgroundSize -- return the size of a BackgroundStruct
+ *
+ * Supports allocation of background threads in the control pool.
+ */
+
+extern size_t BackgroundSize(void);
+
+extern Bool BackgroundCheck(Background bg);
+
+
+/* BackgroundInit -- start a background thread for an arena
+ *
+ * Starts a thread that calls ArenaBackgroundStep on the arena
+ * repeatedly until BackgroundStop is called.  Returns ResUNIMPL on
+ * platforms where the MPS can't create threads.
+ */
+
+extern Res BackgroundInit(Background bg, Arena arena);
+
+
+/* BackgroundWake -- ask the background thread to look for work now
+ *
+ * Called by ArenaPoll, so that the thread doesn't sleep through a
+ * burst of allocation.  Doesn't wait for the thread.
+ */
+
+extern void BackgroundWake(Background bg);
+
+
+/* BackgroundStop -- stop the background thread
+ *
+ * Asks the thread to stop and waits for it to do so.  This must not
+ * be called while holding the arena lock, since the thread may be
+ * waiting for it.
+ */
+
+extern void BackgroundStop(Background bg);
+
+
+/* BackgroundFinish -- finish a stopped background thread */
+
+extern void BackgroundFinish(Background bg);
+
+
+#endif /* bg_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
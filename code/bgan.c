@@ -0,0 +1,106 @@
+/* bgan.c: BACKGROUND COLLECTOR THREAD FOR ANSI
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Standard C has no threads, so this implementation can't
+ * start a background thread.  BackgroundInit fails, and so creating
+ * an arena with MPS_KEY_ARENA_BACKGROUND set to true fails with
+ * MPS_RES_UNIMPL.  See <design/arena/#background>.
+ */
+
+#include "bg.h"
+#include "mpm.h"
+
+SRCID(bgan, "$Id$");
+
+
+typedef struct BackgroundStruct {
+  Sig sig;                      /* <design/sig/> */
+} BackgroundStruct;
+
+
+size_t (BackgroundSize)(void)
+{
+  return sizeof(BackgroundStruct);
+}
+
+
+Bool (BackgroundCheck)(Background bg)
+{
+  CHECKS(Background, bg);
+  return TRUE;
+}
+
+
+Res (BackgroundInit)(Background bg, Arena arena)
+{
+  AVER(bg != NULL);
+  AVER(TESTT(Arena, arena));
+  UNUSED(bg);
+  UNUSED(arena);
+  return ResUNIMPL;
+}
+
+
+void (BackgroundWake)(Background bg)
+{
+  AVERT(Background, bg);
+  NOTREACHED;
+}
+
+
+void (BackgroundStop)(Background bg)
+{
+  AVERT(Background, bg);
+  NOTREACHED;
+}
+
+
+void (BackgroundFinish)(Background bg)
+{
+  AVERT(Background, bg);
+  NOTREACHED;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
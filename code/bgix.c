@@ -0,0 +1,257 @@
+/* bgix.c: BACKGROUND COLLECTOR THREAD FOR POSIX SYSTEMS
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .posix: The implementation uses POSIX threads, and supports Linux
+ * (MPS_OS_LI), FreeBSD (MPS_OS_FR) and Darwin (MPS_OS_XC).
+ *
+ * .design: See <design/arena/#background>.  The thread sleeps on a
+ * condition variable for ARENA_BACKGROUND_INTERVAL when there's no
+ * collection work to do, so that BackgroundWake and BackgroundStop
+ * can wake it.  When
+ * there is work, it yields the processor between steps, so that
+ * mutator threads get a chance to claim the arena lock.
+ *
+ * .stop: The stop and wake flags are protected by the mutex, so that
+ * a wakeup can't be lost between testing the flags and waiting.
+ */
+
+#include "config.h"
+
+#include <pthread.h> /* see .feature.li in config.h */
+#include <sched.h>
+#include <sys/time.h>
+#include <errno.h>
+
+#include "bg.h"
+#include "mpm.h"
+
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_LI) && !defined(MPS_OS_XC)
+#error "bgix.c is Unix specific."
+#endif
+
+SRCID(bgix, "$Id$");
+
+#if defined(LOCK)
+
+typedef struct BackgroundStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* arena to do work for */
+  Bool stop;                    /* has the thread been asked to stop? */
+  Bool wake;                    /* has the thread been asked to work? */
+  pthread_t thread;             /* the background thread */
+  pthread_mutex_t mut;          /* protects stop, see .stop */
+  pthread_cond_t cond;          /* signalled by BackgroundWake/Stop */
+} BackgroundStruct;
+
+
+size_t (BackgroundSize)(void)
+{
+  return sizeof(BackgroundStruct);
+}
+
+
+Bool (BackgroundCheck)(Background bg)
+{
+  CHECKS(Background, bg);
+  CHECKL(TESTT(Arena, bg->arena));
+  CHECKL(BoolCheck(bg->stop));
+  CHECKL(BoolCheck(bg->wake));
+  return TRUE;
+}
+
+
+/* backgroundWait -- wait until the interval passes or we're woken
+ *
+ * Must be called with the mutex held.
+ */
+
+static void backgroundWait(Background bg)
+{
+  struct timeval now;
+  struct timespec until;
+  long usec;
+  int res;
+
+  res = gettimeofday(&now, NULL);
+  AVER(res == 0);
+  usec = (long)(ARENA_BACKGROUND_INTERVAL * 1e6) + (long)now.tv_usec;
+  until.tv_sec = now.tv_sec + usec / 1000000;
+  until.tv_nsec = (usec % 1000000) * 1000;
+  while (!bg->stop && !bg->wake) {
+    res = pthread_cond_timedwait(&bg->cond, &bg->mut, &until);
+    if (res == ETIMEDOUT)
+      break;
+    AVER(res == 0);
+  }
+  bg->wake = FALSE;
+}
+
+
+/* backgroundMain -- the body of the background thread */
+
+static void *backgroundMain(void *p)
+{
+  Background bg = p;
+  Bool workWasDone = FALSE;
+  int res;
+
+  res = pthread_mutex_lock(&bg->mut);
+  AVER(res == 0);
+  while (!bg->stop) {
+    if (workWasDone) {
+      res = pthread_mutex_unlock(&bg->mut);
+      AVER(res == 0);
+      (void)sched_yield();
+    } else {
+      backgroundWait(bg);
+      if (bg->stop)
+        break;
+      res = pthread_mutex_unlock(&bg->mut);
+      AVER(res == 0);
+    }
+    workWasDone = ArenaBackgroundStep(bg->arena);
+    res = pthread_mutex_lock(&bg->mut);
+    AVER(res == 0);
+  }
+  res = pthread_mutex_unlock(&bg->mut);
+  AVER(res == 0);
+  return NULL;
+}
+
+
+Res (BackgroundInit)(Background bg, Arena arena)
+{
+  int res;
+
+  AVER(bg != NULL);
+  AVER(TESTT(Arena, arena));
+
+  bg->arena = arena;
+  bg->stop = FALSE;
+  bg->wake = FALSE;
+  res = pthread_mutex_init(&bg->mut, NULL);
+  if (res != 0)
+    goto failMutex;
+  res = pthread_cond_init(&bg->cond, NULL);
+  if (res != 0)
+    goto failCond;
+  bg->sig = BackgroundSig;
+  res = pthread_create(&bg->thread, NULL, backgroundMain, bg);
+  if (res != 0)
+    goto failThread;
+
+  AVERT(Background, bg);
+  return ResOK;
+
+failThread:
+  bg->sig = SigInvalid;
+  (void)pthread_cond_destroy(&bg->cond);
+failCond:
+  (void)pthread_mutex_destroy(&bg->mut);
+failMutex:
+  return ResRESOURCE;
+}
+
+
+void (BackgroundWake)(Background bg)
+{
+  int res;
+
+  AVERT(Background, bg);
+
+  res = pthread_mutex_lock(&bg->mut);
+  AVER(res == 0);
+  if (!bg->wake) {
+    bg->wake = TRUE;
+    res = pthread_cond_signal(&bg->cond);
+    AVER(res == 0);
+  }
+  res = pthread_mutex_unlock(&bg->mut);
+  AVER(res == 0);
+}
+
+
+void (BackgroundStop)(Background bg)
+{
+  int res;
+
+  AVERT(Background, bg);
+
+  res = pthread_mutex_lock(&bg->mut);
+  AVER(res == 0);
+  bg->stop = TRUE;
+  res = pthread_cond_signal(&bg->cond);
+  AVER(res == 0);
+  res = pthread_mutex_unlock(&bg->mut);
+  AVER(res == 0);
+
+  res = pthread_join(bg->thread, NULL);
+  AVER(res == 0);
+}
+
+
+void (BackgroundFinish)(Background bg)
+{
+  int res;
+
+  AVERT(Background, bg);
+  AVER(bg->stop);
+
+  bg->sig = SigInvalid;
+  res = pthread_cond_destroy(&bg->cond);
+  AVER(res == 0);
+  res = pthread_mutex_destroy(&bg->mut);
+  AVER(res == 0);
+}
+
+
+#elif defined(LOCK_NONE)
+#include "bgan.c"
+#else
+#error "No lock configuration."
+#endif
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
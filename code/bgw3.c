@@ -0,0 +1,192 @@
+/* bgw3.c: BACKGROUND COLLECTOR THREAD FOR WIN32
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .design: See <design/arena/#background>.  The thread waits on a
+ * manual-reset event for ARENA_BACKGROUND_INTERVAL when there's no
+ * collection work to do.  BackgroundStop sets the event, which both
+ * wakes the thread and tells it to stop.  BackgroundWake sets a
+ * second, auto-reset, event that just wakes it.  When there is work, the
+ * thread yields the processor between steps, so that mutator threads
+ * get a chance to claim the arena lock.
+ */
+
+#include "bg.h"
+#include "mpm.h"
+
+#ifndef MPS_OS_W3
+#error "bgw3.c is specific to Win32 but MPS_OS_W3 not defined"
+#endif
+
+#include "mpswin.h"
+
+SRCID(bgw3, "$Id$");
+
+#if defined(LOCK)
+
+typedef struct BackgroundStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* arena to do work for */
+  Bool stop;                    /* has BackgroundStop been called? */
+  HANDLE thread;                /* the background thread */
+  HANDLE event;                 /* set by BackgroundStop */
+  HANDLE wake;                  /* set by BackgroundWake */
+} BackgroundStruct;
+
+
+size_t (BackgroundSize)(void)
+{
+  return sizeof(BackgroundStruct);
+}
+
+
+Bool (BackgroundCheck)(Background bg)
+{
+  CHECKS(Background, bg);
+  CHECKL(TESTT(Arena, bg->arena));
+  CHECKL(BoolCheck(bg->stop));
+  return TRUE;
+}
+
+
+/* backgroundMain -- the body of the background thread */
+
+static DWORD WINAPI backgroundMain(LPVOID p)
+{
+  Background bg = p;
+  Bool workWasDone = FALSE;
+  DWORD timeout = (DWORD)(ARENA_BACKGROUND_INTERVAL * 1000.0);
+  HANDLE events[2];
+
+  events[0] = bg->event;
+  events[1] = bg->wake;
+  for (;;) {
+    if (workWasDone)
+      (void)SwitchToThread();
+    if (WaitForMultipleObjects(2, events, FALSE,
+                               workWasDone ? 0 : timeout)
+        == WAIT_OBJECT_0)
+      break;
+    workWasDone = ArenaBackgroundStep(bg->arena);
+  }
+  return 0;
+}
+
+
+Res (BackgroundInit)(Background bg, Arena arena)
+{
+  AVER(bg != NULL);
+  AVER(TESTT(Arena, arena));
+
+  bg->arena = arena;
+  bg->stop = FALSE;
+  bg->event = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (bg->event == NULL)
+    goto failEvent;
+  bg->wake = CreateEvent(NULL, FALSE, FALSE, NULL);
+  if (bg->wake == NULL)
+    goto failWake;
+  bg->sig = BackgroundSig;
+  bg->thread = CreateThread(NULL, 0, backgroundMain, bg, 0, NULL);
+  if (bg->thread == NULL)
+    goto failThread;
+
+  AVERT(Background, bg);
+  return ResOK;
+
+failThread:
+  bg->sig = SigInvalid;
+  (void)CloseHandle(bg->wake);
+failWake:
+  (void)CloseHandle(bg->event);
+failEvent:
+  return ResRESOURCE;
+}
+
+
+void (BackgroundWake)(Background bg)
+{
+  BOOL b;
+
+  AVERT(Background, bg);
+
+  b = SetEvent(bg->wake);
+  AVER(b);
+}
+
+
+void (BackgroundStop)(Background bg)
+{
+  BOOL b;
+  DWORD res;
+
+  AVERT(Background, bg);
+
+  bg->stop = TRUE;
+  b = SetEvent(bg->event);
+  AVER(b);
+  res = WaitForSingleObject(bg->thread, INFINITE);
+  AVER(res == WAIT_OBJECT_0);
+}
+
+
+void (BackgroundFinish)(Background bg)
+{
+  AVERT(Background, bg);
+  AVER(bg->stop);
+
+  bg->sig = SigInvalid;
+  (void)CloseHandle(bg->thread);
+  (void)CloseHandle(bg->wake);
+  (void)CloseHandle(bg->event);
+}
+
+
+#elif defined(LOCK_NONE)
+#include "bgan.c"
+#else
+#error "No lock configuration."
+#endif
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
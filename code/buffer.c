@@ -45,6 +45,10 @@ Bool BufferCheck(Buffer buffer)
   CHECKL(buffer->fillSize >= 0.0);
   CHECKL(buffer->emptySize >= 0.0);
   CHECKL(buffer->emptySize <= buffer->fillSize);
+  CHECKL(buffer->debt >= 0.0);
+  CHECKL(buffer->debt <= buffer->fillSize);
+  CHECKL(BoolCheck(buffer->exempt));
+  CHECKL(buffer->node == NodeANY || buffer->node < MPS_WORD_WIDTH);
   CHECKL(buffer->alignment == buffer->pool->alignment);
   CHECKL(AlignCheck(buffer->alignment));
 
@@ -145,6 +149,8 @@ static Res BufferAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                 (WriteFC)((buffer->mode & BufferModeATTACHED)   ? 'a' : '_'),
                 "fillSize $UKb\n",  (WriteFU)(buffer->fillSize / 1024),
                 "emptySize $UKb\n", (WriteFU)(buffer->emptySize / 1024),
+                "debt $UKb\n",      (WriteFU)(buffer->debt / 1024),
+                buffer->exempt ? "exempt\n" : "",
                 "alignment $W\n",   (WriteFW)buffer->alignment,
                 "base $A\n",        (WriteFA)buffer->base,
                 "initAtFlip $A\n",  (WriteFA)buffer->initAtFlip,
@@ -165,14 +171,25 @@ Res BufferDescribe(Buffer buffer, mps_lib_FILE *stream, Count depth)
 
 /* BufferInit -- initialize an allocation buffer */
 
+ARG_DEFINE_KEY(AP_EXEMPT, Bool);
+
 static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
 {
   Arena arena;
+  Bool exempt = FALSE;
+  Index node = NodeANY;
+  ArgStruct arg;
 
   AVER(buffer != NULL);
   AVERT(Pool, pool);
   AVER(BoolCheck(isMutator));
   AVERT(ArgList, args);
+  if (ArgPick(&arg, args, MPS_KEY_AP_EXEMPT))
+    exempt = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_NUMA_NODE)) {
+    AVER(arg.val.u < MPS_WORD_WIDTH);
+    node = arg.val.u;
+  }
 
   /* Superclass init */
   InstInit(CouldBeA(Inst, buffer));
@@ -192,6 +209,9 @@ static Res BufferAbsInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   }
   buffer->fillSize = 0.0;
   buffer->emptySize = 0.0;
+  buffer->debt = 0.0;
+  buffer->exempt = exempt;
+  buffer->node = node;
   buffer->alignment = PoolAlignment(pool);
   buffer->base = (Addr)0;
   buffer->initAtFlip = (Addr)0;
@@ -342,6 +362,10 @@ static void BufferAbsFinish(Inst inst)
   /* Detach the buffer from its owning pool and unsig it. */
   RingRemove(&buffer->poolRing);
   InstFinish(MustBeA(Inst, buffer));
+
+  /* Write off the buffer's debt.  See <design/buffer/#poll.debt>. */
+  ArenaGlobals(buffer->arena)->mutatorDebt -= buffer->debt;
+  buffer->debt = 0.0;
   buffer->sig = SigInvalid;
  
   /* Finish off the generic buffer fields. */
@@ -543,6 +567,8 @@ void BufferAttach(Buffer buffer, Addr base, Addr limit,
       ArenaGlobals(buffer->arena)->allocMutatorSize -= prealloc;
     }
     ArenaGlobals(buffer->arena)->fillMutatorSize += filled;
+    ArenaGlobals(buffer->arena)->mutatorDebt += filled;
+    buffer->debt += filled;
   } else {
     ArenaGlobals(buffer->arena)->fillInternalSize += filled;
   }
@@ -555,6 +581,36 @@ void BufferAttach(Buffer buffer, Addr base, Addr limit,
 }
 
 
+/* BufferPoll -- poll the arena on behalf of a buffer
+ *
+ * Called by mps_ap_fill.  The thread that passes the arena's poll
+ * threshold isn't necessarily the one whose allocation made the
+ * collection work necessary, so the work is only done if
+ * PolicyPollBuffer agrees that this buffer owes it, and then the
+ * buffer's debt is paid off.  See <design/buffer/#poll.debt>.
+ */
+
+void (BufferPoll)(Buffer buffer)
+{
+  Arena arena;
+  Globals globals;
+
+  AVERT(Buffer, buffer);
+  AVER(buffer->isMutator);
+
+  arena = BufferArena(buffer);
+  globals = ArenaGlobals(arena);
+  if (!PolicyPoll(arena))
+    return;
+  if (!PolicyPollBuffer(arena, buffer))
+    return;
+
+  globals->mutatorDebt -= buffer->debt;
+  buffer->debt = 0.0;
+  ArenaPoll(globals);
+}
+
+
 /* BufferFill -- refill an empty buffer
  *
  * BufferFill is entered by the "reserve" operation on a buffer if there
@@ -603,7 +659,9 @@ Res BufferFill(Addr *pReturn, Buffer buffer, Size size)
 
   BufferDetach(buffer, pool);
 
-  /* Ask the pool for some memory. */
+  /* Ask the pool for some memory.  Pools pass the buffer's NUMA node
+     in the locus preference of any memory they get from the arena for
+     the fill.  See <design/arena/#numa.pref>. */
   res = Method(Pool, pool, bufferFill)(&base, &limit, pool, buffer, size);
   if (res != ResOK)
     return res;
@@ -912,6 +912,7 @@ typedef struct cbsTestNodeInZonesClosureStruct {
   Size size;
   Arena arena;
   ZoneSet zoneSet;
+  ZoneSet fineZoneSet;
   Addr base;
   Addr limit;
   Bool high;
@@ -930,7 +931,7 @@ static Bool cbsTestNodeInZones(SplayTree splay, Tree tree,
 
   return search(&my->base, &my->limit,
                 CBSBlockBase(block), CBSBlockLimit(block),
-                my->arena, my->zoneSet, my->size);
+                my->arena, my->zoneSet, my->fineZoneSet, my->size);
 }
 
 static Bool cbsTestTreeInZones(SplayTree splay, Tree tree,
@@ -1020,7 +1021,7 @@ static Bool cbsFindLargest(Range rangeReturn, Range oldRangeReturn,
 
 static Res cbsFindInZones(Bool *foundReturn, Range rangeReturn,
                           Range oldRangeReturn, Land land, Size size,
-                          ZoneSet zoneSet, Bool high)
+                          ZoneSet zoneSet, ZoneSet fineZoneSet, Bool high)
 {
   CBS cbs = MustBeA(CBSZoned, land);
   CBSBlock block;
@@ -1040,9 +1041,9 @@ static Res cbsFindInZones(Bool *foundReturn, Range rangeReturn,
   landFind = high ? cbsFindLast : cbsFindFirst;
   splayFind = high ? SplayFindLast : SplayFindFirst;
   
-  if (zoneSet == ZoneSetEMPTY)
+  if (zoneSet == ZoneSetEMPTY || fineZoneSet == ZoneSetEMPTY)
     goto fail;
-  if (zoneSet == ZoneSetUNIV) {
+  if (zoneSet == ZoneSetUNIV && fineZoneSet == ZoneSetUNIV) {
     FindDelete fd = high ? FindDeleteHIGH : FindDeleteLOW;
     *foundReturn = (*landFind)(rangeReturn, oldRangeReturn, land, size, fd);
     return ResOK;
@@ -1055,6 +1056,7 @@ static Res cbsFindInZones(Bool *foundReturn, Range rangeReturn,
 
   closure.arena = LandArena(land);
   closure.zoneSet = zoneSet;
+  closure.fineZoneSet = fineZoneSet;
   closure.size = size;
   closure.high = high;
   if (!(*splayFind)(&tree, cbsSplay(cbs),
@@ -1067,6 +1069,8 @@ static Res cbsFindInZones(Bool *foundReturn, Range rangeReturn,
   AVER(CBSBlockBase(block) <= closure.base);
   AVER(AddrOffset(closure.base, closure.limit) >= size);
   AVER(ZoneSetSub(ZoneSetOfRange(LandArena(land), closure.base, closure.limit), zoneSet));
+  AVER(fineZoneSet == ZoneSetUNIV
+       || ZoneSetSub(FineZoneSetOfRange(LandArena(land), closure.base, closure.limit), fineZoneSet));
   AVER(closure.limit <= CBSBlockLimit(block));
 
   if (!high)
@@ -350,6 +350,22 @@
 /* AMC treats objects larger than or equal to this as "Large" */
 #define AMC_LARGE_SIZE_DEFAULT ((Size)32768)
 #define AMC_EXTEND_BY_DEFAULT  ((Size)8192)
+/* AMC gives segments with at least this many arena grains a card
+ * table, so that the write barrier works per card.  See
+ * <design/seg/#card>. */
+#define AMC_CARDS_MIN ((Count)4)
+/* AMC measures the survival of the objects allocated by each mutator
+ * allocation point, and if MPS_KEY_AP_PRETENURE is set, an allocation
+ * point whose objects survive at least AMC_PRETENURE_SURVIVAL of the
+ * time allocates in the next generation, and one whose objects survive
+ * less than AMC_PRETENURE_DEMOTE goes back to the nursery.  Survival
+ * is averaged over samples of at least AMC_PRETENURE_SAMPLE segments.
+ * See <design/poolamc/#pretenure>. */
+#define AMC_AP_PRETENURE_DEFAULT FALSE
+#define AMC_PRETENURE_SURVIVAL (0.9)
+#define AMC_PRETENURE_DEMOTE (0.5)
+#define AMC_PRETENURE_SAMPLE ((Count)4)
+#define AMC_PRETENURE_ALPHA (0.5)
 
 
 /* Pool AMS Configuration -- see <code/poolams.c> */
@@ -411,6 +427,18 @@
 
 #define ArenaPollALLOCTIME (65536.0)
 
+/* When the arena passes its poll threshold, an allocation point only
+ * does the collection work if it has filled at least
+ * ARENA_POLL_DEBT bytes since it last did some, or at least
+ * ARENA_POLL_DEBT_SHARE of the bytes filled by all allocation points
+ * since they last did some.  Once the arena is ARENA_POLL_DEBT_LAG
+ * bytes past the threshold, any allocation point does the work, even
+ * an exempt one.  See <design/buffer/#poll.debt>. */
+
+#define ARENA_POLL_DEBT ArenaPollALLOCTIME
+#define ARENA_POLL_DEBT_SHARE (0.5)
+#define ARENA_POLL_DEBT_LAG (16 * ArenaPollALLOCTIME)
+
 /* .client.seg-size: ARENA_CLIENT_GRAIN_SIZE is the minimum size, in
  * bytes, of a grain in the client arena. It's set at 8192 with no
  * particular justification. */
@@ -431,8 +459,91 @@
 
 #define ARENA_DEFAULT_PAUSE_TIME (0.1)
 
+/* ARENA_DEFAULT_BACKGROUND says whether arenas have a background
+ * collector thread by default, and ARENA_BACKGROUND_INTERVAL is how
+ * long (in seconds) that thread sleeps when it finds no collection
+ * work to do.  ARENA_BACKGROUND_LAG is how far (in bytes allocated)
+ * the mutator may get past the poll threshold before it does
+ * collection work itself.  See <design/arena/#background>. */
+
+#define ARENA_DEFAULT_BACKGROUND FALSE
+#define ARENA_BACKGROUND_INTERVAL (0.01)
+#define ARENA_BACKGROUND_LAG (16 * ArenaPollALLOCTIME)
+
+/* ARENA_PRESSURE_INTERVAL is the least time (in seconds) between
+ * readings of the memory pressure, for arenas created with
+ * MPS_KEY_ARENA_PRESSURE_PATH.  The control group is under pressure
+ * if the memory it uses is at least ARENA_PRESSURE_FRACTION of its
+ * limit, or if tasks were stalled waiting for memory for at least
+ * ARENA_PRESSURE_STALL percent of the time.  Collections started
+ * because of pressure may take up to ARENA_PRESSURE_COLLECT_FRACTION
+ * of runtime, since being killed for lack of memory is worse than
+ * being slow.  See <design/arena/#pressure>. */
+
+#define ARENA_PRESSURE_INTERVAL (0.01)
+#define ARENA_PRESSURE_FRACTION (0.9)
+#define ARENA_PRESSURE_STALL (10.0)
+#define ARENA_PRESSURE_COLLECT_FRACTION (0.5)
+
+/* ARENA_DEFAULT_SPARE_DECAY is the default time constant (in seconds)
+ * over which spare committed memory is returned to the operating
+ * system; zero means that it is only returned when it exceeds the
+ * spare commit limit.  ARENA_SPARE_DECAY_INTERVAL is the least time
+ * (in seconds) between decay steps.  See <design/arena/#spare.decay>. */
+
+#define ARENA_DEFAULT_SPARE_DECAY (0.0)
+#define ARENA_SPARE_DECAY_INTERVAL (0.01)
+
+/* ARENA_DEFAULT_HUGE_PAGES says whether VM arenas ask the operating
+ * system for transparent huge pages by default, and VM_HUGE_PAGE_SIZE
+ * is the size of those pages, to which chunk reservations are then
+ * aligned.  See <design/arena/#huge>. */
+
+#define ARENA_DEFAULT_HUGE_PAGES FALSE
+#define VM_HUGE_PAGE_SIZE ((Size)2 * 1024 * 1024)
+
+/* ARENA_DEFAULT_NUMA_NODES is the number of NUMA nodes across which VM
+ * arenas spread their zones by default.  One means the arena doesn't
+ * bind memory to nodes at all.  See <design/arena/#numa>. */
+
+#define ARENA_DEFAULT_NUMA_NODES 1
+
+/* ARENA_LARGE_SIZE is the smallest range that VMFree returns to the
+ * operating system at once when it won't fit among the spare pages.
+ * See <design/arena/#large.free>. */
+
+#define ARENA_LARGE_SIZE ((Size)65536)
+
+/* IMAGE_DATA_ALIGN is the alignment of the objects in a heap image
+ * file: it must be a multiple of the page size for the objects to be
+ * mapped rather than read when the image is loaded, so it is the
+ * largest page size of the supported platforms.  IMAGE_RELOC_BATCH is
+ * the number of relocations read or written at a time, and
+ * IMAGE_ARRAY_MIN is the initial capacity of the tables of objects
+ * being saved.  See <design/image/>. */
+
+#define IMAGE_DATA_ALIGN ((Size)65536)
+#define IMAGE_RELOC_BATCH ((Count)512)
+#define IMAGE_ARRAY_MIN ((Count)64)
+
+/* ChunkMapLENGTH is the number of entries in the arena's chunk map.
+ * Each entry covers at least 2^ChunkMapMinSHIFT bytes of address
+ * space, and more if that is needed for the map to cover all the
+ * chunks.  See <design/arena/#chunk.map>. */
+
+#define ChunkMapLENGTH ((Count)1024)
+#define ChunkMapMinSHIFT ((Shift)22)
+
 #define ARENA_DEFAULT_ZONED     TRUE
 
+/* ARENA_DEFAULT_ZONES is the default number of zones distinguished by
+ * the fix test.  The zone set in MPS_FIX1 distinguishes MPS_WORD_WIDTH;
+ * if there are more, TraceFix tests a second "fine" zone set with a
+ * smaller shift.  It must be a power of two between MPS_WORD_WIDTH and
+ * MPS_WORD_WIDTH squared.  See <design/arena/#zone.fine>. */
+
+#define ARENA_DEFAULT_ZONES     ((Count)MPS_WORD_WIDTH)
+
 /* ARENA_MINIMUM_COLLECTABLE_SIZE is the minimum size (in bytes) of
  * collectable memory that might be considered worthwhile to run a
  * full garbage collection. */
@@ -452,11 +563,54 @@
 
 #define ARENA_DEFAULT_COLLECTION_OVERHEAD (0.1)
 
+/* ARENA_RATE_OBSERVATION_TIME is the amount of time (in seconds) over
+ * which scan and reclaim measurements are accumulated before they are
+ * folded into the moving average.  This must be long compared with
+ * the resolution of the clock.  See <code/policy.c#rate>. */
+
+#define ARENA_RATE_OBSERVATION_TIME (0.001)
+
+/* ARENA_RATE_ALPHA is the weight given to each new observation in
+ * the exponentially weighted moving average of a rate. */
+
+#define ARENA_RATE_ALPHA (0.2)
+
+/* ARENA_RATE_SAMPLE is the sampling interval for segment scans, root
+ * scans and reclaims: only one in this many is timed, so that the
+ * cost of reading the clock is not paid for every one. */
+
+#define ARENA_RATE_SAMPLE ((Count)16)
+
+/* ARENA_PAUSE_PERCENTILE is the fraction of pauses that the pause
+ * controller aims to keep within the arena's pause time.  See
+ * <code/policy.c#pause>. */
+
+#define ARENA_PAUSE_PERCENTILE (0.95)
+
+/* ARENA_PAUSE_STEP is the step (as a fraction of the pause time) by
+ * which the estimate of the pause time at ARENA_PAUSE_PERCENTILE
+ * moves after each pause. */
+
+#define ARENA_PAUSE_STEP (0.05)
+
+/* ARENA_QUANTUM_SCALE_MIN is the smallest fraction of a trace's
+ * quantum of work that the pause controller will do at a time. */
+
+#define ARENA_QUANTUM_SCALE_MIN (1.0 / 64.0)
+
 /* ARENA_MAX_COLLECT_FRACTION is the maximum fraction of runtime that
  * ArenaStep is prepared to spend in collections. */
 
 #define ARENA_MAX_COLLECT_FRACTION (0.1)
 
+/* LOCUS_BLACKLIST_HITS is the number of recent ambiguous references
+ * (halved at the end of each collection) that make a zone noisy
+ * enough to blacklist, and LOCUS_BLACKLIST_MAX is the most zones
+ * that may be blacklisted.  See <design/arena/#zone.blacklist>. */
+
+#define LOCUS_BLACKLIST_HITS    ((Count)32)
+#define LOCUS_BLACKLIST_MAX     ((Count)MPS_WORD_WIDTH / 8)
+
 /* ArenaDefaultZONESET is the zone set used by LocusPrefDEFAULT.
  *
  * TODO: This is left over from before branches 2014-01-29/mps-chain-zones
@@ -473,6 +627,8 @@
   FALSE,               /* high */ \
   ArenaDefaultZONESET, /* zoneSet */ \
   ZoneSetEMPTY,        /* avoid */ \
+  NodeANY,             /* node */ \
+  ZoneSetUNIV,         /* fineZones */ \
 }
 
 #define LDHistoryLENGTH ((Size)4)
@@ -489,6 +645,16 @@
  * average computation of the mortality of a generation. */
 #define LocusMortalityALPHA (0.4)
 
+/* Tuning of generation capacities in chains created with
+ * MPS_KEY_CHAIN_LIMITS. When the predicted mortality of a generation
+ * falls below LocusTuneLOW, its capacity is multiplied by
+ * LocusTuneGROW; when it rises above LocusTuneHIGH, its capacity is
+ * multiplied by LocusTuneSHRINK. See <design/strategy/#policy.tune>. */
+#define LocusTuneLOW (0.8)
+#define LocusTuneHIGH (0.95)
+#define LocusTuneGROW (1.25)
+#define LocusTuneSHRINK (0.8)
+
 
 /* Stack probe configuration -- see <code/sp*.c> */
 
@@ -522,12 +688,16 @@
  * Source      Symbols                   Header        Feature
  * =========== ========================= ============= ====================
  * eventtxt.c  setenv                    <stdlib.h>    _GNU_SOURCE
+ * imageix.c   pread, pwrite             <unistd.h>    _XOPEN_SOURCE >= 500
  * lockix.c    pthread_mutexattr_settype <pthread.h>   _XOPEN_SOURCE >= 500
  * prmci3li.c  REG_EAX etc.              <ucontext.h>  _GNU_SOURCE
  * prmci6li.c  REG_RAX etc.              <ucontext.h>  _GNU_SOURCE
  * prmcix.h    stack_t, siginfo_t        <signal.h>    _XOPEN_SOURCE
  * pthrdext.c  sigaction etc.            <signal.h>    _XOPEN_SOURCE
  * vmix.c      MAP_ANON                  <sys/mman.h>  _GNU_SOURCE
+ * vmix.c      madvise, MADV_HUGEPAGE    <sys/mman.h>  _GNU_SOURCE
+ * vmix.c      mremap, MREMAP_FIXED      <sys/mman.h>  _GNU_SOURCE
+ * vmix.c      syscall                   <unistd.h>    _GNU_SOURCE
  *
  * It is not possible to localize these feature specifications around
  * the individual headers: all headers share a common set of features
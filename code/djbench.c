@@ -49,12 +49,15 @@ static unsigned niter = 50;       /* iterations */
 static unsigned npass = 100;      /* passes over blocks */
 static unsigned nblocks = 64;     /* number of blocks */
 static unsigned sshift = 18;      /* log2 max block size in words */
+static size_t min_size = 0;       /* minimum block size */
 static double pact = 0.2;         /* probability per pass of acting */
 static unsigned rinter = 75;      /* pass interval for recursion */
 static unsigned rmax = 10;        /* maximum recursion depth */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
 static size_t arena_grain_size = 1; /* arena grain size */
+static size_t commit_limit = 0;   /* arena commit limit, or 0 for none */
+static size_t spare_commit_limit = ARENA_DEFAULT_SPARE_COMMIT_LIMIT;
 
 #define DJRUN(fname, alloc, free) \
   static unsigned fname##_inner(mps_ap_t ap, unsigned depth, unsigned r) { \
@@ -70,7 +73,8 @@ static size_t arena_grain_size = 1; /* arena grain size */
       for (k = 0; k < nblocks; ++k) { \
         if (rnd() % 16384 < pact * 16384) { \
           if (blocks[k].p == NULL) { \
-            size_t s = rnd() % ((sizeof(void *) << (rnd() % sshift)) - 1); \
+            size_t s = min_size \
+              + rnd() % ((sizeof(void *) << (rnd() % sshift)) - 1); \
             void *p = NULL; \
             if (s > 0) \
               alloc(p, s); \
@@ -188,6 +192,9 @@ static void arena_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, arena_grain_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    if (commit_limit > 0)
+      MPS_ARGS_ADD(args, MPS_KEY_COMMIT_LIMIT, commit_limit);
+    MPS_ARGS_ADD(args, MPS_KEY_SPARE_COMMIT_LIMIT, spare_commit_limit);
     DJMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
   DJMUST(mps_pool_create_k(&pool, arena, pool_class, mps_args_none));
@@ -213,6 +220,9 @@ static struct option longopts[] = {
   {"arena-size",       required_argument, NULL, 'm'},
   {"arena-grain-size", required_argument, NULL, 'a'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"commit-limit",     required_argument, NULL, 'l'},
+  {"spare-commit-limit", required_argument, NULL, 'S'},
+  {"min-size",         required_argument, NULL, 'n'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -247,7 +257,7 @@ int main(int argc, char *argv[]) {
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:b:s:c:r:d:m:a:x:z", longopts, NULL)) != -1)
+  while ((ch = getopt_long(argc, argv, "ht:i:p:b:s:c:r:d:m:a:x:zl:S:n:", longopts, NULL)) != -1)
     switch (ch) {
     case 't':
       nthreads = (unsigned)strtoul(optarg, NULL, 10);
@@ -308,6 +318,48 @@ int main(int argc, char *argv[]) {
         }
       }
       break;
+    case 'l': {
+        char *p;
+        commit_limit = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': commit_limit <<= 30; break;
+        case 'M': commit_limit <<= 20; break;
+        case 'K': commit_limit <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad commit limit %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    case 'S': {
+        char *p;
+        spare_commit_limit = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': spare_commit_limit <<= 30; break;
+        case 'M': spare_commit_limit <<= 20; break;
+        case 'K': spare_commit_limit <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad spare commit limit %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    case 'n': {
+        char *p;
+        min_size = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': min_size <<= 30; break;
+        case 'M': min_size <<= 20; break;
+        case 'K': min_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad minimum size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -345,16 +397,24 @@ int main(int argc, char *argv[]) {
               "  -x n, --seed=n\n"
               "    Random number seed (default from entropy).\n"
               "  -z, --arena-unzoned\n"
-              "    Disabled zoned allocation in the arena\n"
+              "    Disabled zoned allocation in the arena\n",
+              pact,
+              rinter,
+              rmax);
+      fprintf(stderr,
+              "  -l n, --commit-limit=n[KMG]?\n"
+              "    Arena commit limit (default none).\n"
+              "  -S n, --spare-commit-limit=n[KMG]?\n"
+              "    Arena spare commit limit (default %lu).\n"
+              "  -n n, --min-size=n[KMG]?\n"
+              "    Minimum block size (default 0).\n"
               "Tests:\n"
               "  mvt   pool class MVT\n"
               "  mvff  pool class MVFF\n"
               "  mv    pool class MV\n"
               "  mvb   pool class MV with buffers\n"
               "  an    malloc\n",
-              pact,
-              rinter,
-              rmax);
+              (unsigned long)spare_commit_limit);
       return EXIT_FAILURE;
     }
   argc -= optind;
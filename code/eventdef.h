@@ -37,7 +37,7 @@
 
 #define EVENT_VERSION_MAJOR  ((unsigned)1)
 #define EVENT_VERSION_MEDIAN ((unsigned)6)
-#define EVENT_VERSION_MINOR  ((unsigned)1)
+#define EVENT_VERSION_MINOR  ((unsigned)8)
 
 
 /* EVENT_LIST -- list of event types and general properties
@@ -67,7 +67,7 @@
  */
  
 #define EventNameMAX ((size_t)19)
-#define EventCodeMAX ((EventCode)0x0088)
+#define EventCodeMAX ((EventCode)0x0090)
 
 #define EVENT_LIST(EVENT, X) \
   /*       0123456789012345678 <- don't exceed without changing EventNameMAX */ \
@@ -194,7 +194,15 @@
   EVENT(X, ArenaUseFreeZone   , 0x0085,  TRUE, Arena) \
   /* EVENT(X, ArenaBlacklistZone , 0x0086,  TRUE, Arena) */ \
   EVENT(X, PauseTimeSet       , 0x0087,  TRUE, Arena) \
-  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace)
+  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace) \
+  EVENT(X, ArenaPause         , 0x0089,  TRUE, Arena) \
+  EVENT(X, AMCPretenure       , 0x008A,  TRUE, Pool) \
+  EVENT(X, GenTune            , 0x008B,  TRUE, Trace) \
+  EVENT(X, ArenaPressure      , 0x008C,  TRUE, Arena) \
+  EVENT(X, ArenaGenZoneRemove , 0x008D,  TRUE, Arena) \
+  EVENT(X, ArenaFreeZone      , 0x008E,  TRUE, Arena) \
+  EVENT(X, ArenaBlacklist     , 0x008F,  TRUE, Arena) \
+  EVENT(X, ArenaSpareDecay    , 0x0090,  TRUE, Arena)
 
 
 /* Remember to update EventNameMAX and EventCodeMAX above! 
@@ -735,6 +743,50 @@
   PARAM(X,  4, W, preservedInPlace) /* bytes preserved in generation */ \
   PARAM(X,  5, D, mortality)    /* updated mortality */
 
+#define EVENT_ArenaPause_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, D, pause)        /* length of the pause, in seconds */ \
+  PARAM(X,  2, D, pauseTime)    /* the maximum pause time, in seconds */ \
+  PARAM(X,  3, D, pauseAchieved) /* estimated pause at percentile */
+
+#define EVENT_AMCPretenure_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, amc)          /* the AMC pool */ \
+  PARAM(X,  1, P, buffer)       /* the mutator buffer */ \
+  PARAM(X,  2, P, gen)          /* the AMC generation it now allocates in */ \
+  PARAM(X,  3, D, survival)     /* measured survival of its objects */
+
+#define EVENT_GenTune_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, trace)        /* the trace */ \
+  PARAM(X,  1, P, gen)          /* the generation */ \
+  PARAM(X,  2, W, oldCapacity)  /* previous capacity, in kB */ \
+  PARAM(X,  3, W, capacity)     /* new capacity, in kB */ \
+  PARAM(X,  4, D, mortality)    /* predicted mortality */
+
+#define EVENT_ArenaPressure_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, W, current)      /* memory in use by the control group */ \
+  PARAM(X,  2, W, max)          /* memory limit of the control group */ \
+  PARAM(X,  3, D, stall)        /* percentage of time stalled on memory */ \
+  PARAM(X,  4, W, purged)       /* spare committed memory purged */
+
+#define EVENT_ArenaGenZoneRemove_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, P, gendesc)      /* the generation description */ \
+  PARAM(X,  2, W, zoneSet)      /* the new zoneSet */
+
+#define EVENT_ArenaFreeZone_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, W, zoneSet)      /* zones that are free again */
+
+#define EVENT_ArenaBlacklist_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, W, zoneSet)      /* the new ambiguous blacklist */
+
+#define EVENT_ArenaSpareDecay_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, W, purged)       /* spare committed memory purged */ \
+  PARAM(X,  2, W, spare)        /* spare committed memory remaining */
+
 
 #endif /* eventdef_h */
 
@@ -216,7 +216,7 @@ static Bool failoverFindLargest(Range rangeReturn, Range oldRangeReturn, Land la
 }
 
 
-static Bool failoverFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, Bool high)
+static Bool failoverFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, ZoneSet fineZoneSet, Bool high)
 {
   Failover fo = MustBeA(Failover, land);
   Bool found = FALSE;
@@ -232,9 +232,9 @@ static Bool failoverFindInZones(Bool *foundReturn, Range rangeReturn, Range oldR
   /* See <design/failover/#impl.assume.flush>. */
   (void)LandFlush(fo->primary, fo->secondary);
 
-  res = LandFindInZones(&found, rangeReturn, oldRangeReturn, fo->primary, size, zoneSet, high);
+  res = LandFindInZones(&found, rangeReturn, oldRangeReturn, fo->primary, size, zoneSet, fineZoneSet, high);
   if (res != ResOK || !found)
-    res = LandFindInZones(&found, rangeReturn, oldRangeReturn, fo->secondary, size, zoneSet, high);
+    res = LandFindInZones(&found, rangeReturn, oldRangeReturn, fo->secondary, size, zoneSet, fineZoneSet, high);
 
   *foundReturn = found;
   return res;
@@ -204,6 +204,14 @@ int dylan_wrapper_check(mps_word_t *w)
 }
 
 
+/* FMTDY_FIX_BATCH -- number of references to fix together */
+/* The scanners collect the locations of the references that pass */
+/* MPS_FIX1 and pass them to MPS_FIX2_REFS together, rather than */
+/* calling MPS_FIX2 for each of them. */
+
+#define FMTDY_FIX_BATCH 64
+
+
 /* Scan a contiguous array of references in [base, limit). */
 /* This code has been hand-optimised and examined using Metrowerks */
 /* Codewarrior on a 68K and also Microsoft Visual C on a 486.  The */
@@ -216,18 +224,28 @@ static mps_res_t dylan_scan_contig(mps_ss_t mps_ss,
   mps_res_t res;
   mps_addr_t *p;        /* reference cursor */
   mps_addr_t r;         /* reference to be fixed */
+  mps_addr_t *fix[FMTDY_FIX_BATCH]; /* locations to be fixed */
+  size_t n;             /* number of locations in fix */
 
   MPS_SCAN_BEGIN(mps_ss) {
           p = base;
+          n = 0;
     loop: if(p >= limit) goto out;
           r = *p++;
           if(((mps_word_t)r&3) != 0) /* pointers tagged with 0 */
             goto loop;             /* not a pointer */
           if(!MPS_FIX1(mps_ss, r)) goto loop;
-          res = MPS_FIX2(mps_ss, p-1);
-          if(res == MPS_RES_OK) goto loop;
-          return res;
+          fix[n++] = p-1;
+          if(n < FMTDY_FIX_BATCH) goto loop;
+          res = MPS_FIX2_REFS(mps_ss, fix, n);
+          if(res != MPS_RES_OK) return res;
+          n = 0;
+          goto loop;
     out:  assert(p == limit);
+          if(n > 0) {
+            res = MPS_FIX2_REFS(mps_ss, fix, n);
+            if(res != MPS_RES_OK) return res;
+          }
   } MPS_SCAN_END(mps_ss);
 
   return MPS_RES_OK;
@@ -329,11 +347,14 @@ static mps_res_t dylan_scan_pat(mps_ss_t mps_ss,
   mps_addr_t *pp;       /* inner loop cursor */
   int b;                /* bit */
   mps_addr_t r;         /* reference to be fixed */
+  mps_addr_t *fix[FMTDY_FIX_BATCH]; /* locations to be fixed */
+  size_t n;             /* number of locations in fix */
 
   unused(nr_pats);
 
   MPS_SCAN_BEGIN(mps_ss) {
           p = base;
+          n = 0;
           goto in;
     pat:  p += FMTDY_WORD_WIDTH;
           if(p >= limit) goto out;
@@ -348,11 +369,18 @@ static mps_res_t dylan_scan_pat(mps_ss_t mps_ss,
           if(((mps_word_t)r&3) != 0) /* pointers tagged with 0 */
             goto loop;             /* not a pointer */
           if(!MPS_FIX1(mps_ss, r)) goto loop;
-          res = MPS_FIX2(mps_ss, pp-1);
-          if(res == MPS_RES_OK) goto loop;
-          return res;
+          fix[n++] = pp-1;
+          if(n < FMTDY_FIX_BATCH) goto loop;
+          res = MPS_FIX2_REFS(mps_ss, fix, n);
+          if(res != MPS_RES_OK) return res;
+          n = 0;
+          goto loop;
     out:  assert(p < limit + FMTDY_WORD_WIDTH);
           assert(pc == pats + nr_pats);
+          if(n > 0) {
+            res = MPS_FIX2_REFS(mps_ss, fix, n);
+            if(res != MPS_RES_OK) return res;
+          }
   } MPS_SCAN_END(mps_ss);
 
   return MPS_RES_OK;
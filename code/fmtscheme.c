@@ -243,16 +243,46 @@ obj_t scheme_make_table(mps_ap_t ap, size_t length, hash_t hashf, cmp_t cmpf)
 
 /* MPS Format */
 
+/* obj_scan -- scan objects
+ *
+ * References that pass MPS_FIX1 are collected and fixed together by
+ * MPS_FIX2_REFS when FIX_BATCH of them have been collected, and at
+ * the end of the area.  They are copied to refs to avoid a type pun,
+ * and copied back to their fields after fixing.
+ */
+
+#define FIX_BATCH 64
+
 static mps_res_t obj_scan(mps_ss_t ss, mps_addr_t base, mps_addr_t limit)
 {
-#define FIX(ref) \
+  mps_addr_t refs[FIX_BATCH];      /* copies of references to fix */
+  mps_addr_t *ref_ios[FIX_BATCH];  /* ref_ios[i] is &refs[i] */
+  obj_t *fields[FIX_BATCH];        /* fields[i] is where refs[i] came from */
+  size_t n = 0, i;
+
+#define FIX_FLUSH() \
   do { \
-    mps_addr_t _addr = (ref); /* copy to local to avoid type pun */ \
-    mps_res_t res = MPS_FIX12(ss, &_addr); \
+    mps_res_t res = MPS_FIX2_REFS(ss, ref_ios, n); \
     if (res != MPS_RES_OK) return res; \
-    (ref) = _addr; \
+    for (i = 0; i < n; ++i) \
+      *fields[i] = refs[i]; \
+    n = 0; \
   } while(0)
 
+#define FIX(ref) \
+  do { \
+    if (MPS_FIX1(ss, ref)) { \
+      refs[n] = (ref); \
+      fields[n] = &(ref); \
+      ++n; \
+      if (n == FIX_BATCH) \
+        FIX_FLUSH(); \
+    } \
+  } while(0)
+
+  for (i = 0; i < FIX_BATCH; ++i)
+    ref_ios[i] = &refs[i];
+
   MPS_SCAN_BEGIN(ss) {
     while (base < limit) {
       obj_t obj = base;
@@ -293,9 +323,9 @@ static mps_res_t obj_scan(mps_ss_t ss, mps_addr_t base, mps_addr_t limit)
         break;
       case TYPE_VECTOR:
         {
-          size_t i;
-          for (i = 0; i < obj->vector.length; ++i)
-            FIX(obj->vector.vector[i]);
+          size_t j;
+          for (j = 0; j < obj->vector.length; ++j)
+            FIX(obj->vector.vector[j]);
         }
         base = (char *)base +
           ALIGN_OBJ(offsetof(vector_s, vector) +
@@ -303,10 +333,10 @@ static mps_res_t obj_scan(mps_ss_t ss, mps_addr_t base, mps_addr_t limit)
         break;
       case TYPE_BUCKETS:
         {
-          size_t i;
-          for (i = 0; i < obj->buckets.length; ++i) {
-            FIX(obj->buckets.bucket[i].key);
-            FIX(obj->buckets.bucket[i].value);
+          size_t j;
+          for (j = 0; j < obj->buckets.length; ++j) {
+            FIX(obj->buckets.bucket[j].key);
+            FIX(obj->buckets.bucket[j].value);
           }
         }
         base = (char *)base +
@@ -334,6 +364,8 @@ static mps_res_t obj_scan(mps_ss_t ss, mps_addr_t base, mps_addr_t limit)
         return MPS_RES_FAIL;
       }
     }
+    if (n > 0)
+      FIX_FLUSH();
   } MPS_SCAN_END(ss);
   return MPS_RES_OK;
 }
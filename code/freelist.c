@@ -649,7 +649,8 @@ static Bool freelistFindLargest(Range rangeReturn, Range oldRangeReturn,
 
 static Res freelistFindInZones(Bool *foundReturn, Range rangeReturn,
                                Range oldRangeReturn, Land land, Size size,
-                               ZoneSet zoneSet, Bool high)
+                               ZoneSet zoneSet, ZoneSet fineZoneSet,
+                               Bool high)
 {
   Freelist fl = MustBeA(Freelist, land);
   LandFindMethod landFind;
@@ -668,9 +669,9 @@ static Res freelistFindInZones(Bool *foundReturn, Range rangeReturn,
   landFind = high ? freelistFindLast : freelistFindFirst;
   search = high ? RangeInZoneSetLast : RangeInZoneSetFirst;
 
-  if (zoneSet == ZoneSetEMPTY)
+  if (zoneSet == ZoneSetEMPTY || fineZoneSet == ZoneSetEMPTY)
     goto fail;
-  if (zoneSet == ZoneSetUNIV) {
+  if (zoneSet == ZoneSetUNIV && fineZoneSet == ZoneSetUNIV) {
     FindDelete fd = high ? FindDeleteHIGH : FindDeleteLOW;
     *foundReturn = (*landFind)(rangeReturn, oldRangeReturn, land, size, fd);
     return ResOK;
@@ -684,7 +685,7 @@ static Res freelistFindInZones(Bool *foundReturn, Range rangeReturn,
     Addr base, limit;
     if ((*search)(&base, &limit, freelistBlockBase(cur),
                   freelistBlockLimit(fl, cur),
-                  LandArena(land), zoneSet, size))
+                  LandArena(land), zoneSet, fineZoneSet, size))
     {
       found = TRUE;
       foundPrev = prev;
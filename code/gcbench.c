@@ -19,6 +19,12 @@
 #include <getopt.h>
 #endif
 
+#ifdef MPS_OS_LI
+#include <linux/perf_event.h> /* perf_event_attr, PERF_* */
+#include <sys/syscall.h> /* __NR_perf_event_open */
+#include <unistd.h> /* close, read, syscall */
+#endif
+
 #include <stdio.h> /* fprintf, printf, putchars, sscanf, stderr, stdout */
 #include <stdlib.h> /* alloca, exit, EXIT_FAILURE, EXIT_SUCCESS, strtoul */
 #include <time.h> /* clock, CLOCKS_PER_SEC */
@@ -55,7 +61,16 @@ static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
 static size_t arena_grain_size = 1; /* arena grain size */
 static unsigned pinleaf = FALSE;  /* are leaf objects pinned at start */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
+static size_t zones = ARENA_DEFAULT_ZONES; /* zones distinguished */
 static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
+static mps_bool_t background = ARENA_DEFAULT_BACKGROUND; /* collector thread */
+static mps_bool_t huge_pages = ARENA_DEFAULT_HUGE_PAGES; /* huge pages */
+static double spare_decay = ARENA_DEFAULT_SPARE_DECAY; /* spare decay time */
+static mps_bool_t report_rss = FALSE; /* report RSS after each iteration */
+static mps_bool_t report_dtlb = FALSE; /* report dTLB misses */
+static size_t fix_batch = 0;      /* references per MPS_FIX2_REFS, or 0 */
+
+#define FIX_BATCH_MAX 256
 
 typedef struct gcthread_s *gcthread_t;
 
@@ -156,6 +171,28 @@ static obj_t update_tree(mps_ap_t ap, obj_t oldtree, unsigned d) {
   return tree;
 }
 
+/* rss -- resident set size of the process in bytes, or 0 if unknown */
+
+static unsigned long rss(void)
+{
+#ifdef MPS_OS_LI
+  FILE *f;
+  unsigned long size, resident;
+  int n;
+
+  f = fopen("/proc/self/statm", "r");
+  if (f == NULL)
+    return 0;
+  n = fscanf(f, "%lu %lu", &size, &resident);
+  (void)fclose(f);
+  if (n != 2)
+    return 0;
+  return resident * (unsigned long)PageSize();
+#else
+  return 0;
+#endif
+}
+
 static void *gc_tree(gcthread_t thread) {
   unsigned i, j;
   mps_ap_t ap = thread->ap;
@@ -168,7 +205,117 @@ static void *gc_tree(gcthread_t thread) {
       if (pupdate > 0.0)
         tree = update_tree(ap, tree, depth);
     }
+    if (report_rss)
+      printf("rss: %u %lu\n", i, rss());
+  }
+  return NULL;
+}
+
+/* gc_fix -- fix-path microbenchmark
+ *
+ * Make 2^depth objects, then time MPS_FIX12 on references to them in
+ * random order, from a root that is scanned by fix_scan during a full
+ * collection.  The first pass over the references fixes the ones to
+ * white objects, so that the npass timed passes after it take the
+ * common path that rejects references to memory that isn't white,
+ * which the MPS_FIX1 zone test can't do in a heap that has outgrown
+ * the zones.  Run it with an unzoned arena smaller than the heap (for
+ * example -z -m 16M) so that these references pass MPS_FIX1.  The
+ * arena is parked so that the collections are those of
+ * mps_arena_collect.  With -b n, the references that pass MPS_FIX1
+ * are fixed n at a time by MPS_FIX2_REFS instead of one at a time by
+ * MPS_FIX2.
+ */
+
+static clock_t fix_time;          /* time spent in timed passes */
+static double fix_count;          /* references fixed in timed passes */
+
+static mps_res_t fix_pass(mps_ss_t ss, mps_addr_t *refs, size_t nrefs)
+{
+  mps_addr_t *fix[FIX_BATCH_MAX];
+  size_t k, n = 0;
+  mps_res_t res;
+  MPS_SCAN_BEGIN(ss) {
+    for (k = 0; k < nrefs; ++k) {
+      if (fix_batch == 0) {
+        res = MPS_FIX12(ss, &refs[k]);
+        if (res != MPS_RES_OK)
+          return res;
+      } else if (MPS_FIX1(ss, refs[k])) {
+        fix[n++] = &refs[k];
+        if (n == fix_batch) {
+          res = MPS_FIX2_REFS(ss, fix, n);
+          if (res != MPS_RES_OK)
+            return res;
+          n = 0;
+        }
+      }
+    }
+    if (n > 0) {
+      res = MPS_FIX2_REFS(ss, fix, n);
+      if (res != MPS_RES_OK)
+        return res;
+    }
+  } MPS_SCAN_END(ss);
+  return MPS_RES_OK;
+}
+
+static mps_res_t fix_scan(mps_ss_t ss, void *p, size_t s)
+{
+  mps_addr_t *refs = p;
+  clock_t begin;
+  unsigned j;
+  mps_res_t res;
+
+  res = fix_pass(ss, refs, s);
+  if (res != MPS_RES_OK)
+    return res;
+  begin = clock();
+  for (j = 0; j < npass; ++j) {
+    res = fix_pass(ss, refs, s);
+    if (res != MPS_RES_OK)
+      return res;
+  }
+  fix_time += clock() - begin;
+  fix_count += (double)npass * (double)s;
+  return MPS_RES_OK;
+}
+
+static void *gc_fix(gcthread_t thread) {
+  size_t nobj = (size_t)1 << depth, k;
+  obj_t *objs;
+  mps_addr_t *refs;
+  mps_root_t root;
+  unsigned i;
+  mps_ap_t ap = thread->ap;
+
+  objs = malloc(nobj * sizeof objs[0]);
+  refs = malloc(nobj * sizeof refs[0]);
+  if (objs == NULL || refs == NULL) {
+    fprintf(stderr, "out of memory for %lu references\n",
+            (unsigned long)nobj);
+    exit(EXIT_FAILURE);
   }
+  mps_arena_park(arena);
+  for (k = 0; k < nobj; ++k)
+    objs[k] = mkvector(ap, width);
+  for (k = 0; k < nobj; ++k)
+    refs[k] = (mps_addr_t)objs[rnd() % nobj];
+  free(objs);
+  RESMUST(mps_root_create(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                          fix_scan, refs, nobj));
+
+  for (i = 0; i < niter; ++i) {
+    fix_time = 0;
+    fix_count = 0.0;
+    RESMUST(mps_arena_collect(arena));
+    if (fix_count > 0.0)
+      printf("fix: %u %g ns per reference\n", i,
+             (double)fix_time / CLOCKS_PER_SEC * 1e9 / fix_count);
+  }
+
+  mps_root_destroy(root);
+  free(refs);
   return NULL;
 }
 
@@ -211,18 +358,82 @@ static void weave1(gcthread_fn_t fn)
 }
 
 
+/* dtlb_open -- start counting data TLB read misses
+ *
+ * Returns a file descriptor for reading the count, or -1 if counting
+ * isn't possible.  The count includes threads created later.
+ */
+
+static int dtlb_open(void)
+{
+#if defined(MPS_OS_LI) && defined(__NR_perf_event_open)
+  struct perf_event_attr attr;
+
+  memset(&attr, 0, sizeof attr);
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.size = sizeof attr;
+  attr.config = PERF_COUNT_HW_CACHE_DTLB
+    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  return -1;
+#endif
+}
+
+static void dtlb_close(int fd, const char *name)
+{
+#ifdef MPS_OS_LI
+  __u64 count;
+
+  if (fd >= 0) {
+    if (read(fd, &count, sizeof count) == (ssize_t)sizeof count)
+      printf("%s dTLB misses: %lu\n", name, (unsigned long)count);
+    (void)close(fd);
+    return;
+  }
+#else
+  UNUSED(fd);
+#endif
+  printf("%s dTLB misses: unavailable\n", name);
+}
+
+
 static void watch(gcthread_fn_t fn, const char *name)
 {
   clock_t begin, end;
+  int dtlb = -1;
+  size_t count, over;
+  double total, max;
   
+  if (report_dtlb)
+    dtlb = dtlb_open();
   begin = clock();
   if (nthreads == 1)
     weave1(fn);
   else
     weave(fn);
   end = clock();
+  if (report_dtlb)
+    dtlb_close(dtlb, name);
   
   printf("%s: %g\n", name, (double)(end - begin) / CLOCKS_PER_SEC);
+  mps_arena_purge_stats(arena, &count, &total, &max);
+  if (count > 0)
+    printf("%s purges: %lu mean: %g max: %g\n", name,
+           (unsigned long)count, total / (double)count, max);
+  mps_arena_pause_stats(arena, &count, &over, &total, &max);
+  if (count > 0)
+    printf("%s pauses: %lu over: %lu mean: %g max: %g total: %g\n", name,
+           (unsigned long)count, (unsigned long)over,
+           total / (double)count, max, total);
+  mps_arena_background_stats(arena, &count, &total);
+  if (count > 0)
+    printf("%s background steps: %lu total: %g\n", name,
+           (unsigned long)count, total);
 }
 
 
@@ -236,7 +447,11 @@ static void arena_setup(gcthread_fn_t fn,
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, arena_grain_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONES, zones);
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND, background);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_HUGE_PAGES, huge_pages);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SPARE_DECAY, spare_decay);
     RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
   RESMUST(dylan_fmt(&format, arena));
@@ -278,7 +493,14 @@ static struct option longopts[] = {
   {"pin-leaf",         no_argument,       NULL, 'l'},
   {"seed",             required_argument, NULL, 'x'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"arena-zones",      required_argument, NULL, 'Z'},
   {"pause-time",       required_argument, NULL, 'P'},
+  {"background",       no_argument,       NULL, 'B'},
+  {"huge-pages",       no_argument,       NULL, 'H'},
+  {"spare-decay",      required_argument, NULL, 'D'},
+  {"rss",              no_argument,       NULL, 'R'},
+  {"dtlb",             no_argument,       NULL, 'T'},
+  {"fix-batch",        required_argument, NULL, 'b'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -290,6 +512,7 @@ static struct {
 } pools[] = {
   {"amc", gc_tree, mps_class_amc},
   {"ams", gc_tree, mps_class_ams},
+  {"fix", gc_fix, mps_class_amc},
 };
 
 
@@ -302,7 +525,7 @@ int main(int argc, char *argv[]) {
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:",
+  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zZ:P:BHD:RTb:",
                            longopts, NULL)) != -1)
     switch (ch) {
     case 't':
@@ -393,9 +616,38 @@ int main(int argc, char *argv[]) {
     case 'z':
       zoned = FALSE;
       break;
+    case 'Z':
+      zones = strtoul(optarg, NULL, 10);
+      break;
     case 'P':
       pause_time = strtod(optarg, NULL);
       break;
+    case 'B':
+      background = TRUE;
+      break;
+    case 'H':
+      huge_pages = TRUE;
+      break;
+    case 'D':
+      spare_decay = strtod(optarg, NULL);
+      if (spare_decay < 0.0) {
+        fprintf(stderr, "Bad spare decay time %s\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'R':
+      report_rss = TRUE;
+      break;
+    case 'T':
+      report_dtlb = TRUE;
+      break;
+    case 'b':
+      fix_batch = (size_t)strtoul(optarg, NULL, 10);
+      if (fix_batch > FIX_BATCH_MAX) {
+        fprintf(stderr, "Bad fix batch %s\n", optarg);
+        return EXIT_FAILURE;
+      }
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -441,12 +693,32 @@ int main(int argc, char *argv[]) {
       fprintf(stderr,
               "  -z, --arena-unzoned\n"
               "    Disable zoned allocation in the arena\n"
+              "  -Z n, --arena-zones=n\n"
+              "    Number of zones distinguished (default %lu)\n"
               "  -P t, --pause-time\n"
               "    Maximum pause time in seconds (default %f) \n"
+              "  -B, --background\n"
+              "    Collect on a background thread\n",
+              (unsigned long)zones,
+              pause_time);
+      fprintf(stderr,
+              "  -H, --huge-pages\n"
+              "    Back leaf objects with transparent huge pages\n"
+              "  -D t, --spare-decay=t\n"
+              "    Return spare memory over t seconds (default %g)\n"
+              "  -R, --rss\n"
+              "    Report resident set size after each iteration\n"
+              "  -T, --dtlb\n"
+              "    Report data TLB read misses for each test\n"
+              "  -b n, --fix-batch=n\n"
+              "    Fix n references at a time in the fix test (default 0,\n"
+              "    meaning one at a time, up to %d)\n"
               "Tests:\n"
               "  amc   pool class AMC\n"
-              "  ams   pool class AMS\n",
-              pause_time);
+              "  ams   pool class AMS\n"
+              "  fix   fix path, on pool class AMC (try -z -m 16M)\n",
+              spare_decay,
+              FIX_BATCH_MAX);
       return EXIT_FAILURE;
     }
   argc -= optind;
@@ -25,6 +25,8 @@
 #include "poolmrg.h"
 #include "mps.h" /* finalization */
 #include "poolmv.h"
+#include "bg.h"
+#include "press.h"
 #include "mpm.h"
 
 SRCID(global, "$Id$");
@@ -119,12 +121,13 @@ Bool GlobalsCheck(Globals arenaGlobals)
   if (arenaGlobals->lock != NULL)
     CHECKD_NOSIG(Lock, arenaGlobals->lock);
 
-  /* no check possible on pollThreshold */
+  /* no check possible on pollThreshold or backgroundThreshold */
   CHECKL(BoolCheck(arenaGlobals->insidePoll));
   CHECKL(BoolCheck(arenaGlobals->clamped));
   CHECKL(arenaGlobals->fillMutatorSize >= 0.0);
   CHECKL(arenaGlobals->emptyMutatorSize >= 0.0);
   CHECKL(arenaGlobals->allocMutatorSize >= 0.0);
+  CHECKL(arenaGlobals->mutatorDebt >= 0.0);
   CHECKL(arenaGlobals->fillMutatorSize - arenaGlobals->emptyMutatorSize
          >= arenaGlobals->allocMutatorSize);
   CHECKL(arenaGlobals->fillInternalSize >= 0.0);
@@ -170,12 +173,27 @@ Bool GlobalsCheck(Globals arenaGlobals)
     CHECKL(TraceIdMessagesCheck(arena, ti));
   TRACE_SET_ITER_END(ti, trace, TraceSetUNIV, arena);
 
-  for(rank = RankMIN; rank < RankLIMIT; ++rank)
-    CHECKD_NOSIG(Ring, &arena->greyRing[rank]);
+  for(ti = 0; ti < TraceLIMIT; ++ti)
+    for(rank = RankMIN; rank < RankLIMIT; ++rank)
+      CHECKD_NOSIG(Ring, ArenaGreyRing(arena, ti, rank));
   CHECKD_NOSIG(Ring, &arena->chainRing);
 
   CHECKL(arena->tracedWork >= 0.0);
   CHECKL(arena->tracedTime >= 0.0);
+  CHECKD_NOSIG(Rate, &arena->scanRate);
+  CHECKD_NOSIG(Rate, &arena->reclaimRate);
+  /* no check for arena->quantumStart (Clock) */
+  CHECKL(arena->quantumTime >= 0.0);
+  CHECKL(ARENA_QUANTUM_SCALE_MIN <= arena->quantumScale);
+  CHECKL(arena->quantumScale <= 1.0);
+  CHECKL(arena->pauseAchieved >= 0.0);
+  CHECKL(arena->pauseOverCount <= arena->pauseCount);
+  CHECKL(arena->pauseTotal >= 0.0);
+  CHECKL(arena->pauseMax >= 0.0);
+  CHECKL(arena->backgroundTime >= 0.0);
+  /* no check for arena->pressureLast (Clock) */
+  CHECKL(BoolCheck(arena->pressureCollect));
+  /* no check for arena->pressureCollectLast (Clock) */
   /* no check for arena->lastWorldCollect (Clock) */
 
   /* can't write a check for arena->epoch */
@@ -235,11 +253,13 @@ Res GlobalsInit(Globals arenaGlobals)
   arenaGlobals->lock = NULL;
 
   arenaGlobals->pollThreshold = 0.0;
+  arenaGlobals->backgroundThreshold = 0.0;
   arenaGlobals->insidePoll = FALSE;
   arenaGlobals->clamped = FALSE;
   arenaGlobals->fillMutatorSize = 0.0;
   arenaGlobals->emptyMutatorSize = 0.0;
   arenaGlobals->allocMutatorSize = 0.0;
+  arenaGlobals->mutatorDebt = 0.0;
   arenaGlobals->fillInternalSize = 0.0;
   arenaGlobals->emptyInternalSize = 0.0;
 
@@ -266,6 +286,24 @@ Res GlobalsInit(Globals arenaGlobals)
   arena->flippedTraces = TraceSetEMPTY; /* <code/trace.c> */
   arena->tracedWork = 0.0;
   arena->tracedTime = 0.0;
+  RateInit(&arena->scanRate);
+  RateInit(&arena->reclaimRate);
+  arena->rateSample = 0;
+  arena->quantumStart = 0;
+  arena->quantumTime = 0.0;
+  arena->quantumScale = 1.0;
+  arena->pauseAchieved = 0.0;
+  arena->pauseCount = 0;
+  arena->pauseOverCount = 0;
+  arena->pauseTotal = 0.0;
+  arena->pauseMax = 0.0;
+  arena->backgroundCount = 0;
+  arena->backgroundTime = 0.0;
+  arena->pressureLast = 0;
+  arena->pressureCount = 0;
+  arena->pressureCollect = FALSE;
+  arena->pressureCollections = 0;
+  arena->pressureCollectLast = 0;
   arena->lastWorldCollect = ClockNow();
   ShieldInit(ArenaShield(arena));
 
@@ -279,8 +317,9 @@ Res GlobalsInit(Globals arenaGlobals)
     arena->tMessage[ti] = NULL;
   }
 
-  for(rank = RankMIN; rank < RankLIMIT; ++rank)
-    RingInit(&arena->greyRing[rank]);
+  for(ti = 0; ti < TraceLIMIT; ++ti)
+    for(rank = RankMIN; rank < RankLIMIT; ++rank)
+      RingInit(ArenaGreyRing(arena, ti, rank));
   STATISTIC(arena->writeBarrierHitCount = 0);
   RingInit(&arena->chainRing);
 
@@ -340,7 +379,8 @@ Res GlobalsCompleteCreate(Globals arenaGlobals)
 
   {
     GenParamStruct params[] = ChainDEFAULT;
-    res = ChainCreate(&arenaGlobals->defaultChain, arena, NELEMS(params), params);
+    res = ChainCreate(&arenaGlobals->defaultChain, arena, NELEMS(params),
+                      params, argsNone);
     if (res != ResOK)
       goto failChainCreate;
   }
@@ -360,6 +400,7 @@ void GlobalsFinish(Globals arenaGlobals)
 {
   Arena arena;
   Rank rank;
+  TraceId ti;
   
   arena = GlobalsArena(arenaGlobals);
   AVERT(Globals, arenaGlobals);
@@ -375,8 +416,9 @@ void GlobalsFinish(Globals arenaGlobals)
   RingFinish(&arena->messageRing);
   RingFinish(&arena->threadRing);
   RingFinish(&arena->deadRing);
-  for(rank = RankMIN; rank < RankLIMIT; ++rank)
-    RingFinish(&arena->greyRing[rank]);
+  for(ti = 0; ti < TraceLIMIT; ++ti)
+    for(rank = RankMIN; rank < RankLIMIT; ++rank)
+      RingFinish(ArenaGreyRing(arena, ti, rank));
   RingFinish(&arenaGlobals->rootRing);
   RingFinish(&arenaGlobals->poolRing);
   RingFinish(&arenaGlobals->globalRing);
@@ -397,12 +439,26 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
 
   AVERT(Globals, arenaGlobals);
 
+  arena = GlobalsArena(arenaGlobals);
+
+  /* The background thread was stopped by ArenaBackgroundStop before
+   * we entered the arena.  See <design/arena/#background.stop>. */
+  if (arena->background != NULL) {
+    BackgroundFinish(arena->background);
+    ControlFree(arena, arena->background, BackgroundSize());
+    arena->background = NULL;
+  }
+
+  if (arena->pressure != NULL) {
+    PressureFinish(arena->pressure);
+    ControlFree(arena, arena->pressure, PressureSize());
+    arena->pressure = NULL;
+  }
+
   /* Park the arena before destroying the default chain, to ensure
    * that there are no traces using that chain. */
   ArenaPark(arenaGlobals);
 
-  arena = GlobalsArena(arenaGlobals);
-
   arenaDenounce(arena);
 
   defaultChain = arenaGlobals->defaultChain;
@@ -470,8 +526,9 @@ void GlobalsPrepareToDestroy(Globals arenaGlobals)
   AVER(RingIsSingle(&arena->threadRing)); /* <design/check/#.common> */
   AVER(RingIsSingle(&arena->deadRing));
   AVER(RingIsSingle(&arenaGlobals->rootRing)); /* <design/check/#.common> */
-  for(rank = RankMIN; rank < RankLIMIT; ++rank)
-    AVER(RingIsSingle(&arena->greyRing[rank]));
+  for(ti = 0; ti < TraceLIMIT; ++ti)
+    for(rank = RankMIN; rank < RankLIMIT; ++rank)
+      AVER(RingIsSingle(ArenaGreyRing(arena, ti, rank)));
 
   /* At this point the following pools still exist:
    * 0. arena->freeCBSBlockPoolStruct
@@ -642,7 +699,7 @@ Bool ArenaAccess(Addr addr, AccessSet mode, MutatorFaultContext context)
       arenaReleaseRingLock();
       mode &= RootPM(root);
       if (mode != AccessSetEMPTY)
-        RootAccess(root, mode);
+        RootAccess(root, addr, mode);
       EVENT4(ArenaAccess, arena, count, addr, mode);
       ArenaLeave(arena);
       return TRUE;
@@ -696,6 +753,20 @@ void (ArenaPoll)(Globals globals)
   if (!PolicyPoll(arena))
     return;
 
+  /* Leave the work to the background thread, if there is one, unless
+   * it has fallen too far behind.  See <design/arena/#background.poll>. */
+  if (arena->background != NULL) {
+    BackgroundWake(arena->background);
+    if (globals->fillMutatorSize
+        < globals->backgroundThreshold + ARENA_BACKGROUND_LAG)
+    {
+      globals->pollThreshold = globals->fillMutatorSize + ArenaPollALLOCTIME;
+      return;
+    }
+  } else {
+    PolicyPressure(arena);
+  }
+
   globals->insidePoll = TRUE;
 
   /* fillMutatorSize has advanced; call TracePoll enough to catch up. */
@@ -709,11 +780,13 @@ void (ArenaPoll)(Globals globals)
     if (moreWork) {
       workWasDone = TRUE;
     }
-  } while (PolicyPollAgain(arena, start, moreWork, tracedWork));
+  } while (PolicyPollAgain(arena, start, moreWork, tracedWork, FALSE));
 
   /* Don't count time spent checking for work, if there was no work to do. */
   if (workWasDone) {
-    ArenaAccumulateTime(arena, start, ClockNow());
+    Clock end = ClockNow();
+    ArenaAccumulateTime(arena, start, end);
+    PolicyPause(arena, start, end, FALSE);
   }
 
   EVENT3(ArenaPoll, arena, start, BOOLOF(workWasDone));
@@ -722,6 +795,122 @@ void (ArenaPoll)(Globals globals)
 }
 
 
+/* ArenaBackgroundStart -- start the arena's background thread
+ *
+ * Called by ArenaCreate with the arena lock held.  The thread blocks
+ * in ArenaEnter until the lock is released.
+ */
+
+Res ArenaBackgroundStart(Arena arena)
+{
+  void *p;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(arena->background == NULL);
+
+  res = ControlAlloc(&p, arena, BackgroundSize());
+  if (res != ResOK)
+    return res;
+  res = BackgroundInit(p, arena);
+  if (res != ResOK) {
+    ControlFree(arena, p, BackgroundSize());
+    return res;
+  }
+  arena->background = p;
+  return ResOK;
+}
+
+
+/* ArenaPressureStart -- start monitoring memory pressure
+ *
+ * Called by ArenaCreate if the client passed
+ * MPS_KEY_ARENA_PRESSURE_PATH.  See <design/arena/#pressure>.
+ */
+
+Res ArenaPressureStart(Arena arena, const char *path)
+{
+  void *p;
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(path != NULL);
+  AVER(arena->pressure == NULL);
+
+  res = ControlAlloc(&p, arena, PressureSize());
+  if (res != ResOK)
+    return res;
+  res = PressureInit(p, arena, path);
+  if (res != ResOK) {
+    ControlFree(arena, p, PressureSize());
+    return res;
+  }
+  arena->pressure = p;
+  return ResOK;
+}
+
+
+/* ArenaBackgroundStop -- stop the arena's background thread, if any
+ *
+ * Must be called without the arena lock, because the thread may be
+ * waiting for it.  The thread's resources are released by
+ * GlobalsPrepareToDestroy.
+ */
+
+void ArenaBackgroundStop(Arena arena)
+{
+  AVER(TESTT(Arena, arena));
+  if (arena->background != NULL)
+    BackgroundStop(arena->background);
+}
+
+
+/* ArenaBackgroundStep -- do collection work on the background thread
+ *
+ * This is ArenaPoll without the test against the poll threshold: the
+ * background thread is there to do collection work, so it does as
+ * much as the policy allows within the arena's pause time.  Returns
+ * TRUE if there was work to do.  See <design/arena/#background>.
+ */
+
+Bool ArenaBackgroundStep(Arena arena)
+{
+  Globals globals;
+  Clock start;
+  Bool worldCollected = FALSE;
+  Bool moreWork, workWasDone = FALSE;
+  Work tracedWork;
+
+  ArenaEnter(arena);
+  globals = ArenaGlobals(arena);
+
+  PolicyPressure(arena);
+  PolicyDecay(arena);
+
+  if (!globals->clamped && !globals->insidePoll) {
+    globals->insidePoll = TRUE;
+    start = ClockNow();
+    EVENT3(ArenaPoll, arena, start, FALSE);
+    do {
+      moreWork = TracePoll(&tracedWork, &worldCollected, globals,
+                           !worldCollected);
+      if (moreWork)
+        workWasDone = TRUE;
+    } while (PolicyPollAgain(arena, start, moreWork, tracedWork, TRUE));
+    if (workWasDone) {
+      Clock end = ClockNow();
+      ArenaAccumulateTime(arena, start, end);
+      PolicyPause(arena, start, end, TRUE);
+    }
+    EVENT3(ArenaPoll, arena, start, BOOLOF(workWasDone));
+    globals->insidePoll = FALSE;
+  }
+
+  ArenaLeave(arena);
+  return workWasDone;
+}
+
+
 /* ArenaStep -- use idle time for collection work */
 
 Bool ArenaStep(Globals globals, double interval, double multiplier)
@@ -738,6 +927,8 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   arena = GlobalsArena(globals);
   clocks_per_sec = ClocksPerSec();
 
+  PolicyDecay(arena);
+
   start = now = ClockNow();
   intervalEnd = start + (Clock)(interval * clocks_per_sec);
   AVER(intervalEnd >= start);
@@ -827,6 +1018,21 @@ Res ArenaDefinalize(Arena arena, Ref obj)
 }
 
 
+/* ArenaDefinalizePool -- remove the finalization registrations of a pool
+ *
+ * Called by PoolDestroy.  See <design/finalize/#int.pool-destroy>.  */
+
+void ArenaDefinalizePool(Arena arena, Pool pool)
+{
+  AVERT(Arena, arena);
+  AVERT(Pool, pool);
+
+  if (arena->isFinalPool && pool != arena->finalPool
+      && PoolHasAttr(pool, AttrGC))
+    MRGDeregisterPool(arena->finalPool, pool);
+}
+
+
 /* Peek / Poke */
 
 Ref ArenaPeek(Arena arena, Ref *p)
@@ -963,6 +1169,8 @@ Res GlobalsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth)
                "lock $P\n", (WriteFP)arenaGlobals->lock,
                "pollThreshold $U kB\n",
                (WriteFU)(arenaGlobals->pollThreshold / 1024),
+               "backgroundThreshold $U kB\n",
+               (WriteFU)(arenaGlobals->backgroundThreshold / 1024),
                arenaGlobals->insidePoll ? "inside" : "outside", " poll\n",
                arenaGlobals->clamped ? "clamped\n" : "released\n",
                "fillMutatorSize $U kB\n",
@@ -971,6 +1179,8 @@ Res GlobalsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth)
                (WriteFU)(arenaGlobals->emptyMutatorSize / 1024),
                "allocMutatorSize $U kB\n",
                (WriteFU)(arenaGlobals->allocMutatorSize / 1024),
+               "mutatorDebt $U kB\n",
+               (WriteFU)(arenaGlobals->mutatorDebt / 1024),
                "fillInternalSize $U kB\n",
                (WriteFU)(arenaGlobals->fillInternalSize / 1024),
                "emptyInternalSize $U kB\n",
@@ -981,6 +1191,20 @@ Res GlobalsDescribe(Globals arenaGlobals, mps_lib_FILE *stream, Count depth)
                "threadSerial $U\n", (WriteFU)arena->threadSerial,
                "busyTraces    $B\n", (WriteFB)arena->busyTraces,
                "flippedTraces $B\n", (WriteFB)arena->flippedTraces,
+               "scanRate $D\n", (WriteFD)RateEstimate(&arena->scanRate),
+               "reclaimRate $D\n", (WriteFD)RateEstimate(&arena->reclaimRate),
+               "quantumTime $D\n", (WriteFD)arena->quantumTime,
+               "quantumScale $D\n", (WriteFD)arena->quantumScale,
+               "pauseAchieved $D\n", (WriteFD)arena->pauseAchieved,
+               "pauseCount $U\n", (WriteFU)arena->pauseCount,
+               "pauseOverCount $U\n", (WriteFU)arena->pauseOverCount,
+               "pauseTotal $D\n", (WriteFD)arena->pauseTotal,
+               "pauseMax $D\n", (WriteFD)arena->pauseMax,
+               "backgroundCount $U\n", (WriteFU)arena->backgroundCount,
+               "backgroundTime $D\n", (WriteFD)arena->backgroundTime,
+               "pressureCount $U\n", (WriteFU)arena->pressureCount,
+               "pressureCollect $S\n", WriteFYesNo(arena->pressureCollect),
+               "pressureCollections $U\n", (WriteFU)arena->pressureCollections,
                NULL);
   if (res != ResOK)
     return res;
@@ -0,0 +1,905 @@
+/* image.c: HEAP IMAGES
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Saves the formatted objects reachable from some roots in a
+ * parked arena to a file, and loads them from the file into another
+ * arena, so that a client can start with a heap it built earlier
+ * without allocating and initializing each object again.  See
+ * <design/image/>.
+ *
+ * .layout: The file consists of an ImageHeaderStruct, the roots
+ * (one word each), padding up to IMAGE_DATA_ALIGN, the objects, and
+ * the relocations (one word each).  All words are in the byte order
+ * of the platform that saved the image.
+ *
+ * .link: The objects are laid out in the image in address order, with
+ * the gaps between them closed up, and their references are rewritten
+ * to point to where the objects would be if the image were loaded at
+ * its link base, which is the old address of the first object.  Each
+ * relocation is the offset in the image of a reference, so that if the
+ * image is loaded at some other address, the loader adds the
+ * difference to each of them.  If it's loaded at its link base (for
+ * example, into a fresh arena that lays out its memory the same way)
+ * there is nothing to do.
+ */
+
+#include "image.h"
+#include "mpm.h"
+#include "mps.h"
+#include "table.h"
+#include "vm.h" /* PageSize */
+
+SRCID(image, "$Id$");
+
+
+#define ImageMAGIC      ((Word)0x4D505349) /* "MPSI" */
+#define ImageVERSION    ((Word)1)
+
+
+/* ImageHeaderStruct -- the header at the start of an image file */
+
+typedef struct ImageHeaderStruct {
+  Word magic;                   /* ImageMAGIC */
+  Word version;                 /* ImageVERSION */
+  Word wordSize;                /* size of a word, in bytes */
+  Word alignment;               /* alignment of the format */
+  Word headerSize;              /* header size of the format */
+  Word linkBase;                /* address that needs no relocation */
+  Word roots;                   /* number of roots */
+  Word dataOffset;              /* offset of the objects in the file */
+  Word dataSize;                /* size of the objects */
+  Word relocs;                  /* number of relocations */
+} ImageHeaderStruct;
+
+
+/* ImageRunStruct -- a run of adjacent objects in one segment */
+
+typedef struct ImageRunStruct {
+  Addr base;                    /* old address of first object */
+  Addr limit;                   /* old limit of last object */
+  Size offset;                  /* offset of base in the image */
+  Seg seg;                      /* segment containing the objects */
+} ImageRunStruct, *ImageRun;
+
+
+/* ImageSaveStruct -- state of an image being saved
+ *
+ * Defined as a subclass of ScanState, so that the fix methods can
+ * find it.  */
+
+#define ImageSaveSig    ((Sig)0x5191A6E5) /* SIGnature IMAGE Save */
+
+typedef struct ImageSaveStruct *ImageSave;
+
+typedef struct ImageSaveStruct {
+  ScanStateStruct ssStruct;     /* generic scan state object */
+  Format format;                /* format of the objects to save */
+  ImageFile file;               /* file being written */
+  Table marks;                  /* set of objects reached */
+  Addr *objects;                /* objects reached, see .trace */
+  Count objectCount;            /* number of objects reached */
+  Count objectMax;              /* capacity of objects array */
+  ImageRun runs;                /* runs in address order */
+  Count runCount;               /* number of runs */
+  Count runMax;                 /* capacity of runs array */
+  Size dataSize;                /* total size of the runs */
+  Addr image;                   /* copy of the objects, or NULL */
+  Size dataOffset;              /* offset of the objects in the file */
+  Word reloc[IMAGE_RELOC_BATCH]; /* relocations not yet written */
+  Count relocCount;             /* number of relocations in reloc */
+  Count relocs;                 /* total number of relocations */
+  Sig sig;                      /* <design/sig/> */
+} ImageSaveStruct;
+
+#define ImageSave2ScanState(save) (&(save)->ssStruct)
+#define ScanState2ImageSave(ss) PARENT(ImageSaveStruct, ssStruct, ss)
+#define ImageSaveArena(save) (ImageSave2ScanState(save)->arena)
+
+
+ATTRIBUTE_UNUSED
+static Bool ImageSaveCheck(ImageSave save)
+{
+  CHECKS(ImageSave, save);
+  CHECKD(ScanState, &save->ssStruct);
+  CHECKD(Format, save->format);
+  CHECKL(ImageFileCheck(save->file));
+  CHECKD_NOSIG(Table, save->marks);
+  CHECKL(save->objectCount <= save->objectMax);
+  CHECKL((save->objects == NULL) == (save->objectMax == 0));
+  CHECKL(save->runCount <= save->runMax);
+  CHECKL((save->runs == NULL) == (save->runMax == 0));
+  CHECKL(save->relocCount <= IMAGE_RELOC_BATCH);
+  CHECKL(save->relocCount <= save->relocs);
+  return TRUE;
+}
+
+
+/* imageGrow -- double the capacity of an array in the control pool */
+
+static Res imageGrow(void **arrayIO, Count *maxIO, Count count,
+                     Size elementSize, Arena arena)
+{
+  Count max = *maxIO == 0 ? IMAGE_ARRAY_MIN : *maxIO * 2;
+  void *p;
+  Res res;
+
+  AVER(count == *maxIO);
+
+  res = ControlAlloc(&p, arena, max * elementSize);
+  if (res != ResOK)
+    return res;
+  if (*arrayIO != NULL) {
+    (void)mps_lib_memcpy(p, *arrayIO, count * elementSize);
+    ControlFree(arena, *arrayIO, *maxIO * elementSize);
+  }
+  *arrayIO = p;
+  *maxIO = max;
+  return ResOK;
+}
+
+
+/* imageTableAlloc, imageTableFree -- memory for the set of marks */
+
+static void *imageTableAlloc(void *closure, size_t size)
+{
+  Arena arena = closure;
+  void *p;
+
+  if (ControlAlloc(&p, arena, size) != ResOK)
+    return NULL;
+  return p;
+}
+
+static void imageTableFree(void *closure, void *p, size_t size)
+{
+  Arena arena = closure;
+  ControlFree(arena, p, size);
+}
+
+
+/* imageSaveable -- is a segment's pool one whose objects are saved? */
+
+static Bool imageSaveable(ImageSave save, Seg seg)
+{
+  Pool pool = SegPool(seg);
+  return PoolHasAttr(pool, AttrGC) && PoolHasAttr(pool, AttrFMT)
+    && pool->format == save->format;
+}
+
+
+/* imageMark -- note that an object has been reached */
+
+static Res imageMark(ImageSave save, Addr object)
+{
+  TableValue value;
+  Res res;
+
+  if (TableLookup(&value, save->marks, (TableKey)object))
+    return ResOK;
+
+  if (save->objectCount == save->objectMax) {
+    void *p = save->objects;
+    res = imageGrow(&p, &save->objectMax, save->objectCount,
+                    sizeof(Addr), ImageSaveArena(save));
+    if (res != ResOK)
+      return res;
+    save->objects = p;
+  }
+  res = TableDefine(save->marks, (TableKey)object, NULL);
+  if (res != ResOK)
+    return res;
+  save->objects[save->objectCount] = object;
+  ++save->objectCount;
+  return ResOK;
+}
+
+
+/* imageMarkFix -- fix method that marks the objects referred to */
+
+static Res imageMarkFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
+{
+  ImageSave save = ScanState2ImageSave(ss);
+
+  UNUSED(pool);
+  AVERT(ImageSave, save);
+  AVER(refIO != NULL);
+
+  /* See <design/image/#save.unsaved>. */
+  if (!imageSaveable(save, seg))
+    return ResFAIL;
+
+  return imageMark(save, *refIO);
+}
+
+
+/* imageTrace -- find the objects reachable from the roots
+ *
+ * .trace: The objects array is the grey list: objects before the
+ * index have been scanned, and objects after it have not.  */
+
+static Res imageTrace(ImageSave save, Addr *roots, Count count)
+{
+  ScanState ss = ImageSave2ScanState(save);
+  Arena arena = ImageSaveArena(save);
+  Format format = save->format;
+  Index i;
+  Res res;
+  Bool b;
+  Seg seg = NULL;
+
+  for (i = 0; i < count; ++i) {
+    if (roots[i] == NULL)
+      continue;
+    if (!SegOfAddr(&seg, arena, roots[i]) || !imageSaveable(save, seg))
+      return ResPARAM;
+    res = imageMark(save, roots[i]);
+    if (res != ResOK)
+      return res;
+  }
+
+  ss->fix = imageMarkFix;
+  for (i = 0; i < save->objectCount; ++i) {
+    Addr object = save->objects[i];
+    b = SegOfAddr(&seg, arena, object);
+    AVER(b);
+    /* Leaf objects have no references. */
+    if (SegRankSet(seg) != RankSetEMPTY) {
+      ShieldExpose(arena, seg);
+      res = FormatScan(format, ss, object,
+                       (Addr)(*format->skip)(object));
+      ShieldCover(arena, seg);
+      if (res != ResOK)
+        return res;
+    }
+  }
+  return ResOK;
+}
+
+
+/* imageAddrCompare -- comparison for sorting the objects */
+
+static Compare imageAddrCompare(void *left, void *right, void *closure)
+{
+  UNUSED(closure);
+  if ((Addr)left < (Addr)right)
+    return CompareLESS;
+  else if (left == right)
+    return CompareEQUAL;
+  else
+    return CompareGREATER;
+}
+
+
+/* imageLayout -- lay out the objects in runs, see .link */
+
+static Res imageLayout(ImageSave save)
+{
+  Arena arena = ImageSaveArena(save);
+  Format format = save->format;
+  SortStruct sortStruct;
+  ImageRun run = NULL;
+  Index i;
+  Res res;
+
+  QuickSort((void **)save->objects, save->objectCount,
+            imageAddrCompare, UNUSED_POINTER, &sortStruct);
+
+  for (i = 0; i < save->objectCount; ++i) {
+    Addr object = save->objects[i];
+    Addr base, limit;
+    Bool b;
+    Seg seg = NULL;
+
+    b = SegOfAddr(&seg, arena, object);
+    AVER(b);
+    ShieldExpose(arena, seg);
+    limit = (Addr)(*format->skip)(object);
+    ShieldCover(arena, seg);
+    base = AddrSub(object, format->headerSize);
+    limit = AddrSub(limit, format->headerSize);
+    AVER(base < limit);
+    AVER(run == NULL || run->limit <= base);
+
+    if (run != NULL && run->seg == seg && run->limit == base) {
+      run->limit = limit;
+    } else {
+      if (save->runCount == save->runMax) {
+        void *p = save->runs;
+        res = imageGrow(&p, &save->runMax, save->runCount,
+                        sizeof(ImageRunStruct), arena);
+        if (res != ResOK)
+          return res;
+        save->runs = p;
+      }
+      run = &save->runs[save->runCount];
+      ++save->runCount;
+      run->base = base;
+      run->limit = limit;
+      run->offset = save->dataSize;
+      run->seg = seg;
+    }
+    save->dataSize += AddrOffset(base, limit);
+  }
+  return ResOK;
+}
+
+
+/* imageRunOfAddr -- find the run containing an old address */
+
+static ImageRun imageRunOfAddr(ImageSave save, Addr addr)
+{
+  Index lo = 0, hi = save->runCount;
+
+  while (lo < hi) {
+    Index mid = lo + (hi - lo) / 2;
+    ImageRun run = &save->runs[mid];
+    if (addr < run->base)
+      hi = mid;
+    else if (addr >= run->limit)
+      lo = mid + 1;
+    else
+      return run;
+  }
+  return NULL;
+}
+
+
+/* imageLinkBase -- the address at which the image needs no relocation */
+
+static Word imageLinkBase(ImageSave save)
+{
+  return save->runCount > 0 ? (Word)save->runs[0].base : 0;
+}
+
+
+/* imageCopyFix -- fix method that points references at the copies
+ *
+ * .copy: The fix method only gets a copy of the reference, not its
+ * location, so the references can't simply be recorded as they are
+ * fixed.  Instead, the objects are all copied into one block, and
+ * scanned there with a fix method that points each reference at the
+ * copy of its object.  The references are then found by comparing
+ * the copy with the original (see imageLink).  Pointing them at the
+ * copies, rather than straight at their link addresses, means that
+ * the format's scan method can still follow them (for example, to
+ * read an object's class from its wrapper).  The change survives any
+ * tagging the client does to a reference after fixing it.  */
+
+static Res imageCopyFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
+{
+  ImageSave save = ScanState2ImageSave(ss);
+  ImageRun run;
+  Ref ref;
+
+  UNUSED(pool);
+  UNUSED(seg);
+  AVERT(ImageSave, save);
+  AVER(refIO != NULL);
+
+  ref = *refIO;
+  run = imageRunOfAddr(save, ref);
+  AVER(run != NULL); /* imageTrace reached it */
+  *refIO = AddrAdd(save->image, run->offset + AddrOffset(run->base, ref));
+  return ResOK;
+}
+
+
+/* imageFlushRelocs -- write out the pending relocations */
+
+static Res imageFlushRelocs(ImageSave save)
+{
+  Size offset;
+  Res res;
+
+  AVERT(ImageSave, save);
+
+  offset = save->dataOffset + save->dataSize
+    + (save->relocs - save->relocCount) * sizeof(Word);
+  res = ImageFileWrite(save->file, offset, save->reloc,
+                       save->relocCount * sizeof(Word));
+  if (res != ResOK)
+    return res;
+  save->relocCount = 0;
+  return ResOK;
+}
+
+
+/* imageLink -- find and relink the references in a run, see .copy */
+
+static Res imageLink(ImageSave save, ImageRun run)
+{
+  Arena arena = ImageSaveArena(save);
+  Word *copy = (Word *)AddrAdd(save->image, run->offset);
+  Word *orig = (Word *)run->base;
+  Word delta = imageLinkBase(save) - (Word)save->image;
+  Size size = AddrOffset(run->base, run->limit);
+  Index i;
+  Res res = ResOK;
+
+  ShieldExpose(arena, run->seg);
+  for (i = 0; i < size / sizeof(Word); ++i) {
+    if (copy[i] != orig[i]) {
+      copy[i] += delta;
+      if (save->relocCount == IMAGE_RELOC_BATCH) {
+        res = imageFlushRelocs(save);
+        if (res != ResOK)
+          break;
+      }
+      save->reloc[save->relocCount] = (Word)(run->offset + i * sizeof(Word));
+      ++save->relocCount;
+      ++save->relocs;
+    }
+  }
+  ShieldCover(arena, run->seg);
+  return res;
+}
+
+
+/* imageWrite -- copy, relink and write the objects and roots */
+
+static Res imageWrite(ImageSave save, Addr *roots, Count count)
+{
+  ScanState ss = ImageSave2ScanState(save);
+  Arena arena = ImageSaveArena(save);
+  Format format = save->format;
+  ImageHeaderStruct header;
+  Size rootsSize = count * sizeof(Word);
+  Word *linked = NULL;
+  void *p;
+  Index i;
+  Res res;
+
+  save->dataOffset = SizeAlignUp(sizeof header + rootsSize,
+                                 IMAGE_DATA_ALIGN);
+
+  if (save->dataSize > 0) {
+    res = ControlAlloc(&p, arena, save->dataSize);
+    if (res != ResOK)
+      return res;
+    save->image = p;
+
+    for (i = 0; i < save->runCount; ++i) {
+      ImageRun run = &save->runs[i];
+      ShieldExpose(arena, run->seg);
+      (void)AddrCopy(AddrAdd(save->image, run->offset), run->base,
+                     AddrOffset(run->base, run->limit));
+      ShieldCover(arena, run->seg);
+    }
+
+    ss->fix = imageCopyFix;
+    for (i = 0; i < save->runCount; ++i) {
+      ImageRun run = &save->runs[i];
+      Addr base = AddrAdd(save->image, run->offset + format->headerSize);
+      Size size = AddrOffset(run->base, run->limit);
+      /* Leaf objects have no references. */
+      if (SegRankSet(run->seg) != RankSetEMPTY) {
+        res = FormatScan(format, ss, base, AddrAdd(base, size));
+        AVER(res == ResOK); /* imageCopyFix can't fail */
+      }
+    }
+
+    for (i = 0; i < save->runCount; ++i) {
+      res = imageLink(save, &save->runs[i]);
+      if (res != ResOK)
+        return res;
+    }
+    res = imageFlushRelocs(save);
+    if (res != ResOK)
+      return res;
+
+    res = ImageFileWrite(save->file, save->dataOffset, save->image,
+                         save->dataSize);
+    if (res != ResOK)
+      return res;
+  }
+
+  if (count > 0) {
+    res = ControlAlloc(&p, arena, rootsSize);
+    if (res != ResOK)
+      return res;
+    linked = p;
+    for (i = 0; i < count; ++i) {
+      ImageRun run;
+      if (roots[i] == NULL) {
+        linked[i] = 0;
+        continue;
+      }
+      run = imageRunOfAddr(save, roots[i]);
+      AVER(run != NULL); /* imageTrace reached it */
+      linked[i] = (Word)roots[i] - (Word)run->base + run->offset
+        + imageLinkBase(save);
+    }
+    res = ImageFileWrite(save->file, sizeof header, linked, rootsSize);
+    ControlFree(arena, linked, rootsSize);
+    if (res != ResOK)
+      return res;
+  }
+
+  /* Write the header last, so that a file that was only partly
+     written doesn't look like an image. */
+  header.magic = ImageMAGIC;
+  header.version = ImageVERSION;
+  header.wordSize = (Word)sizeof(Word);
+  header.alignment = (Word)format->alignment;
+  header.headerSize = (Word)format->headerSize;
+  header.linkBase = imageLinkBase(save);
+  header.roots = (Word)count;
+  header.dataOffset = (Word)save->dataOffset;
+  header.dataSize = (Word)save->dataSize;
+  header.relocs = (Word)save->relocs;
+  return ImageFileWrite(save->file, 0, &header, sizeof header);
+}
+
+
+/* ImageSaveObjects -- save the objects reachable from some roots
+ *
+ * Makes all the segments in automatically managed pools white for a
+ * minimal trace, so that the format's scan method passes references
+ * to the heap to the image fix methods, much as ArenaRootsWalk in
+ * walk.c does, but without calling the pools' whiten methods.  */
+
+static Res ImageSaveObjects(Arena arena, Format format, const char *path,
+                            Addr *roots, Count count)
+{
+  ImageSaveStruct saveStruct;
+  ImageSave save = &saveStruct;
+  ScanState ss = ImageSave2ScanState(save);
+  ImageFile file;
+  Table marks;
+  Trace trace;
+  void *p;
+  Res res;
+  Seg seg;
+
+  AVERT(Arena, arena);
+  AVERT(Format, format);
+  AVER(path != NULL);
+  AVER(count == 0 || roots != NULL);
+
+  res = ControlAlloc(&p, arena, ImageFileSize());
+  if (res != ResOK)
+    goto failFileAlloc;
+  file = p;
+  res = ImageFileOpen(file, arena, path, TRUE);
+  if (res != ResOK)
+    goto failFileOpen;
+
+  res = TableCreate(&marks, IMAGE_ARRAY_MIN, imageTableAlloc,
+                    imageTableFree, arena, (TableKey)0, (TableKey)-1);
+  if (res != ResOK)
+    goto failTable;
+
+  res = TraceCreate(&trace, arena, TraceStartWhyWALK);
+  if (res != ResOK)
+    goto failTrace;
+  if (SegFirst(&seg, arena)) {
+    do {
+      if (PoolHasAttr(SegPool(seg), AttrGC)) {
+        /* See <design/image/#save.white>. */
+        SegSetWhite(seg, TraceSetAdd(SegWhite(seg), trace));
+        trace->white = ZoneSetUnion(trace->white, ZoneSetOfSeg(arena, seg));
+        trace->fineWhite =
+          ZoneSetUnion(trace->fineWhite,
+                       FineZoneSetOfRange(arena, SegBase(seg), SegLimit(seg)));
+      }
+    } while (SegNext(&seg, arena, seg));
+  }
+  arena->flippedTraces = TraceSetAdd(arena->flippedTraces, trace);
+
+  ScanStateInit(ss, TraceSetSingle(trace), arena, RankEXACT, trace->white);
+  save->format = format;
+  save->file = file;
+  save->marks = marks;
+  save->objects = NULL;
+  save->objectCount = 0;
+  save->objectMax = 0;
+  save->runs = NULL;
+  save->runCount = 0;
+  save->runMax = 0;
+  save->dataSize = 0;
+  save->image = NULL;
+  save->dataOffset = 0;
+  save->relocCount = 0;
+  save->relocs = 0;
+  save->sig = ImageSaveSig;
+  AVERT(ImageSave, save);
+
+  res = imageTrace(save, roots, count);
+  if (res == ResOK)
+    res = imageLayout(save);
+  if (res == ResOK)
+    res = imageWrite(save, roots, count);
+  if (res == ResOK)
+    res = ImageFileCommit(file);
+
+  if (save->image != NULL)
+    ControlFree(arena, save->image, save->dataSize);
+  if (save->runs != NULL)
+    ControlFree(arena, save->runs, save->runMax * sizeof(ImageRunStruct));
+  if (save->objects != NULL)
+    ControlFree(arena, save->objects, save->objectMax * sizeof(Addr));
+  save->sig = SigInvalid;
+  ScanStateFinish(ss);
+
+  /* Turn segments black again. */
+  if (SegFirst(&seg, arena)) {
+    do {
+      if (PoolHasAttr(SegPool(seg), AttrGC)) {
+        SegSetGrey(seg, TraceSetDel(SegGrey(seg), trace));
+        SegSetWhite(seg, TraceSetDel(SegWhite(seg), trace));
+      }
+    } while (SegNext(&seg, arena, seg));
+  }
+  trace->state = TraceFINISHED;
+  TraceDestroyFinished(trace);
+failTrace:
+  TableDestroy(marks);
+failTable:
+  ImageFileClose(file);
+failFileOpen:
+  ControlFree(arena, file, ImageFileSize());
+failFileAlloc:
+  return res;
+}
+
+
+/* mps_arena_image_save -- save formatted objects to a file */
+
+mps_res_t mps_arena_image_save(mps_arena_t mps_arena, mps_fmt_t mps_fmt,
+                               const char *path, mps_addr_t *roots,
+                               size_t count)
+{
+  Arena arena = (Arena)mps_arena;
+  Format format = (Format)mps_fmt;
+  Res res;
+
+  ArenaEnter(arena);
+  AVER(TESTT(Format, format));
+  AVER(FormatArena(format) == arena);
+  AVER(path != NULL);
+  AVER(count == 0 || roots != NULL);
+  AVER(ArenaGlobals(arena)->clamped);          /* <design/image/#parked> */
+  AVER(arena->busyTraces == TraceSetEMPTY);    /* <design/image/#parked> */
+
+  res = ImageSaveObjects(arena, format, path, (Addr *)roots, count);
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+/* imageRelocate -- apply relocations to loaded objects */
+
+static Res imageRelocate(ImageFile file, ImageHeaderStruct *header,
+                         Addr base)
+{
+  Word reloc[IMAGE_RELOC_BATCH];
+  Word delta = (Word)base - header->linkBase;
+  Size offset = header->dataOffset + header->dataSize;
+  Count done, i, n;
+  Res res;
+
+  for (done = 0; done < header->relocs; done += n) {
+    n = header->relocs - done;
+    if (n > IMAGE_RELOC_BATCH)
+      n = IMAGE_RELOC_BATCH;
+    res = ImageFileRead(file, offset + done * sizeof(Word), reloc,
+                        n * sizeof(Word));
+    if (res != ResOK)
+      return res;
+    for (i = 0; i < n; ++i) {
+      Word *slot;
+      if (reloc[i] >= header->dataSize
+          || header->dataSize - reloc[i] < sizeof(Word)
+          || !WordIsAligned(reloc[i], sizeof(Word)))
+        return ResFAIL;
+      slot = (Word *)AddrAdd(base, reloc[i]);
+      *slot += delta;
+    }
+  }
+  return ResOK;
+}
+
+
+/* imageLoadObjects -- map or read the objects and relocate them
+ *
+ * See <design/image/#load.map>.  */
+
+static Res imageLoadObjects(ImageFile file, ImageHeaderStruct *header,
+                            Addr base)
+{
+  Size pageSize = PageSize();
+  Size size = header->dataSize;
+  Size mapped = 0;
+  Res res;
+
+  if (AddrIsAligned(base, pageSize)
+      && SizeIsAligned(header->dataOffset, pageSize))
+  {
+    mapped = SizeAlignDown(size, pageSize);
+    if (mapped > 0) {
+      res = ImageFileMap(file, header->dataOffset, base, mapped);
+      if (res == ResUNIMPL)
+        mapped = 0;
+      else if (res != ResOK)
+        return res;
+    }
+  }
+  if (mapped < size) {
+    res = ImageFileRead(file, header->dataOffset + mapped,
+                        AddrAdd(base, mapped), size - mapped);
+    if (res != ResOK)
+      return res;
+  }
+
+  /* See .link. */
+  if ((Word)base == header->linkBase)
+    return ResOK;
+  return imageRelocate(file, header, base);
+}
+
+
+/* ImageLoadBuffer -- load an image through a buffer */
+
+static Res ImageLoadBuffer(Buffer buffer, const char *path, Addr *roots,
+                           Count count)
+{
+  Arena arena = BufferArena(buffer);
+  Pool pool = BufferPool(buffer);
+  ImageHeaderStruct header;
+  ImageFile file;
+  Format format;
+  Addr base;
+  void *p;
+  Index i;
+  Res res;
+  Bool b;
+  Seg seg = NULL;
+
+  AVERT(Buffer, buffer);
+  AVER(path != NULL);
+  AVER(count == 0 || roots != NULL);
+
+  res = ControlAlloc(&p, arena, ImageFileSize());
+  if (res != ResOK)
+    goto failFileAlloc;
+  file = p;
+  res = ImageFileOpen(file, arena, path, FALSE);
+  if (res != ResOK)
+    goto failFileOpen;
+
+  res = ImageFileRead(file, 0, &header, sizeof header);
+  if (res != ResOK)
+    goto failHeader;
+  if (header.magic != ImageMAGIC
+      || header.version != ImageVERSION
+      || header.wordSize != sizeof(Word)
+      || header.dataOffset < sizeof header + header.roots * sizeof(Word))
+  {
+    res = ResFAIL;
+    goto failHeader;
+  }
+  if (!PoolFormat(&format, pool)
+      || header.alignment != format->alignment
+      || header.headerSize != format->headerSize
+      || !SizeIsAligned(header.dataSize, pool->alignment)
+      || header.roots != count)
+  {
+    res = ResPARAM;
+    goto failHeader;
+  }
+
+  if (count > 0) {
+    res = ImageFileRead(file, sizeof header, roots, count * sizeof(Word));
+    if (res != ResOK)
+      goto failHeader;
+  }
+
+  if (header.dataSize > 0) {
+    res = BufferReserve(&base, buffer, header.dataSize);
+    if (res != ResOK)
+      goto failHeader;
+    /* The objects all fit in one segment, since they were allocated
+       by one buffer. */
+    b = SegOfAddr(&seg, arena, base);
+    AVER(b);
+    ShieldExpose(arena, seg);
+    res = imageLoadObjects(file, &header, base);
+    if (res != ResOK) {
+      /* The buffer must be committed, so make the reserved block a
+         valid object. */
+      (*format->pad)(base, header.dataSize);
+    }
+    ShieldCover(arena, seg);
+    if (!BufferCommit(buffer, base, header.dataSize))
+      NOTREACHED; /* <design/image/#parked> */
+    if (res != ResOK)
+      goto failHeader;
+
+    for (i = 0; i < count; ++i)
+      if (roots[i] != NULL)
+        roots[i] = (Addr)((Word)roots[i] + (Word)base - header.linkBase);
+  }
+
+  ImageFileClose(file);
+  ControlFree(arena, file, ImageFileSize());
+  return ResOK;
+
+failHeader:
+  ImageFileClose(file);
+failFileOpen:
+  ControlFree(arena, file, ImageFileSize());
+failFileAlloc:
+  return res;
+}
+
+
+/* mps_ap_image_load -- load formatted objects from a file */
+
+mps_res_t mps_ap_image_load(mps_ap_t mps_ap, const char *path,
+                            mps_addr_t *roots, size_t count)
+{
+  Buffer buf = BufferOfAP(mps_ap);
+  Arena arena;
+  Res res;
+
+  AVER(mps_ap != NULL);
+  AVER(TESTT(Buffer, buf));
+  arena = BufferArena(buf);
+
+  ArenaEnter(arena);
+  AVERT(Buffer, buf);
+  AVER(path != NULL);
+  AVER(count == 0 || roots != NULL);
+  AVER(ArenaGlobals(arena)->clamped);          /* <design/image/#parked> */
+  AVER(arena->busyTraces == TraceSetEMPTY);    /* <design/image/#parked> */
+
+  res = ImageLoadBuffer(buf, path, (Addr *)roots, count);
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,128 @@
+/* image.h: HEAP IMAGE FILES
+ *
+ *  $Id$
+ *  Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ *  .purpose: Reads and writes the files in which heap images are
+ *  saved, and maps them into memory when they are loaded.  See
+ *  <design/image/>.  The file operations are platform specific (see
+ *  imageix.c, imagean.c); the image format and the saving and loading
+ *  of objects are in image.c.
+ */
+
+#ifndef image_h
+#define image_h
+
+#include "mpmtypes.h"
+
+
+#define ImageFileSig    ((Sig)0x5191A6EF) /* SIGnature IMAGE File */
+
+
+/* ImageFileSize -- return the size of an ImageFileStruct
+ *
+ * Supports allocation of image files in the control pool.
+ */
+
+extern size_t ImageFileSize(void);
+
+extern Bool ImageFileCheck(ImageFile file);
+
+
+/* ImageFileOpen -- open an image file
+ *
+ * If write is TRUE, a new file is created for writing, which only
+ * replaces the file at path when ImageFileCommit is called (so that
+ * an arena loaded from that file isn't disturbed); otherwise the file
+ * is opened for reading.  Returns ResIO if the file can't be opened,
+ * and ResUNIMPL on platforms without image files.
+ */
+
+extern Res ImageFileOpen(ImageFile file, Arena arena, const char *path,
+                         Bool write);
+
+
+/* ImageFileRead, ImageFileWrite -- transfer bytes at an offset
+ *
+ * Returns ResIO if the whole of the range can't be transferred, for
+ * example because the file is too short.
+ */
+
+extern Res ImageFileRead(ImageFile file, Size offset, void *buf,
+                         Size size);
+extern Res ImageFileWrite(ImageFile file, Size offset, const void *buf,
+                          Size size);
+
+
+/* ImageFileMap -- map part of a file into memory
+ *
+ * Replaces the memory in [base, base+size) with a private copy-on-write
+ * mapping of the file starting at offset.  The base, size and offset
+ * must all be aligned to the operating system page size.  Returns
+ * ResUNIMPL if the platform can't do this, in which case the caller
+ * should read the file instead.
+ */
+
+extern Res ImageFileMap(ImageFile file, Size offset, Addr base, Size size);
+
+
+/* ImageFileCommit -- replace the file at the path with the one written
+ *
+ * Only for files opened for writing.  Returns ResIO on failure.
+ */
+
+extern Res ImageFileCommit(ImageFile file);
+
+
+/* ImageFileClose -- close an image file
+ *
+ * If the file was opened for writing and not committed, it is
+ * discarded.
+ */
+
+extern void ImageFileClose(ImageFile file);
+
+
+#endif /* image_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,137 @@
+/* imagean.c: HEAP IMAGE FILES FOR ANSI
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: The MPS doesn't use the C library's file functions, so
+ * ImageFileOpen fails, and so saving or loading a heap image fails
+ * with MPS_RES_UNIMPL.  See <design/image/>.
+ */
+
+#include "image.h"
+#include "mpm.h"
+
+SRCID(imagean, "$Id$");
+
+
+typedef struct ImageFileStruct {
+  Sig sig;                      /* <design/sig/> */
+} ImageFileStruct;
+
+
+size_t (ImageFileSize)(void)
+{
+  return sizeof(ImageFileStruct);
+}
+
+
+Bool (ImageFileCheck)(ImageFile file)
+{
+  CHECKS(ImageFile, file);
+  return TRUE;
+}
+
+
+Res (ImageFileOpen)(ImageFile file, Arena arena, const char *path,
+                    Bool write)
+{
+  AVER(file != NULL);
+  AVER(TESTT(Arena, arena));
+  AVER(path != NULL);
+  AVERT(Bool, write);
+  UNUSED(file);
+  UNUSED(arena);
+  UNUSED(path);
+  return ResUNIMPL;
+}
+
+
+Res (ImageFileRead)(ImageFile file, Size offset, void *buf, Size size)
+{
+  AVERT(ImageFile, file);
+  AVER(buf != NULL);
+  UNUSED(offset);
+  UNUSED(size);
+  NOTREACHED;
+  return ResUNIMPL;
+}
+
+
+Res (ImageFileWrite)(ImageFile file, Size offset, const void *buf,
+                     Size size)
+{
+  AVERT(ImageFile, file);
+  AVER(buf != NULL);
+  UNUSED(offset);
+  UNUSED(size);
+  NOTREACHED;
+  return ResUNIMPL;
+}
+
+
+Res (ImageFileMap)(ImageFile file, Size offset, Addr base, Size size)
+{
+  AVERT(ImageFile, file);
+  UNUSED(offset);
+  UNUSED(base);
+  UNUSED(size);
+  NOTREACHED;
+  return ResUNIMPL;
+}
+
+
+Res (ImageFileCommit)(ImageFile file)
+{
+  AVERT(ImageFile, file);
+  NOTREACHED;
+  return ResUNIMPL;
+}
+
+
+void (ImageFileClose)(ImageFile file)
+{
+  AVERT(ImageFile, file);
+  NOTREACHED;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,307 @@
+/* imageix.c: HEAP IMAGE FILES FOR UNIX (ISH)
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Implements the image file interface (image.h) with
+ * pread(2), pwrite(2) and mmap(2).  See <design/image/>.
+ *
+ * .map: ImageFileMap maps the file over memory that the arena already
+ * owns, with MAP_FIXED and MAP_PRIVATE, so that pages of the image are
+ * read from the file (or shared with the page cache) only when they
+ * are touched, and are copied only when they are written.  The
+ * mapping replaces whatever was there, so the arena's notion of what
+ * is committed stays correct: the pages are still readable and
+ * writable, and when the arena later unmaps them vmix.c replaces them
+ * with an inaccessible anonymous mapping in the usual way.
+ *
+ * .map.fail: POSIX allows a failed mmap with MAP_FIXED to have
+ * removed the existing mapping, so on failure fresh anonymous pages
+ * are mapped in their place (as VMMap in vmix.c does), and the caller
+ * reads the file into them instead.
+ *
+ * .short: The file size is checked before mapping, because touching a
+ * page of a mapping beyond the end of the file raises SIGBUS rather
+ * than returning an error.
+ *
+ * .replace: Pages of a private mapping that haven't been written still
+ * come from the file, so a file that is mapped by a loaded arena must
+ * not be changed in place: truncating it would make those pages raise
+ * SIGBUS, and overwriting it would change the heap.  So ImageFileOpen
+ * doesn't write to the file itself when saving, but to a temporary
+ * file next to it, and ImageFileCommit renames the temporary file
+ * over it, which leaves any mapped file intact until it is unmapped.
+ * If the save fails, ImageFileClose removes the temporary file.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h> /* rename */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "image.h"
+#include "mpm.h"
+#include "vm.h"
+
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_XC) && !defined(MPS_OS_LI)
+#error "imageix.c is Unix-like specific, currently MPS_OS_FR XC LI"
+#endif
+
+SRCID(imageix, "$Id$");
+
+
+typedef struct ImageFileStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* arena using the file */
+  int fd;                       /* file descriptor */
+  const char *path;             /* path to save to, or NULL if loading */
+  char *temp;                   /* temporary file being saved, or NULL */
+  Size tempSize;                /* size of temp buffer */
+} ImageFileStruct;
+
+
+size_t (ImageFileSize)(void)
+{
+  return sizeof(ImageFileStruct);
+}
+
+
+Bool (ImageFileCheck)(ImageFile file)
+{
+  CHECKS(ImageFile, file);
+  CHECKL(TESTT(Arena, file->arena));
+  CHECKL(file->fd >= 0);
+  CHECKL((file->temp == NULL) || (file->path != NULL));
+  return TRUE;
+}
+
+
+/* imageTempPath -- make the path of the temporary file for a save
+ *
+ * The temporary file is the path with ".tmp" and the process id
+ * appended, so that it is in the same directory (and so on the same
+ * file system) as the file it replaces.  See .replace.
+ */
+
+static Res imageTempPath(char **tempReturn, Size *sizeReturn, Arena arena,
+                         const char *path)
+{
+  static const char suffix[] = ".tmp";
+  char digits[sizeof(unsigned long) * 3];
+  unsigned long pid = (unsigned long)getpid();
+  Size len, nDigits = 0, i;
+  char *temp;
+  void *p;
+  Res res;
+
+  do {
+    digits[nDigits++] = (char)('0' + pid % 10);
+    pid /= 10;
+  } while (pid != 0);
+
+  len = StringLength(path);
+  res = ControlAlloc(&p, arena, len + sizeof suffix + nDigits);
+  if (res != ResOK)
+    return res;
+  temp = p;
+  (void)mps_lib_memcpy(temp, path, len);
+  (void)mps_lib_memcpy(temp + len, suffix, sizeof suffix - 1);
+  len += sizeof suffix - 1;
+  for (i = 0; i < nDigits; ++i)
+    temp[len + i] = digits[nDigits - 1 - i];
+  temp[len + nDigits] = '\0';
+
+  *tempReturn = temp;
+  *sizeReturn = len + nDigits + 1;
+  return ResOK;
+}
+
+
+Res (ImageFileOpen)(ImageFile file, Arena arena, const char *path,
+                    Bool write)
+{
+  char *temp = NULL;
+  Size tempSize = 0;
+  int fd;
+
+  AVER(file != NULL);
+  AVER(TESTT(Arena, arena));
+  AVER(path != NULL);
+  AVERT(Bool, write);
+
+  if (write) {
+    /* See .replace. */
+    Res res = imageTempPath(&temp, &tempSize, arena, path);
+    if (res != ResOK)
+      return res;
+    fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+      ControlFree(arena, temp, tempSize);
+      return ResIO;
+    }
+  } else {
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+      return ResIO;
+  }
+
+  file->arena = arena;
+  file->fd = fd;
+  file->path = write ? path : NULL;
+  file->temp = temp;
+  file->tempSize = tempSize;
+  file->sig = ImageFileSig;
+  AVERT(ImageFile, file);
+  return ResOK;
+}
+
+
+Res (ImageFileRead)(ImageFile file, Size offset, void *buf, Size size)
+{
+  char *p = buf;
+
+  AVERT(ImageFile, file);
+  AVER(buf != NULL);
+
+  while (size > 0) {
+    ssize_t n = pread(file->fd, p, size, (off_t)offset);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return ResIO;
+    p += n;
+    offset += (Size)n;
+    size -= (Size)n;
+  }
+  return ResOK;
+}
+
+
+Res (ImageFileWrite)(ImageFile file, Size offset, const void *buf,
+                     Size size)
+{
+  const char *p = buf;
+
+  AVERT(ImageFile, file);
+  AVER(buf != NULL);
+
+  while (size > 0) {
+    ssize_t n = pwrite(file->fd, p, size, (off_t)offset);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return ResIO;
+    p += n;
+    offset += (Size)n;
+    size -= (Size)n;
+  }
+  return ResOK;
+}
+
+
+Res (ImageFileMap)(ImageFile file, Size offset, Addr base, Size size)
+{
+  struct stat st;
+  void *addr;
+
+  AVERT(ImageFile, file);
+  AVER(SizeIsAligned(offset, PageSize()));
+  AVER(AddrIsAligned(base, PageSize()));
+  AVER(SizeIsAligned(size, PageSize()));
+
+  /* See .short. */
+  if (fstat(file->fd, &st) != 0
+      || st.st_size < 0
+      || (Size)st.st_size < offset
+      || (Size)st.st_size - offset < size)
+    return ResIO;
+
+  addr = mmap((void *)base, size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_FIXED, file->fd, (off_t)offset);
+  if (addr == MAP_FAILED) {
+    /* See .map.fail. */
+    addr = mmap((void *)base, size, PROT_READ | PROT_WRITE,
+                MAP_ANON | MAP_PRIVATE | MAP_FIXED, -1, 0);
+    if (addr == MAP_FAILED)
+      return ResMEMORY;
+    return ResUNIMPL;
+  }
+  AVER(addr == (void *)base);
+
+  return ResOK;
+}
+
+
+Res (ImageFileCommit)(ImageFile file)
+{
+  AVERT(ImageFile, file);
+  AVER(file->temp != NULL);
+
+  /* See .replace. */
+  if (fsync(file->fd) != 0 || rename(file->temp, file->path) != 0)
+    return ResIO;
+  ControlFree(file->arena, file->temp, file->tempSize);
+  file->temp = NULL;
+  return ResOK;
+}
+
+
+void (ImageFileClose)(ImageFile file)
+{
+  AVERT(ImageFile, file);
+  file->sig = SigInvalid;
+  (void)close(file->fd);
+  if (file->temp != NULL) {
+    /* The save failed, so leave the old file alone.  See .replace. */
+    (void)unlink(file->temp);
+    ControlFree(file->arena, file->temp, file->tempSize);
+  }
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -372,7 +372,7 @@ Bool LandFindLargest(Range rangeReturn, Range oldRangeReturn, Land land, Size si
  * See <design/land/#function.find.zones>
  */
 
-Res LandFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, Bool high)
+Res LandFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, ZoneSet fineZoneSet, Bool high)
 {
   Res res;
 
@@ -386,7 +386,7 @@ Res LandFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn,
   landEnter(land);
 
   res = Method(Land, land, findInZones)(foundReturn, rangeReturn, oldRangeReturn,
-                                    land, size, zoneSet, high);
+                                    land, size, zoneSet, fineZoneSet, high);
 
   landLeave(land);
   return res;
@@ -542,7 +542,7 @@ static Bool landNoFind(Range rangeReturn, Range oldRangeReturn, Land land, Size
   return ResUNIMPL;
 }
 
-static Res landNoFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, Bool high)
+static Res landNoFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, ZoneSet fineZoneSet, Bool high)
 {
   AVER(foundReturn != NULL);
   AVER(rangeReturn != NULL);
@@ -550,6 +550,7 @@ static Res landNoFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRang
   AVERC(Land, land);
   UNUSED(size);
   UNUSED(zoneSet);
+  UNUSED(fineZoneSet);
   AVERT(Bool, high);
   return ResUNIMPL;
 }
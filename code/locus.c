@@ -27,6 +27,8 @@ Bool LocusPrefCheck(LocusPref pref)
   CHECKL(BoolCheck(pref->high));
   /* zones can't be checked because it's arbitrary. */
   /* avoid can't be checked because it's arbitrary. */
+  CHECKL(pref->node == NodeANY || pref->node < MPS_WORD_WIDTH);
+  /* fineZones can't be checked because it's arbitrary. */
   return TRUE;
 }
 
@@ -71,6 +73,17 @@ void LocusPrefExpress(LocusPref pref, LocusPrefKind kind, void *p)
     pref->zones = *(ZoneSet *)p;
     break;
 
+  case LocusPrefNODE:
+    AVER(p != NULL);
+    AVER(*(Index *)p == NodeANY || *(Index *)p < MPS_WORD_WIDTH);
+    pref->node = *(Index *)p;
+    break;
+
+  case LocusPrefFINEZONESET:
+    AVER(p != NULL);
+    pref->fineZones = *(ZoneSet *)p;
+    break;
+
   default:
     /* Unknown kinds are ignored for binary compatibility. */
     break;
@@ -94,6 +107,8 @@ Res LocusPrefDescribe(LocusPref pref, mps_lib_FILE *stream, Count depth)
                "  high $S\n", WriteFYesNo(pref->high),
                "  zones $B\n", (WriteFB)pref->zones,
                "  avoid $B\n", (WriteFB)pref->avoid,
+               "  node $U\n", (WriteFU)pref->node,
+               "  fineZones $B\n", (WriteFB)pref->fineZones,
                "} LocusPref $P\n", (WriteFP)pref,
                NULL);
   return res;
@@ -108,8 +123,12 @@ Bool GenDescCheck(GenDesc gen)
   CHECKS(GenDesc, gen);
   /* nothing to check for zones */
   /* nothing to check for capacity */
-  CHECKL(gen->mortality >= 0.0);
-  CHECKL(gen->mortality <= 1.0);
+  CHECKL(gen->limit.minCapacity <= gen->capacity);
+  CHECKL(gen->capacity <= gen->limit.maxCapacity);
+  CHECKL(0.0 <= gen->limit.minMortality);
+  CHECKL(gen->limit.minMortality <= gen->mortality);
+  CHECKL(gen->mortality <= gen->limit.maxMortality);
+  CHECKL(gen->limit.maxMortality <= 1.0);
   CHECKD_NOSIG(Ring, &gen->locusRing);
   CHECKD_NOSIG(Ring, &gen->segRing);
   return TRUE;
@@ -129,15 +148,57 @@ static Bool GenParamCheck(GenParamStruct *params)
 }
 
 
-/* GenDescInit -- initialize a generation in a chain */
+/* GenLimitCheck -- check consistency of generation tuning limits
+ *
+ * The initial parameters of the generation must lie within the
+ * limits. See <design/strategy/#policy.tune>.
+ */
+
+ATTRIBUTE_UNUSED
+static Bool GenLimitCheck(GenLimitStruct *limit, GenParamStruct *params)
+{
+  CHECKL(limit != NULL);
+  CHECKL(limit->minCapacity > 0);
+  CHECKL(limit->minCapacity <= params->capacity);
+  CHECKL(params->capacity <= limit->maxCapacity);
+  CHECKL(0.0 <= limit->minMortality);
+  CHECKL(limit->minMortality <= params->mortality);
+  CHECKL(params->mortality <= limit->maxMortality);
+  CHECKL(limit->maxMortality <= 1.0);
+  return TRUE;
+}
+
+
+/* GenDescInit -- initialize a generation in a chain
+ *
+ * If limit is NULL, the capacity of the generation is fixed, and its
+ * predicted mortality may take any value.
+ */
 
-static void GenDescInit(GenDesc gen, GenParamStruct *params)
+static void GenDescInit(GenDesc gen, GenParamStruct *params,
+                        GenLimitStruct *limit)
 {
+  Index i;
+
   AVER(gen != NULL);
   AVER(GenParamCheck(params));
   gen->zones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(gen->zoneSize); ++i)
+    gen->zoneSize[i] = 0;
+  gen->fineZones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(gen->fineZoneSize); ++i)
+    gen->fineZoneSize[i] = 0;
   gen->capacity = params->capacity;
   gen->mortality = params->mortality;
+  if (limit == NULL) {
+    gen->limit.minCapacity = params->capacity;
+    gen->limit.maxCapacity = params->capacity;
+    gen->limit.minMortality = 0.0;
+    gen->limit.maxMortality = 1.0;
+  } else {
+    AVER(GenLimitCheck(limit, params));
+    gen->limit = *limit;
+  }
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
   gen->sig = GenDescSig;
@@ -150,6 +211,8 @@ static void GenDescInit(GenDesc gen, GenParamStruct *params)
 static void GenDescFinish(GenDesc gen)
 {
   AVERT(GenDesc, gen);
+  AVER(gen->zones == ZoneSetEMPTY); /* all segments freed */
+  AVER(gen->fineZones == ZoneSetEMPTY);
   RingFinish(&gen->locusRing);
   RingFinish(&gen->segRing);
   gen->sig = SigInvalid;
@@ -190,6 +253,43 @@ static void genDescStartTrace(GenDesc gen, Trace trace)
 }
 
 
+/* genDescTune -- adjust the capacity of a generation
+ *
+ * A generation whose objects mostly survive is being collected too
+ * soon, so its capacity grows to give the objects time to die; a
+ * generation whose objects nearly all die can be collected sooner, so
+ * its capacity shrinks to save memory. The capacity stays within the
+ * limits set by the client. See <design/strategy/#policy.tune>.
+ */
+
+static void genDescTune(GenDesc gen, Trace trace)
+{
+  double capacity = (double)gen->capacity;
+  Size oldCapacity = gen->capacity;
+
+  AVERT(GenDesc, gen);
+  AVERT(Trace, trace);
+
+  if (gen->mortality < LocusTuneLOW)
+    capacity *= LocusTuneGROW;
+  else if (gen->mortality > LocusTuneHIGH)
+    capacity *= LocusTuneSHRINK;
+  else
+    return;
+
+  if (capacity < (double)gen->limit.minCapacity)
+    gen->capacity = gen->limit.minCapacity;
+  else if (capacity > (double)gen->limit.maxCapacity)
+    gen->capacity = gen->limit.maxCapacity;
+  else
+    gen->capacity = (Size)capacity;
+
+  if (gen->capacity != oldCapacity)
+    EVENT5(GenTune, trace, gen, oldCapacity, gen->capacity, gen->mortality);
+  AVERT(GenDesc, gen);
+}
+
+
 /* genDescEndTrace -- notify generation of end of a trace */
 
 static void genDescEndTrace(GenDesc gen, Trace trace)
@@ -208,8 +308,14 @@ static void genDescEndTrace(GenDesc gen, Trace trace)
     double mortality = 1.0 - survived / (double)stats->condemned;
     double alpha = LocusMortalityALPHA;
     gen->mortality = gen->mortality * (1 - alpha) + mortality * alpha;
+    if (gen->mortality < gen->limit.minMortality)
+      gen->mortality = gen->limit.minMortality;
+    else if (gen->mortality > gen->limit.maxMortality)
+      gen->mortality = gen->limit.maxMortality;
     EVENT6(TraceEndGen, trace, gen, stats->condemned, stats->forwarded,
            stats->preservedInPlace, gen->mortality);
+    if (gen->limit.minCapacity < gen->limit.maxCapacity)
+      genDescTune(gen, trace);
   }
 }
 
@@ -281,8 +387,15 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
   res = WriteF(stream, depth,
                "GenDesc $P {\n", (WriteFP)gen,
                "  zones $B\n", (WriteFB)gen->zones,
+               "  fineZones $B\n", (WriteFB)gen->fineZones,
                "  capacity $W\n", (WriteFW)gen->capacity,
                "  mortality $D\n", (WriteFD)gen->mortality,
+               "  limit {\n",
+               "    minCapacity $W\n", (WriteFW)gen->limit.minCapacity,
+               "    maxCapacity $W\n", (WriteFW)gen->limit.maxCapacity,
+               "    minMortality $D\n", (WriteFD)gen->limit.minMortality,
+               "    maxMortality $D\n", (WriteFD)gen->limit.maxMortality,
+               "  }\n",
                NULL);
   if (res != ResOK)
     return res;
@@ -334,14 +447,24 @@ static void ChainInit(ChainStruct *chain, Arena arena, GenDescStruct *gens,
 }
 
 
-/* ChainCreate -- create a generation chain */
+/* ChainCreate -- create a generation chain
+ *
+ * If the MPS_KEY_CHAIN_LIMITS keyword argument is present, it points
+ * to an array of genCount limits within which the capacity and
+ * predicted mortality of each generation are tuned. See
+ * <design/strategy/#policy.tune>.
+ */
+
+ARG_DEFINE_KEY(CHAIN_LIMITS, Pointer);
 
 Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
-                GenParamStruct *params)
+                GenParamStruct *params, ArgList args)
 {
   size_t i;
   Chain chain;
   GenDescStruct *gens;
+  GenLimitStruct *limits = NULL;
+  ArgStruct arg;
   Res res;
   void *p;
 
@@ -349,6 +472,10 @@ Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
   AVERT(Arena, arena);
   AVER(genCount > 0);
   AVER(params != NULL);
+  AVERT(ArgList, args);
+
+  if (ArgPick(&arg, args, MPS_KEY_CHAIN_LIMITS))
+    limits = arg.val.p;
 
   res = ControlAlloc(&p, arena, genCount * sizeof(GenDescStruct));
   if (res != ResOK)
@@ -356,7 +483,7 @@ Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
   gens = (GenDescStruct *)p;
 
   for (i = 0; i < genCount; ++i)
-    GenDescInit(&gens[i], &params[i]);
+    GenDescInit(&gens[i], &params[i], limits == NULL ? NULL : &limits[i]);
 
   res = ControlAlloc(&p, arena, sizeof(ChainStruct));
   if (res != ResOK)
@@ -603,19 +730,107 @@ static void PoolGenAccountForAlloc(PoolGen pgen, Size size)
 }  
 
 
+/* genZonesAdd, genZonesRemove -- a generation starts or stops using zones
+ *
+ * Keep track of the zones used by more than one generation, so that
+ * PolicyAlloc can steer new segments away from them.  See
+ * <design/arena/#zone.shared>.
+ */
+
+static void genZonesAdd(Arena arena, GenDesc gen, ZoneSet zones)
+{
+  Index zone;
+
+  if (zones == ZoneSetEMPTY)
+    return;
+  AVER(ZoneSetInter(gen->zones, zones) == ZoneSetEMPTY);
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+    if (ZoneSetIsMember(zones, zone)) {
+      ++arena->zoneGens[zone];
+      if (arena->zoneGens[zone] > 1)
+        arena->sharedZones = BS_ADD(ZoneSet, arena->sharedZones, zone);
+    }
+  }
+  gen->zones = ZoneSetUnion(gen->zones, zones);
+
+  /* Tracking the whole zoneset for each generation gives more
+   * understandable telemetry than just reporting the added zones. */
+  EVENT3(ArenaGenZoneAdd, arena, gen, gen->zones);
+}
+
+static void genZonesRemove(Arena arena, GenDesc gen, ZoneSet zones)
+{
+  Index zone;
+
+  if (zones == ZoneSetEMPTY)
+    return;
+  AVER(ZoneSetSub(zones, gen->zones));
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+    if (ZoneSetIsMember(zones, zone)) {
+      AVER(arena->zoneGens[zone] > 0);
+      --arena->zoneGens[zone];
+      if (arena->zoneGens[zone] <= 1)
+        arena->sharedZones = BS_DEL(ZoneSet, arena->sharedZones, zone);
+    }
+  }
+  gen->zones = ZoneSetDiff(gen->zones, zones);
+  EVENT3(ArenaGenZoneRemove, arena, gen, gen->zones);
+}
+
+
+/* genFineZonesAdd, genFineZonesRemove -- a generation starts or stops
+ * using fine zones
+ *
+ * Keep track of the fine zones used by any generation, so that
+ * PoolGenAlloc can keep each generation to its own fine zones when it
+ * has to share zones.  Only done when the arena has fine zones.  See
+ * <design/arena/#zone.fine.locus>.
+ */
+
+static void genFineZonesAdd(Arena arena, GenDesc gen, ZoneSet zones)
+{
+  Index zone;
+
+  AVER(ZoneSetInter(gen->fineZones, zones) == ZoneSetEMPTY);
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+    if (ZoneSetIsMember(zones, zone)) {
+      ++arena->fineZoneGens[zone];
+      arena->usedFineZones = BS_ADD(ZoneSet, arena->usedFineZones, zone);
+    }
+  }
+  gen->fineZones = ZoneSetUnion(gen->fineZones, zones);
+}
+
+static void genFineZonesRemove(Arena arena, GenDesc gen, ZoneSet zones)
+{
+  Index zone;
+
+  AVER(ZoneSetSub(zones, gen->fineZones));
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+    if (ZoneSetIsMember(zones, zone)) {
+      AVER(arena->fineZoneGens[zone] > 0);
+      --arena->fineZoneGens[zone];
+      if (arena->fineZoneGens[zone] == 0)
+        arena->usedFineZones = BS_DEL(ZoneSet, arena->usedFineZones, zone);
+    }
+  }
+  gen->fineZones = ZoneSetDiff(gen->fineZones, zones);
+}
+
+
 /* PoolGenAlloc -- allocate a segment in a pool generation
  *
  * Allocate a GCSeg, attach it to the generation, and update the
- * accounting.
+ * accounting.  The node is the preferred NUMA node (usually that of
+ * the buffer being filled), or NodeANY for the pool's.
  */
 
 Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass class, Size size,
-                 ArgList args)
+                 Index node, ArgList args)
 {
   LocusPrefStruct pref;
   Res res;
   Seg seg;
-  ZoneSet zones, moreZones;
   Arena arena;
   GenDesc gen;
 
@@ -627,27 +842,34 @@ Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass class, Size size,
 
   arena = PoolArena(pgen->pool);
   gen = pgen->gen;
-  zones = gen->zones;
 
   LocusPrefInit(&pref);
   pref.high = FALSE;
-  pref.zones = zones;
+  pref.zones = gen->zones;
   pref.avoid = ZoneSetBlacklist(arena);
+  if (PoolHasAttr(pgen->pool, AttrMOVINGGC))
+    pref.avoid = ZoneSetUnion(pref.avoid, arena->ambigBlacklist);
+  LocusPrefExpress(&pref, LocusPrefNODE, &node);
+  /* Prefer the generation's own fine zones, and those of no other.
+     Fine stripes smaller than a grain can't be chosen between. */
+  if (arena->zoneFineBits > 0
+      && ((Size)1 << arena->fineZoneShift) >= ArenaGrainSize(arena)) {
+    ZoneSet fineZones = ZoneSetUnion(gen->fineZones,
+                                     ZoneSetComp(arena->usedFineZones));
+    LocusPrefExpress(&pref, LocusPrefFINEZONESET, &fineZones);
+  }
   res = SegAlloc(&seg, class, &pref, size, pgen->pool, args);
   if (res != ResOK)
     return res;
 
   RingAppend(&gen->segRing, &SegGCSeg(seg)->genRing);
 
-  moreZones = ZoneSetUnion(zones, ZoneSetOfSeg(arena, seg));
-  gen->zones = moreZones;
-  
-  if (!ZoneSetSuper(zones, moreZones)) {
-    /* Tracking the whole zoneset for each generation gives more
-     * understandable telemetry than just reporting the added
-     * zones. */
-    EVENT3(ArenaGenZoneAdd, arena, gen, moreZones);
-  }
+  genZonesAdd(arena, gen,
+              ZoneSizeAdd(gen->zoneSize, arena, SegBase(seg), SegLimit(seg)));
+  if (arena->zoneFineBits > 0)
+    genFineZonesAdd(arena, gen,
+                    FineZoneSizeAdd(gen->fineZoneSize, arena,
+                                    SegBase(seg), SegLimit(seg)));
 
   PoolGenAccountForAlloc(pgen, SegSize(seg));
 
@@ -828,6 +1050,7 @@ void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
                  Size newSize, Bool deferred)
 {
   Size size;
+  Arena arena;
 
   AVERT(PoolGen, pgen);
   AVERT(Seg, seg);
@@ -839,6 +1062,17 @@ void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
 
   RingRemove(&SegGCSeg(seg)->genRing);
 
+  /* The generation stops using zones that have nothing left in them,
+     so they may be recycled.  See <design/arena/#zone.recycle>. */
+  arena = PoolArena(pgen->pool);
+  genZonesRemove(arena, pgen->gen,
+                 ZoneSizeSub(pgen->gen->zoneSize, arena,
+                             SegBase(seg), SegLimit(seg)));
+  if (arena->zoneFineBits > 0)
+    genFineZonesRemove(arena, pgen->gen,
+                       FineZoneSizeSub(pgen->gen->fineZoneSize, arena,
+                                       SegBase(seg), SegLimit(seg)));
+
   SegFree(seg);
 }
 
@@ -881,12 +1115,32 @@ Res PoolGenDescribe(PoolGen pgen, mps_lib_FILE *stream, Count depth)
 void LocusInit(Arena arena)
 {
   GenDesc gen = &arena->topGen;
+  Index i;
 
   /* Can't check arena, because it's not been inited. */
 
+  for (i = 0; i < NELEMS(arena->zoneGens); ++i)
+    arena->zoneGens[i] = 0;
+  arena->sharedZones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(arena->fineZoneGens); ++i)
+    arena->fineZoneGens[i] = 0;
+  arena->usedFineZones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(arena->ambigHits); ++i)
+    arena->ambigHits[i] = 0;
+  arena->ambigBlacklist = ZoneSetEMPTY;
+
   gen->zones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(gen->zoneSize); ++i)
+    gen->zoneSize[i] = 0;
+  gen->fineZones = ZoneSetEMPTY;
+  for (i = 0; i < NELEMS(gen->fineZoneSize); ++i)
+    gen->fineZoneSize[i] = 0;
   gen->capacity = 0; /* unused */
   gen->mortality = 0.5;
+  gen->limit.minCapacity = 0;
+  gen->limit.maxCapacity = 0;
+  gen->limit.minMortality = 0.0;
+  gen->limit.maxMortality = 1.0;
   RingInit(&gen->locusRing);
   RingInit(&gen->segRing);
   gen->sig = GenDescSig;
@@ -917,6 +1171,47 @@ Bool LocusCheck(Arena arena)
 }
 
 
+/* LocusBlacklistUpdate -- learn which zones ambiguous references hit
+ *
+ * Called at the end of each trace.  Blacklist the zones with the most
+ * recent ambiguous references, so that moving pools stop putting
+ * segments where they are likely to be nailed, then halve the counts
+ * so that the blacklist follows the client program.  See
+ * <design/arena/#zone.blacklist>.
+ */
+
+void LocusBlacklistUpdate(Arena arena)
+{
+  ZoneSet blacklist = ZoneSetEMPTY;
+  Count n;
+  Index zone;
+
+  AVERT(Arena, arena);
+
+  for (n = 0; n < LOCUS_BLACKLIST_MAX; ++n) {
+    Index noisiest = MPS_WORD_WIDTH;
+    Count most = LOCUS_BLACKLIST_HITS - 1;
+    for (zone = 0; zone < MPS_WORD_WIDTH; ++zone) {
+      if (!ZoneSetIsMember(blacklist, zone) && arena->ambigHits[zone] > most) {
+        noisiest = zone;
+        most = arena->ambigHits[zone];
+      }
+    }
+    if (noisiest == MPS_WORD_WIDTH)
+      break;
+    blacklist = BS_ADD(ZoneSet, blacklist, noisiest);
+  }
+
+  for (zone = 0; zone < MPS_WORD_WIDTH; ++zone)
+    arena->ambigHits[zone] /= 2;
+
+  if (blacklist != arena->ambigBlacklist) {
+    arena->ambigBlacklist = blacklist;
+    EVENT2(ArenaBlacklist, arena, blacklist);
+  }
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
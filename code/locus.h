@@ -22,6 +22,19 @@ typedef struct GenParamStruct {
 } GenParamStruct;
 
 
+/* GenLimitStruct -- structure for specifying generation tuning limits */
+/* .gen-limit: This structure must match <code/mps.h#gen-limit>. */
+
+typedef struct GenLimitStruct *GenLimit;
+
+typedef struct GenLimitStruct {
+  Size minCapacity;             /* least capacity in kB */
+  Size maxCapacity;             /* greatest capacity in kB */
+  double minMortality;          /* least predicted mortality */
+  double maxMortality;          /* greatest predicted mortality */
+} GenLimitStruct;
+
+
 /* GenTraceStats -- per-generation per-trace statistics */
 
 typedef struct GenTraceStatsStruct *GenTraceStats;
@@ -42,8 +55,12 @@ typedef struct GenDescStruct *GenDesc;
 typedef struct GenDescStruct {
   Sig sig;
   ZoneSet zones;        /* zoneset for this generation */
+  Size zoneSize[MPS_WORD_WIDTH]; /* bytes of segments in each zone */
+  ZoneSet fineZones;    /* fine zones for this generation */
+  Size fineZoneSize[MPS_WORD_WIDTH]; /* bytes of segments in each fine zone */
   Size capacity;        /* capacity in kB */
   double mortality;     /* predicted mortality */
+  GenLimitStruct limit; /* limits on tuning capacity and mortality */
   RingStruct locusRing; /* Ring of all PoolGen's in this GenDesc (locus) */
   RingStruct segRing; /* Ring of GCSegs in this generation */
   GenTraceStatsStruct trace[TraceLIMIT];
@@ -97,7 +114,7 @@ extern void GenDescSurvived(GenDesc gen, Trace trace, Size forwarded, Size prese
 extern Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth);
 
 extern Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
-                       GenParam params);
+                       GenParam params, ArgList args);
 extern void ChainDestroy(Chain chain);
 extern Bool ChainCheck(Chain chain);
 
@@ -112,7 +129,7 @@ extern Bool PoolGenCheck(PoolGen pgen);
 extern Res PoolGenInit(PoolGen pgen, GenDesc gen, Pool pool);
 extern void PoolGenFinish(PoolGen pgen);
 extern Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass klass,
-                        Size size, ArgList args);
+                        Size size, Index node, ArgList args);
 extern void PoolGenFree(PoolGen pgen, Seg seg, Size freeSize, Size oldSize,
                         Size newSize, Bool deferred);
 extern void PoolGenAccountForFill(PoolGen pgen, Size size);
@@ -395,7 +395,7 @@ extern Bool TracePoll(Work *workReturn, Bool *collectWorldReturn,
                       Globals globals, Bool collectWorldAllowed);
 
 extern Rank TraceRankForAccess(Arena arena, Seg seg);
-extern void TraceSegAccess(Arena arena, Seg seg, AccessSet mode);
+extern void TraceSegAccess(Arena arena, Seg seg, Addr addr, AccessSet mode);
 
 extern void TraceAdvance(Trace trace);
 extern Res TraceStartCollectAll(Trace *traceReturn, Arena arena, int why);
@@ -506,12 +506,15 @@ extern Ring GlobalsRememberedSummaryRing(Globals);
 #define ArenaZoneShift(arena)   ((arena)->zoneShift)
 #define ArenaStripeSize(arena)  ((Size)1 << ArenaZoneShift(arena))
 #define ArenaGrainSize(arena)   ((arena)->grainSize)
-#define ArenaGreyRing(arena, rank) (&(arena)->greyRing[rank])
+#define ArenaGreyRing(arena, ti, rank) (&(arena)->greyRing[ti][rank])
 #define ArenaPoolRing(arena) (&ArenaGlobals(arena)->poolRing)
 #define ArenaChunkTree(arena) RVALUE((arena)->chunkTree)
 #define ArenaChunkRing(arena) RVALUE(&(arena)->chunkRing)
 #define ArenaShield(arena)      (&(arena)->shieldStruct)
 #define ArenaHistory(arena)     (&(arena)->historyStruct)
+#define ArenaScanRate(arena)    (&(arena)->scanRate)
+#define ArenaReclaimRate(arena) (&(arena)->reclaimRate)
+#define ArenaPauseAchieved(arena) RVALUE((arena)->pauseAchieved)
 
 extern Bool ArenaGrainSizeCheck(Size size);
 #define AddrArenaGrainUp(addr, arena) AddrAlignUp(addr, ArenaGrainSize(arena))
@@ -538,6 +541,10 @@ extern void ArenaEnterRecursive(Arena arena);
 extern void ArenaLeaveRecursive(Arena arena);
 
 extern Bool (ArenaStep)(Globals globals, double interval, double multiplier);
+extern Res ArenaBackgroundStart(Arena arena);
+extern void ArenaBackgroundStop(Arena arena);
+extern Res ArenaPressureStart(Arena arena, const char *path);
+extern Bool ArenaBackgroundStep(Arena arena);
 extern void ArenaClamp(Globals globals);
 extern void ArenaRelease(Globals globals);
 extern void ArenaPark(Globals globals);
@@ -616,11 +623,15 @@ extern void ArenaCompact(Arena arena, Trace trace);
 
 extern Res ArenaFinalize(Arena arena, Ref obj);
 extern Res ArenaDefinalize(Arena arena, Ref obj);
+extern void ArenaDefinalizePool(Arena arena, Pool pool);
 
 extern Res ArenaAlloc(Addr *baseReturn, LocusPref pref,
                       Size size, Pool pool);
 extern Res ArenaFreeLandAlloc(Tract *tractReturn, Arena arena, ZoneSet zones,
                               Bool high, Size size, Pool pool);
+extern Res ArenaFreeLandAllocFine(Tract *tractReturn, Arena arena,
+                                  ZoneSet zones, ZoneSet fineZones,
+                                  Bool high, Size size, Pool pool);
 extern void ArenaFree(Addr base, Size size, Pool pool);
 
 extern Res ArenaNoExtend(Arena arena, Addr base, Size size);
@@ -635,7 +646,19 @@ extern Bool PolicyShouldCollectWorld(Arena arena, double availableTime,
 extern Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
                              Arena arena, Bool collectWorldAllowed);
 extern Bool PolicyPoll(Arena arena);
-extern Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork);
+extern Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork,
+                            Work tracedWork, Bool background);
+extern Bool PolicyPollBuffer(Arena arena, Buffer buffer);
+extern Work PolicyQuantumWork(Arena arena, Work quantumWork);
+extern void PolicyPause(Arena arena, Clock start, Clock end,
+                        Bool background);
+extern void PolicyPressure(Arena arena);
+extern void PolicyDecay(Arena arena);
+extern Bool PolicyRateSample(Arena arena);
+extern void RateInit(Rate rate);
+extern Bool RateCheck(Rate rate);
+extern void RateAccumulate(Rate rate, Size size, Clock start, Clock end);
+extern double RateEstimate(Rate rate);
 
 
 /* Locus interface */
@@ -649,6 +672,15 @@ extern Res LocusPrefDescribe(LocusPref pref, mps_lib_FILE *stream, Count depth);
 extern void LocusInit(Arena arena);
 extern void LocusFinish(Arena arena);
 extern Bool LocusCheck(Arena arena);
+extern void LocusBlacklistUpdate(Arena arena);
+
+/* LocusAmbigHit -- count an ambiguous reference into a zone
+ *
+ * See <design/arena/#zone.blacklist>.
+ */
+
+#define LocusAmbigHit(arena, ref) \
+  ((void)++(arena)->ambigHits[AddrZone(arena, ref)])
 
 
 /* Segment interface */
@@ -670,6 +702,16 @@ extern Res SegSplit(Seg *segLoReturn, Seg *segHiReturn, Seg seg, Addr at);
 extern Res SegAbsDescribe(Inst seg, mps_lib_FILE *stream, Count depth);
 extern Res SegDescribe(Seg seg, mps_lib_FILE *stream, Count depth);
 extern void SegSetSummary(Seg seg, RefSet summary);
+extern Res SegCardsInit(Seg seg);
+extern Bool SegHasCards(Seg seg);
+extern Index SegCardIndex(Seg seg, Addr addr);
+extern RefSet SegCardSummary(Seg seg, Index i);
+extern Bool SegCardIsDirty(Seg seg, Index i);
+extern Bool SegFindDirtyCards(Addr *baseReturn, Addr *limitReturn,
+                              Seg seg, Addr base);
+extern void SegSetCardSummary(Seg seg, Index i, RefSet summary);
+extern void SegCardsScanned(Seg seg);
+extern void SegCardWrite(Seg seg, Addr addr);
 extern Bool SegHasBuffer(Seg seg);
 extern Bool SegBuffer(Buffer *bufferReturn, Seg seg);
 extern void SegSetBuffer(Seg seg, Buffer buffer);
@@ -702,8 +744,8 @@ extern Addr (SegLimit)(Seg seg);
 #define SegNailed(seg)          RVALUE((TraceSet)(seg)->nailed)
 #define SegPoolRing(seg)        RVALUE(&(seg)->poolRing)
 #define SegOfPoolRing(node)     RING_ELT(Seg, poolRing, (node))
-#define SegOfGreyRing(node)     (&(RING_ELT(GCSeg, greyRing, (node)) \
-                                   ->segStruct))
+#define SegOfGreyRing(node, ti) (&(RING_ELT(GCSeg, greyRing, \
+                                             (node) - (ti)))->segStruct)
 
 #define SegSummary(seg)         (((GCSeg)(seg))->summary)
 
@@ -734,6 +776,14 @@ extern Res BufferReserve(Addr *pReturn, Buffer buffer, Size size);
    BufferFill(pReturn, buffer, size))
 
 extern Res BufferFill(Addr *pReturn, Buffer buffer, Size size);
+extern void (BufferPoll)(Buffer buffer);
+
+#if defined(SHIELD)
+#elif defined(SHIELD_NONE)
+#define BufferPoll(buffer)  UNUSED(buffer)
+#else
+#error "No shield configuration."
+#endif  /* SHIELD */
 
 extern Bool BufferCommit(Buffer buffer, Addr p, Size size);
 /* macro equivalent for BufferCommit, keep in sync with <code/buffer.c> */
@@ -761,6 +811,7 @@ extern Buffer BufferOfAP(mps_ap_t ap);
 
 #define BufferArena(buffer) ((buffer)->arena)
 #define BufferPool(buffer)  ((buffer)->pool)
+#define BufferNode(buffer)  ((buffer)->node)
 
 extern Seg BufferSeg(Buffer buffer);
 
@@ -854,16 +905,25 @@ extern Bool RankSetCheck(RankSet rankSet);
 
 
 extern ZoneSet ZoneSetOfRange(Arena arena, Addr base, Addr limit);
+extern ZoneSet FineZoneSetOfRange(Arena arena, Addr base, Addr limit);
 extern ZoneSet ZoneSetOfSeg(Arena arena, Seg seg);
+extern ZoneSet ZoneSetOfNode(Arena arena, Index node);
+extern ZoneSet ZoneSizeAdd(Size *zoneSize, Arena arena, Addr base, Addr limit);
+extern ZoneSet ZoneSizeSub(Size *zoneSize, Arena arena, Addr base, Addr limit);
+extern ZoneSet FineZoneSizeAdd(Size *zoneSize, Arena arena, Addr base, Addr limit);
+extern ZoneSet FineZoneSizeSub(Size *zoneSize, Arena arena, Addr base, Addr limit);
 typedef Bool (*RangeInZoneSet)(Addr *baseReturn, Addr *limitReturn,
                                Addr base, Addr limit,
-                               Arena arena, ZoneSet zoneSet, Size size);
+                               Arena arena, ZoneSet zoneSet,
+                               ZoneSet fineZoneSet, Size size);
 extern Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
                                 Addr base, Addr limit,
-                                Arena arena, ZoneSet zoneSet, Size size);
+                                Arena arena, ZoneSet zoneSet,
+                                ZoneSet fineZoneSet, Size size);
 extern Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
                                Addr base, Addr limit,
-                               Arena arena, ZoneSet zoneSet, Size size);
+                               Arena arena, ZoneSet zoneSet,
+                               ZoneSet fineZoneSet, Size size);
 extern ZoneSet ZoneSetBlacklist(Arena arena);
 
 
@@ -883,6 +943,7 @@ extern void (ShieldCover)(Arena arena, Seg seg);
 extern void (ShieldHold)(Arena arena);
 extern void (ShieldRelease)(Arena arena);
 extern void (ShieldFlush)(Arena arena);
+extern void (ShieldSyncCards)(Arena arena, Seg seg, Addr base, Addr limit);
 
 #if defined(SHIELD)
 /* Nothing to do: functions declared in all shield configurations. */
@@ -900,6 +961,8 @@ extern void (ShieldFlush)(Arena arena);
 #define ShieldHold(arena) BEGIN UNUSED(arena); END
 #define ShieldRelease(arena) BEGIN UNUSED(arena); END
 #define ShieldFlush(arena) BEGIN UNUSED(arena); END
+#define ShieldSyncCards(arena, seg, base, limit) \
+  BEGIN UNUSED(arena); UNUSED(seg); UNUSED(base); UNUSED(limit); END
 #else
 #error "No shield configuration."
 #endif  /* SHIELD */
@@ -960,7 +1023,7 @@ extern void RootGrey(Root root, Trace trace);
 extern Res RootScan(ScanState ss, Root root);
 extern Arena RootArena(Root root);
 extern Bool RootOfAddr(Root *root, Arena arena, Addr addr);
-extern void RootAccess(Root root, AccessSet mode);
+extern void RootAccess(Root root, Addr addr, AccessSet mode);
 typedef Res (*RootIterateFn)(Root root, void *p);
 extern Res RootsIterate(Globals arena, RootIterateFn f, void *p);
 
@@ -982,7 +1045,7 @@ extern Bool LandIterateAndDelete(Land land, LandDeleteVisitor visitor, void *clo
 extern Bool LandFindFirst(Range rangeReturn, Range oldRangeReturn, Land land, Size size, FindDelete findDelete);
 extern Bool LandFindLast(Range rangeReturn, Range oldRangeReturn, Land land, Size size, FindDelete findDelete);
 extern Bool LandFindLargest(Range rangeReturn, Range oldRangeReturn, Land land, Size size, FindDelete findDelete);
-extern Res LandFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, Bool high);
+extern Res LandFindInZones(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, ZoneSet fineZoneSet, Bool high);
 extern Res LandDescribe(Land land, mps_lib_FILE *stream, Count depth);
 extern Bool LandFlush(Land dest, Land src);
 
@@ -27,6 +27,7 @@
 #include "protocol.h"
 #include "ring.h"
 #include "locus.h"
+#include "range.h"
 #include "splay.h"
 #include "meter.h"
 
@@ -82,6 +83,21 @@ typedef struct mps_pool_class_s {
 } PoolClassStruct;
 
 
+/* RateStruct -- measured rate of collection work
+ *
+ * .rate: An online estimate of the rate (in bytes per second) at which
+ * some kind of collection work proceeds.  Measurements are accumulated
+ * in size and time until there is enough time to be meaningful, then
+ * folded into the moving average in rate.  See <code/policy.c#rate>.
+ */
+
+typedef struct RateStruct {
+  double size;                  /* bytes accumulated since last fold */
+  double time;                  /* seconds accumulated since last fold */
+  double rate;                  /* estimate, or 0.0 if none yet */
+} RateStruct;
+
+
 /* PoolStruct -- generic structure
  *
  * .pool: A generic structure is created when a pool is created and
@@ -106,6 +122,8 @@ typedef struct mps_pool_s {     /* generic structure */
   Align alignment;              /* alignment for units */
   Format format;                /* format only if class->attr&AttrFMT */
   PoolFixMethod fix;            /* fix method */
+  Index node;                   /* preferred NUMA node, or NodeANY */
+  RateStruct scanRate[RankLIMIT]; /* segment scan rate, by rank */
 } PoolStruct;
 
 
@@ -267,10 +285,16 @@ typedef struct SegStruct {      /* segment structure */
 
 typedef struct GCSegStruct {    /* GC segment structure */
   SegStruct segStruct;          /* superclass fields must come first */
-  RingStruct greyRing;          /* link in list of grey segs */
+  RingStruct greyRing[TraceLIMIT]; /* links in lists of grey segs */
   RefSet summary;               /* summary of references out of seg */
   Buffer buffer;                /* non-NULL if seg is buffered */
   RingStruct genRing;           /* link in list of segs in gen */
+  Count cards;                  /* number of cards, or 0 if none */
+  Shift cardShift;              /* log2 of the card size */
+  RefSet *cardSummary;          /* summary of references out of each card */
+  BT cardDirty;                 /* cards written by the mutator */
+  Count cardsDirty;             /* number of dirty cards */
+  Bool cardsScanned;            /* card summaries set by last scan? */
   Sig sig;                      /* <design/sig/> */
 } GCSegStruct;
 
@@ -289,6 +313,8 @@ typedef struct LocusPrefStruct { /* locus placement preferences */
   Bool high;                    /* high or low */
   ZoneSet zones;                /* preferred zones */
   ZoneSet avoid;                /* zones to avoid */
+  Index node;                   /* preferred NUMA node, or NodeANY */
+  ZoneSet fineZones;            /* preferred fine zones when sharing zones */
 } LocusPrefStruct;
 
 
@@ -340,6 +366,9 @@ typedef struct BufferStruct {
   BufferMode mode;              /* Attached/Logged/Flipped/etc */
   double fillSize;              /* bytes filled in this buffer */
   double emptySize;             /* bytes emptied from this buffer */
+  double debt;                  /* bytes filled since it last polled */
+  Bool exempt;                  /* exempt from collection work? */
+  Index node;                   /* preferred NUMA node, or NodeANY */
   Addr base;                    /* base address of allocation buffer */
   Addr initAtFlip;              /* limit of initialized data at flip */
   mps_ap_s ap_s;                /* the allocation point */
@@ -424,6 +453,8 @@ typedef struct ScanStateStruct {
   Rank rank;                    /* reference rank of scanning */
   Bool wasMarked;               /* design.mps.fix.protocol.was-ready */
   RefSet fixedSummary;          /* accumulated summary of fixed references */
+  Shift fineZoneShift;          /* <design/arena/#zone.fine> */
+  ZoneSet fineWhite;            /* fine white set, or ZoneSetUNIV */
   STATISTIC_DECL(Count fixRefCount) /* refs which pass zone check */
   STATISTIC_DECL(Count segRefCount) /* refs which refer to segs */
   STATISTIC_DECL(Count whiteSegRefCount) /* refs which refer to white segs */
@@ -446,6 +477,7 @@ typedef struct TraceStruct {
   Arena arena;                  /* owning arena */
   int why;                      /* why the trace began */
   ZoneSet white;                /* zones in the white set */
+  ZoneSet fineWhite;            /* fine zones in the white set */
   ZoneSet mayMove;              /* zones containing possibly moving objs */
   TraceState state;             /* current state of trace */
   Rank band;                    /* current band */
@@ -527,11 +559,13 @@ typedef struct GlobalsStruct {
 
   /* polling fields (<code/global.c>) */
   double pollThreshold;         /* <design/arena/#poll> */
+  double backgroundThreshold;   /* <design/arena/#background.threshold> */
   Bool insidePoll;
   Bool clamped;                 /* prevent background activity */
   double fillMutatorSize;       /* total bytes filled, mutator buffers */
   double emptyMutatorSize;      /* total bytes emptied, mutator buffers */
   double allocMutatorSize;      /* fill-empty, only asymptotically accurate */
+  double mutatorDebt;           /* total debt of mutator buffers */
   double fillInternalSize;      /* total bytes filled, internal buffers */
   double emptyInternalSize;     /* total bytes emptied, internal buffers */
 
@@ -737,10 +771,21 @@ typedef struct mps_arena_s {
 
   Size spareCommitted;          /* Amount of memory in hysteresis fund */
   Size spareCommitLimit;        /* Limit on spareCommitted */
+  double spareDecay;            /* <design/arena/#spare.decay> */
+  Clock spareDecayLast;         /* when spare memory last decayed */
+  Count purgeCount;             /* number of purges of spare memory */
+  Clock purgeTime;              /* total time spent purging */
+  Clock purgeTimeMax;           /* longest purge */
   double pauseTime;             /* Maximum pause time, in seconds. */
+  Bool backgroundWanted;        /* start a background collector thread? */
+  Background background;        /* background collector thread, or NULL */
+  Pressure pressure;            /* memory pressure monitor, or NULL */
 
   Shift zoneShift;              /* see also <code/ref.c> */
+  Shift zoneFineBits;           /* log2 of zones per zone set bit */
+  Shift fineZoneShift;          /* <design/arena/#zone.fine> */
   Size grainSize;               /* <design/arena/#grain> */
+  Count nodes;                  /* NUMA nodes, <design/arena/#numa> */
 
   Tract lastTract;              /* most recently allocated tract */
   Addr lastTractBase;           /* base address of lastTract */
@@ -748,16 +793,26 @@ typedef struct mps_arena_s {
   Chunk primary;                /* the primary chunk */
   RingStruct chunkRing;         /* all the chunks, in a ring for iteration */
   Tree chunkTree;               /* all the chunks, in a tree for fast lookup */
+  Addr chunkMapBase;            /* base of address space in chunk map */
+  Shift chunkMapShift;          /* log2 of address space per map entry */
+  Chunk chunkMap[ChunkMapLENGTH]; /* <design/arena/#chunk.map> */
   Serial chunkSerial;           /* next chunk number */
 
   Bool hasFreeLand;              /* Is freeLand available? */
   MFSStruct freeCBSBlockPoolStruct;
   CBSStruct freeLandStruct;
-  ZoneSet freeZones;            /* zones not yet allocated */
+  ZoneSet freeZones;            /* zones with nothing allocated */
+  Size zoneAllocated[MPS_WORD_WIDTH]; /* bytes allocated in each zone */
   Bool zoned;                   /* use zoned allocation? */
 
   /* locus fields (<code/locus.c>) */
   GenDescStruct topGen;         /* generation descriptor for dynamic gen */
+  Count zoneGens[MPS_WORD_WIDTH]; /* generations using each zone */
+  ZoneSet sharedZones;          /* zones used by more than one generation */
+  Count fineZoneGens[MPS_WORD_WIDTH]; /* generations using each fine zone */
+  ZoneSet usedFineZones;        /* fine zones used by any generation */
+  Count ambigHits[MPS_WORD_WIDTH]; /* recent ambiguous refs into each zone */
+  ZoneSet ambigBlacklist;       /* noisiest zones, avoided by moving pools */
 
   /* format fields (<code/format.c>) */
   RingStruct formatRing;        /* ring of formats attached to arena */
@@ -793,8 +848,26 @@ typedef struct mps_arena_s {
   double tracedWork;
   double tracedTime;
   Clock lastWorldCollect;
-
-  RingStruct greyRing[RankLIMIT]; /* ring of grey segments at each rank */
+  RateStruct scanRate;          /* scan rate for all segs and roots */
+  RateStruct reclaimRate;       /* reclaim rate for all segs */
+  Count rateSample;             /* counts scans and reclaims for sampling */
+  Clock quantumStart;           /* when the last quantum started */
+  double quantumTime;           /* predicted time of a quantum, in seconds */
+  double quantumScale;          /* fraction of quantum work done per quantum */
+  double pauseAchieved;         /* pause time at ARENA_PAUSE_PERCENTILE */
+  Count pauseCount;             /* number of pauses measured */
+  Count pauseOverCount;         /* number of pauses longer than pauseTime */
+  double pauseTotal;            /* total time of pauses, in seconds */
+  double pauseMax;              /* longest pause, in seconds */
+  Count backgroundCount;        /* number of background steps measured */
+  double backgroundTime;        /* total time of background steps */
+  Clock pressureLast;           /* when memory pressure was last read */
+  Count pressureCount;          /* number of readings under pressure */
+  Bool pressureCollect;         /* collect the world to relieve pressure? */
+  Count pressureCollections;    /* number of collections for pressure */
+  Clock pressureCollectLast;    /* when the last of them started */
+
+  RingStruct greyRing[TraceLIMIT][RankLIMIT]; /* grey segs for each trace, by rank */
   STATISTIC_DECL(Count writeBarrierHitCount) /* write barrier hits */
   RingStruct chainRing;         /* ring of chains */
 
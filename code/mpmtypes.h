@@ -72,12 +72,16 @@ typedef struct BufferClassStruct *BufferClass; /* <design/buffer/> */
 typedef unsigned BufferMode;            /* <design/buffer/> */
 typedef struct mps_fmt_s *Format;       /* design.mps.format */
 typedef struct LockStruct *Lock;        /* <code/lock.c>* */
+typedef struct BackgroundStruct *Background; /* <code/bg.h> */
+typedef struct PressureStruct *Pressure; /* <code/press.h> */
+typedef struct ImageFileStruct *ImageFile; /* <code/image.h> */
 typedef struct mps_pool_s *Pool;        /* <design/pool/> */
 typedef Pool AbstractPool;
 typedef struct mps_pool_class_s *PoolClass;  /* <code/poolclas.c> */
 typedef struct TraceStruct *Trace;      /* <design/trace/> */
 typedef struct ScanStateStruct *ScanState; /* <design/trace/> */
 typedef struct mps_chain_s *Chain;      /* <design/trace/> */
+typedef struct RateStruct *Rate;        /* <code/policy.c#rate> */
 typedef struct TractStruct *Tract;      /* <design/arena/> */
 typedef struct ChunkStruct *Chunk;      /* <code/tract.c> */
 typedef struct ChunkCacheEntryStruct *ChunkCacheEntry; /* <code/tract.c> */
@@ -257,7 +261,7 @@ typedef Bool (*LandDeleteVisitor)(Bool *deleteReturn, Land land, Range range, vo
 typedef Bool (*LandIterateMethod)(Land land, LandVisitor visitor, void *closure);
 typedef Bool (*LandIterateAndDeleteMethod)(Land land, LandDeleteVisitor visitor, void *closure);
 typedef Bool (*LandFindMethod)(Range rangeReturn, Range oldRangeReturn, Land land, Size size, FindDelete findDelete);
-typedef Res (*LandFindInZonesMethod)(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, Bool high);
+typedef Res (*LandFindInZonesMethod)(Bool *foundReturn, Range rangeReturn, Range oldRangeReturn, Land land, Size size, ZoneSet zoneSet, ZoneSet fineZoneSet, Bool high);
 
 
 /* CONSTANTS */
@@ -275,7 +279,8 @@ typedef Res (*LandFindInZonesMethod)(Bool *foundReturn, Range rangeReturn, Range
 #define RefSetUNIV      BS_UNIV(RefSet)
 #define ZoneSetEMPTY    BS_EMPTY(ZoneSet)
 #define ZoneSetUNIV     BS_UNIV(ZoneSet)
-#define ZoneShiftUNSET  ((Shift)-1)  
+#define ZoneShiftUNSET  ((Shift)-1)
+#define NodeANY         ((Index)-1)  
 #define TraceSetEMPTY   BS_EMPTY(TraceSet)
 #define TraceSetUNIV    ((TraceSet)((1u << TraceLIMIT) - 1))
 #define RankSetEMPTY    BS_EMPTY(RankSet)
@@ -291,6 +296,8 @@ enum {
   LocusPrefHIGH = 1,
   LocusPrefLOW, 
   LocusPrefZONESET,
+  LocusPrefNODE,
+  LocusPrefFINEZONESET,
   LocusPrefLIMIT
 };
 
@@ -324,6 +331,7 @@ enum {
 #define RootModeCONSTANT          ((RootMode)1<<0)
 #define RootModePROTECTABLE       ((RootMode)1<<1)
 #define RootModePROTECTABLE_INNER ((RootMode)1<<2)
+#define RootModePROTECTABLE_PAGES ((RootMode)1<<3)
 
 
 /* Root Variants -- see <design/type/#rootvar>
@@ -373,6 +381,7 @@ enum {
   TraceStartWhyCLIENTFULL_BLOCK, /* do full */
   TraceStartWhyWALK,            /* walking references -- see walk.c */
   TraceStartWhyEXTENSION,       /* MPS extension using traces */
+  TraceStartWhyPRESSURE,        /* start full */
   TraceStartWhyLIMIT /* not a reason, the limit of the enum. */
 };
 
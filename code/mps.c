@@ -39,6 +39,7 @@
 #include "locus.c"
 #include "tract.c"
 #include "walk.c"
+#include "image.c"
 #include "protocol.c"
 #include "pool.c"
 #include "poolabs.c"
@@ -103,6 +104,9 @@
 #if defined(PLATFORM_ANSI)
 
 #include "lockan.c"     /* generic locks */
+#include "bgan.c"       /* generic background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imagean.c"    /* generic heap image files */
 #include "than.c"       /* generic threads manager */
 #include "vman.c"       /* malloc-based pseudo memory mapping */
 #include "protan.c"     /* generic memory protection */
@@ -115,6 +119,9 @@
 #elif defined(MPS_PF_XCI3LL) || defined(MPS_PF_XCI3GC)
 
 #include "lockix.c"     /* Posix locks */
+#include "bgix.c"       /* Posix background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imageix.c"    /* Posix heap image files */
 #include "thxc.c"       /* OS X Mach threading */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -129,6 +136,9 @@
 #elif defined(MPS_PF_XCI6LL) || defined(MPS_PF_XCI6GC)
 
 #include "lockix.c"     /* Posix locks */
+#include "bgix.c"       /* Posix background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imageix.c"    /* Posix heap image files */
 #include "thxc.c"       /* OS X Mach threading */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -143,6 +153,9 @@
 #elif defined(MPS_PF_FRI3GC) || defined(MPS_PF_FRI3LL)
 
 #include "lockix.c"     /* Posix locks */
+#include "bgix.c"       /* Posix background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imageix.c"    /* Posix heap image files */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
@@ -158,6 +171,9 @@
 #elif defined(MPS_PF_FRI6GC) || defined(MPS_PF_FRI6LL)
 
 #include "lockix.c"     /* Posix locks */
+#include "bgix.c"       /* Posix background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imageix.c"    /* Posix heap image files */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
@@ -173,6 +189,9 @@
 #elif defined(MPS_PF_LII3GC)
 
 #include "lockix.c"     /* Posix locks */
+#include "bgix.c"       /* Posix background thread */
+#include "pressli.c"    /* Linux memory pressure monitor */
+#include "imageix.c"    /* Posix heap image files */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
@@ -188,6 +207,9 @@
 #elif defined(MPS_PF_LII6GC) || defined(MPS_PF_LII6LL)
 
 #include "lockix.c"     /* Posix locks */
+#include "bgix.c"       /* Posix background thread */
+#include "pressli.c"    /* Linux memory pressure monitor */
+#include "imageix.c"    /* Posix heap image files */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
@@ -203,6 +225,9 @@
 #elif defined(MPS_PF_W3I3MV)
 
 #include "lockw3.c"     /* Windows locks */
+#include "bgw3.c"       /* Windows background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imagean.c"    /* generic heap image files */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i3.c"     /* Windows on 32-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -218,6 +243,9 @@
 #elif defined(MPS_PF_W3I6MV)
 
 #include "lockw3.c"     /* Windows locks */
+#include "bgw3.c"       /* Windows background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imagean.c"    /* generic heap image files */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i6.c"     /* Windows on 64-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -233,6 +261,9 @@
 #elif defined(MPS_PF_W3I3PC)
 
 #include "lockw3.c"     /* Windows locks */
+#include "bgw3.c"       /* Windows background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imagean.c"    /* generic heap image files */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i3.c"     /* Windows on 32-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -248,6 +279,9 @@
 #elif defined(MPS_PF_W3I6PC)
 
 #include "lockw3.c"     /* Windows locks */
+#include "bgw3.c"       /* Windows background thread */
+#include "pressan.c"    /* generic memory pressure monitor */
+#include "imagean.c"    /* generic heap image files */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i6.c"     /* Windows on 64-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
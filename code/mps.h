@@ -171,6 +171,9 @@ extern const struct mps_key_s _mps_key_ARENA_SIZE;
 extern const struct mps_key_s _mps_key_ARENA_ZONED;
 #define MPS_KEY_ARENA_ZONED     (&_mps_key_ARENA_ZONED)
 #define MPS_KEY_ARENA_ZONED_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_ZONES;
+#define MPS_KEY_ARENA_ZONES     (&_mps_key_ARENA_ZONES)
+#define MPS_KEY_ARENA_ZONES_FIELD count
 extern const struct mps_key_s _mps_key_FORMAT;
 #define MPS_KEY_FORMAT          (&_mps_key_FORMAT)
 #define MPS_KEY_FORMAT_FIELD    format
@@ -180,6 +183,9 @@ extern const struct mps_key_s _mps_key_CHAIN;
 extern const struct mps_key_s _mps_key_GEN;
 #define MPS_KEY_GEN             (&_mps_key_GEN)
 #define MPS_KEY_GEN_FIELD       u
+extern const struct mps_key_s _mps_key_NUMA_NODE;
+#define MPS_KEY_NUMA_NODE       (&_mps_key_NUMA_NODE)
+#define MPS_KEY_NUMA_NODE_FIELD u
 extern const struct mps_key_s _mps_key_RANK;
 #define MPS_KEY_RANK            (&_mps_key_RANK)
 #define MPS_KEY_RANK_FIELD      rank
@@ -192,6 +198,21 @@ extern const struct mps_key_s _mps_key_SPARE_COMMIT_LIMIT;
 extern const struct mps_key_s _mps_key_PAUSE_TIME;
 #define MPS_KEY_PAUSE_TIME      (&_mps_key_PAUSE_TIME)
 #define MPS_KEY_PAUSE_TIME_FIELD d
+extern const struct mps_key_s _mps_key_ARENA_BACKGROUND;
+#define MPS_KEY_ARENA_BACKGROUND (&_mps_key_ARENA_BACKGROUND)
+#define MPS_KEY_ARENA_BACKGROUND_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_PRESSURE_PATH;
+#define MPS_KEY_ARENA_PRESSURE_PATH (&_mps_key_ARENA_PRESSURE_PATH)
+#define MPS_KEY_ARENA_PRESSURE_PATH_FIELD string
+extern const struct mps_key_s _mps_key_ARENA_SPARE_DECAY;
+#define MPS_KEY_ARENA_SPARE_DECAY (&_mps_key_ARENA_SPARE_DECAY)
+#define MPS_KEY_ARENA_SPARE_DECAY_FIELD d
+extern const struct mps_key_s _mps_key_ARENA_HUGE_PAGES;
+#define MPS_KEY_ARENA_HUGE_PAGES (&_mps_key_ARENA_HUGE_PAGES)
+#define MPS_KEY_ARENA_HUGE_PAGES_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_NUMA_NODES;
+#define MPS_KEY_ARENA_NUMA_NODES (&_mps_key_ARENA_NUMA_NODES)
+#define MPS_KEY_ARENA_NUMA_NODES_FIELD count
 
 extern const struct mps_key_s _mps_key_EXTEND_BY;
 #define MPS_KEY_EXTEND_BY       (&_mps_key_EXTEND_BY)
@@ -217,6 +238,15 @@ extern const struct mps_key_s _mps_key_SPARE;
 extern const struct mps_key_s _mps_key_INTERIOR;
 #define MPS_KEY_INTERIOR        (&_mps_key_INTERIOR)
 #define MPS_KEY_INTERIOR_FIELD  b
+extern const struct mps_key_s _mps_key_AP_PRETENURE;
+#define MPS_KEY_AP_PRETENURE    (&_mps_key_AP_PRETENURE)
+#define MPS_KEY_AP_PRETENURE_FIELD b
+extern const struct mps_key_s _mps_key_AP_EXEMPT;
+#define MPS_KEY_AP_EXEMPT       (&_mps_key_AP_EXEMPT)
+#define MPS_KEY_AP_EXEMPT_FIELD b
+extern const struct mps_key_s _mps_key_CHAIN_LIMITS;
+#define MPS_KEY_CHAIN_LIMITS    (&_mps_key_CHAIN_LIMITS)
+#define MPS_KEY_CHAIN_LIMITS_FIELD p
 
 extern const struct mps_key_s _mps_key_VMW3_TOP_DOWN;
 #define MPS_KEY_VMW3_TOP_DOWN   (&_mps_key_VMW3_TOP_DOWN)
@@ -313,6 +343,7 @@ extern mps_rank_t mps_rank_weak(void);
 #define MPS_RM_CONST      (((mps_rm_t)1<<0))
 #define MPS_RM_PROT       (((mps_rm_t)1<<1))
 #define MPS_RM_PROT_INNER (((mps_rm_t)1<<1))
+#define MPS_RM_PROT_PAGES (((mps_rm_t)1<<3))
 
 
 /* Allocation Point */
@@ -460,6 +491,14 @@ extern size_t mps_arena_spare_commit_limit(mps_arena_t);
 
 extern double mps_arena_pause_time(mps_arena_t);
 extern void mps_arena_pause_time_set(mps_arena_t, double);
+extern double mps_arena_pause_achieved(mps_arena_t);
+extern void mps_arena_pause_stats(mps_arena_t, size_t *, size_t *,
+                                  double *, double *);
+extern void mps_arena_purge_stats(mps_arena_t, size_t *, double *, double *);
+extern void mps_arena_background_stats(mps_arena_t, size_t *, double *);
+
+extern double mps_arena_scan_rate(mps_arena_t);
+extern double mps_arena_reclaim_rate(mps_arena_t);
 
 extern mps_bool_t mps_arena_busy(mps_arena_t);
 extern mps_bool_t mps_arena_has_addr(mps_arena_t, mps_addr_t);
@@ -499,6 +538,7 @@ extern mps_res_t mps_pool_create_k(mps_pool_t *, mps_arena_t,
 extern void mps_pool_destroy(mps_pool_t);
 extern size_t mps_pool_total_size(mps_pool_t);
 extern size_t mps_pool_free_size(mps_pool_t);
+extern double mps_pool_scan_rate(mps_pool_t, mps_rank_t);
 
 
 /* Chains */
@@ -509,8 +549,19 @@ typedef struct mps_gen_param_s {
   double mps_mortality;
 } mps_gen_param_s;
 
+/* .gen-limit: This structure must match <code/locus.h#gen-limit>. */
+typedef struct mps_gen_limit_s {
+  size_t mps_min_capacity;
+  size_t mps_max_capacity;
+  double mps_min_mortality;
+  double mps_max_mortality;
+} mps_gen_limit_s;
+
 extern mps_res_t mps_chain_create(mps_chain_t *, mps_arena_t,
                                   size_t, mps_gen_param_s *);
+extern mps_res_t mps_chain_create_k(mps_chain_t *, mps_arena_t,
+                                    size_t, mps_gen_param_s *,
+                                    mps_arg_s []);
 extern void mps_chain_destroy(mps_chain_t);
 
 
@@ -796,6 +847,14 @@ extern void mps_arena_roots_walk(mps_arena_t,
                                  void *, size_t);
 
 
+/* Heap Images */
+
+extern mps_res_t mps_arena_image_save(mps_arena_t, mps_fmt_t,
+                                      const char *, mps_addr_t *, size_t);
+extern mps_res_t mps_ap_image_load(mps_ap_t, const char *,
+                                   mps_addr_t *, size_t);
+
+
 /* Allocation debug options */
 
 
@@ -841,6 +900,9 @@ extern mps_res_t mps_fix(mps_ss_t, mps_addr_t *);
 extern mps_res_t _mps_fix2(mps_ss_t, mps_addr_t *);
 #define MPS_FIX2(ss, ref_io) _mps_fix2(ss, ref_io)
 
+extern mps_res_t _mps_fix2_refs(mps_ss_t, mps_addr_t **, size_t);
+#define MPS_FIX2_REFS(ss, ref_ios, count) _mps_fix2_refs(ss, ref_ios, count)
+
 #define MPS_FIX12(ss, ref_io) \
   (MPS_FIX1(ss, *(ref_io)) ? \
    MPS_FIX2(ss, ref_io) : MPS_RES_OK)
@@ -235,6 +235,81 @@ void mps_arena_pause_time_set(mps_arena_t arena, double pause_time)
   ArenaLeave(arena);
 }
 
+double mps_arena_pause_achieved(mps_arena_t arena)
+{
+  double pause;
+
+  ArenaEnter(arena);
+  pause = ArenaPauseAchieved(arena);
+  ArenaLeave(arena);
+
+  return pause;
+}
+
+void mps_arena_pause_stats(mps_arena_t arena, size_t *count_o,
+                           size_t *over_o, double *total_o, double *max_o)
+{
+  AVER(count_o != NULL);
+  AVER(over_o != NULL);
+  AVER(total_o != NULL);
+  AVER(max_o != NULL);
+
+  ArenaEnter(arena);
+  *count_o = (size_t)arena->pauseCount;
+  *over_o = (size_t)arena->pauseOverCount;
+  *total_o = arena->pauseTotal;
+  *max_o = arena->pauseMax;
+  ArenaLeave(arena);
+}
+
+void mps_arena_purge_stats(mps_arena_t arena, size_t *count_o,
+                           double *total_o, double *max_o)
+{
+  AVER(count_o != NULL);
+  AVER(total_o != NULL);
+  AVER(max_o != NULL);
+
+  ArenaEnter(arena);
+  *count_o = (size_t)arena->purgeCount;
+  *total_o = arena->purgeTime / (double)ClocksPerSec();
+  *max_o = arena->purgeTimeMax / (double)ClocksPerSec();
+  ArenaLeave(arena);
+}
+
+void mps_arena_background_stats(mps_arena_t arena, size_t *count_o,
+                                double *total_o)
+{
+  AVER(count_o != NULL);
+  AVER(total_o != NULL);
+
+  ArenaEnter(arena);
+  *count_o = (size_t)arena->backgroundCount;
+  *total_o = arena->backgroundTime;
+  ArenaLeave(arena);
+}
+
+double mps_arena_scan_rate(mps_arena_t arena)
+{
+  double rate;
+
+  ArenaEnter(arena);
+  rate = RateEstimate(ArenaScanRate(arena));
+  ArenaLeave(arena);
+
+  return rate;
+}
+
+double mps_arena_reclaim_rate(mps_arena_t arena)
+{
+  double rate;
+
+  ArenaEnter(arena);
+  rate = RateEstimate(ArenaReclaimRate(arena));
+  ArenaLeave(arena);
+
+  return rate;
+}
+
 
 void mps_arena_clamp(mps_arena_t arena)
 {
@@ -378,6 +453,7 @@ mps_res_t mps_arena_create_k(mps_arena_t *mps_arena_o,
 
 void mps_arena_destroy(mps_arena_t arena)
 {
+  ArenaBackgroundStop(arena);
   ArenaEnter(arena);
   ArenaDestroy(arena);
 }
@@ -758,6 +834,24 @@ size_t mps_pool_free_size(mps_pool_t pool)
   return (size_t)size;
 }
 
+double mps_pool_scan_rate(mps_pool_t pool, mps_rank_t rank)
+{
+  Arena arena;
+  double rate;
+
+  AVER(TESTT(Pool, pool));
+  arena = PoolArena(pool);
+
+  ArenaEnter(arena);
+
+  AVERT(Rank, rank);
+  rate = RateEstimate(&pool->scanRate[rank]);
+
+  ArenaLeave(arena);
+
+  return rate;
+}
+
 
 mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
 {
@@ -1075,7 +1169,7 @@ mps_res_t mps_ap_fill(mps_addr_t *p_o, mps_ap_t mps_ap, size_t size)
 
   ArenaEnter(arena);
 
-  ArenaPoll(ArenaGlobals(arena)); /* .poll */
+  BufferPoll(buf); /* .poll */
 
   AVER(p_o != NULL);
   AVERT(Buffer, buf);
@@ -2109,14 +2203,28 @@ size_t mps_reservoir_available(mps_arena_t arena)
 
 mps_res_t mps_chain_create(mps_chain_t *chain_o, mps_arena_t arena,
                            size_t gen_count, mps_gen_param_s *params)
+{
+  return mps_chain_create_k(chain_o, arena, gen_count, params,
+                            mps_args_none);
+}
+
+
+/* mps_chain_create_k -- create a chain, with keyword arguments */
+
+mps_res_t mps_chain_create_k(mps_chain_t *chain_o, mps_arena_t arena,
+                             size_t gen_count, mps_gen_param_s *params,
+                             mps_arg_s args[])
 {
   Chain chain;
   Res res;
 
   ArenaEnter(arena);
 
+  AVER(chain_o != NULL);
   AVER(gen_count > 0);
-  res = ChainCreate(&chain, arena, gen_count, (GenParamStruct *)params);
+  AVERT(ArgList, args);
+  res = ChainCreate(&chain, arena, gen_count, (GenParamStruct *)params,
+                    args);
 
   ArenaLeave(arena);
   if (res != ResOK)
@@ -11,6 +11,9 @@
 
 #include "locus.h"
 #include "mpm.h"
+#include "press.h"
+
+#include <float.h> /* for DBL_MAX */
 
 SRCID(policy, "$Id$");
 
@@ -34,7 +37,9 @@ Res PolicyAlloc(Tract *tractReturn, Arena arena, LocusPref pref,
 {
   Res res;
   Tract tract;
-  ZoneSet zones, moreZones, evenMoreZones;
+  ZoneSet clean, nodeZones, zones, moreZones, withShared, evenMoreZones;
+  Index node;
+  Bool everyZone, fine;
 
   AVER(tractReturn != NULL);
   AVERT(Arena, arena);
@@ -54,8 +59,60 @@ Res PolicyAlloc(Tract *tractReturn, Arena arena, LocusPref pref,
     }
   }
 
+  /* Zones used by more than one generation are polluted: the zone
+   * check can't tell their generations apart.  Prefer the requested
+   * zones that aren't, so that allocation migrates out of the polluted
+   * zones, and they are recycled when they empty.  See
+   * <design/arena/#zone.shared>. */
+  clean = ZoneSetDiff(pref->zones, arena->sharedZones);
+
+  /* The zones of the preferred NUMA node, whose memory is bound to
+   * that node.  A preference expressed by the pool class overrides the
+   * pool's (or allocation point's) own.  See
+   * <design/arena/#numa.pref>. */
+  nodeZones = ZoneSetEMPTY;
+  node = pref->node != NodeANY ? pref->node : pool->node;
+  if (node != NodeANY && arena->nodes > 1) {
+    nodeZones = ZoneSetUnion(clean, arena->freeZones);
+    nodeZones = ZoneSetInter(ZoneSetDiff(nodeZones, pref->avoid),
+                             ZoneSetOfNode(arena, node % arena->nodes));
+  }
+
+  /* The zones for plans A, B, B' and D below. */
+  /* TODO: Pools without ambiguous roots might not care about the blacklist. */
+  zones = ZoneSetDiff(clean, pref->avoid);
+  moreZones = ZoneSetUnion(clean, ZoneSetDiff(arena->freeZones, pref->avoid));
+  withShared = ZoneSetUnion(moreZones, pref->zones);
+  evenMoreZones = ZoneSetDiff(ZoneSetUNIV, pref->avoid);
+
+  /* An allocation that is bigger than all the stripes but one covers
+   * every zone wherever it goes, so restricting its zones would only
+   * make the plans below fail one after another (and extend the arena
+   * needlessly).  Similarly, the zones make no difference if the arena
+   * is not zoned.  See <design/arena/#large.zones>. */
+  everyZone = !arena->zoned
+    || size > ArenaStripeSize(arena) * (MPS_WORD_WIDTH - 1);
+
+  if (everyZone) {
+    nodeZones = ZoneSetEMPTY;
+    zones = moreZones = withShared = evenMoreZones = ZoneSetUNIV;
+  }
+
+  /* Before sharing zones with other generations, try to keep to the
+   * preferred fine zones, so that the fine zone test can still tell
+   * the generations apart.  See <design/arena/#zone.fine.locus>. */
+  fine = !everyZone && pref->fineZones != ZoneSetUNIV
+    && pref->fineZones != ZoneSetEMPTY;
+
+  /* Plan N: keep to the zones of the preferred NUMA node. */
+  if (nodeZones != ZoneSetEMPTY) {
+    res = ArenaFreeLandAlloc(&tract, arena, nodeZones, pref->high,
+                             size, pool);
+    if (res == ResOK)
+      goto found;
+  }
+
   /* Plan A: allocate from the free land in the requested zones */
-  zones = ZoneSetDiff(pref->zones, pref->avoid);
   if (zones != ZoneSetEMPTY) {
     res = ArenaFreeLandAlloc(&tract, arena, zones, pref->high, size, pool);
     if (res == ResOK)
@@ -63,29 +120,56 @@ Res PolicyAlloc(Tract *tractReturn, Arena arena, LocusPref pref,
   }
 
   /* Plan B: add free zones that aren't blacklisted */
-  /* TODO: Pools without ambiguous roots might not care about the blacklist. */
-  /* TODO: zones are precious and (currently) never deallocated, so we
-   * should consider extending the arena first if address space is plentiful.
-   * See also job003384. */
-  moreZones = ZoneSetUnion(pref->zones, ZoneSetDiff(arena->freeZones, pref->avoid));
+  /* TODO: zones are precious (though they are recycled when they empty:
+   * see <design/arena/#zone.recycle>), so we should consider extending
+   * the arena first if address space is plentiful.  See also job003384. */
   if (moreZones != zones) {
     res = ArenaFreeLandAlloc(&tract, arena, moreZones, pref->high, size, pool);
     if (res == ResOK)
       goto found;
   }
 
-  /* Plan C: Extend the arena, then try A and B again. */
-  if (moreZones != ZoneSetEMPTY) {
+  /* Plan B': add the polluted requested zones, rather than extending
+   * the arena or spreading into other generations' zones.  Keep to the
+   * preferred fine zones if possible. */
+  if (withShared != moreZones) {
+    if (fine) {
+      res = ArenaFreeLandAllocFine(&tract, arena, withShared,
+                                   pref->fineZones, pref->high, size, pool);
+      if (res == ResOK)
+        goto found;
+    }
+    res = ArenaFreeLandAlloc(&tract, arena, withShared, pref->high,
+                             size, pool);
+    if (res == ResOK)
+      goto found;
+  }
+
+  /* Plan C: Extend the arena, then try N, A and B again. */
+  if (withShared != ZoneSetEMPTY) {
     res = Method(Arena, arena, grow)(arena, pref, size);
-    /* If we can't extend because we hit the commit limit, try purging
-       some spare committed memory and try again.*/
-    /* TODO: This would be a good time to *remap* VM instead of
-       returning it to the OS. */
+    /* If we can't extend because we hit the commit limit, purge just
+       enough spare committed memory for the new chunk's overheads,
+       starting with a grain and doubling, and try again.  The VM arena
+       can then remap the rest of the spare memory into the new chunk
+       rather than returning it to the OS and mapping fresh pages.  See
+       <design/arena/#spare.remap>. */
     if (res == ResCOMMIT_LIMIT) {
-      if (Method(Arena, arena, purgeSpare)(arena, size) >= size)
+      Size purge = ArenaGrainSize(arena);
+      while (Method(Arena, arena, purgeSpare)(arena, purge) > 0) {
         res = Method(Arena, arena, grow)(arena, pref, size);
+        if (res != ResCOMMIT_LIMIT || purge >= size)
+          break;
+        purge *= 2;
+      }
     }
     if (res == ResOK) {
+      if (nodeZones != ZoneSetEMPTY) {
+        res = ArenaFreeLandAlloc(&tract, arena, nodeZones, pref->high,
+                                 size, pool);
+        if (res == ResOK)
+          goto found;
+      }
       if (zones != ZoneSetEMPTY) {
         res = ArenaFreeLandAlloc(&tract, arena, zones, pref->high, size, pool);
         if (res == ResOK)
@@ -106,8 +190,13 @@ Res PolicyAlloc(Tract *tractReturn, Arena arena, LocusPref pref,
    * objects with those from other generations, causing the zone check
    * to give false positives and slowing down the collector. */
   /* TODO: log an event for this */
-  evenMoreZones = ZoneSetDiff(ZoneSetUNIV, pref->avoid);
-  if (evenMoreZones != moreZones) {
+  if (evenMoreZones != withShared) {
+    if (fine) {
+      res = ArenaFreeLandAllocFine(&tract, arena, evenMoreZones,
+                                   pref->fineZones, pref->high, size, pool);
+      if (res == ResOK)
+        goto found;
+    }
     res = ArenaFreeLandAlloc(&tract, arena, evenMoreZones, pref->high,
                              size, pool);
     if (res == ResOK)
@@ -131,30 +220,314 @@ found:
 }
 
 
-/* policyCollectionTime -- estimate time to collect the world, in seconds */
+/* Rate -- measured rates of collection work
+ *
+ * .rate: The arena measures the rate at which segments and roots are
+ * scanned, and the rate at which condemned segments are reclaimed,
+ * and each pool measures the rate at which its segments are scanned
+ * at each rank.  The measurements come from the scanned size in the
+ * ScanState (see <design/type/#work>) and the clock.
+ *
+ * .rate.accumulate: A single scan may take less time than the
+ * resolution of the clock, so measurements are accumulated until
+ * ARENA_RATE_OBSERVATION_TIME has passed, and then the observed rate
+ * is folded into an exponentially weighted moving average, so that
+ * the estimate follows changes in the heap.
+ *
+ * .rate.sample: Reading the clock is not free, so only one in
+ * ARENA_RATE_SAMPLE segment scans, root scans and reclaims is timed.
+ * Root scans are sampled too, since otherwise they would be
+ * over-represented in the arena's scan rate.  See PolicyRateSample.
+ */
+
+void RateInit(Rate rate)
+{
+  AVER(rate != NULL);
+  rate->size = 0.0;
+  rate->time = 0.0;
+  rate->rate = 0.0;
+}
+
+Bool RateCheck(Rate rate)
+{
+  CHECKL(rate != NULL);
+  CHECKL(rate->size >= 0.0);
+  CHECKL(rate->time >= 0.0);
+  CHECKL(rate->rate >= 0.0);
+  return TRUE;
+}
+
+void RateAccumulate(Rate rate, Size size, Clock start, Clock end)
+{
+  double observed;
+
+  AVERT(Rate, rate);
+  AVER(start <= end);
+
+  rate->size += (double)size;
+  rate->time += (end - start) / (double)ClocksPerSec();
+  if (rate->time < ARENA_RATE_OBSERVATION_TIME)
+    return;
+
+  observed = rate->size / rate->time;
+  if (rate->rate == 0.0)
+    rate->rate = observed;
+  else
+    rate->rate += ARENA_RATE_ALPHA * (observed - rate->rate);
+  rate->size = 0.0;
+  rate->time = 0.0;
+}
+
+
+/* RateEstimate -- current estimate in bytes per second, or 0.0 if none */
+
+double RateEstimate(Rate rate)
+{
+  AVERT(Rate, rate);
+  return rate->rate;
+}
+
+
+/* PolicyRateSample -- should this scan or reclaim be timed?
+ *
+ * See .rate.sample.
+ */
+
+Bool PolicyRateSample(Arena arena)
+{
+  AVERT(Arena, arena);
+  ++arena->rateSample;
+  return arena->rateSample % ARENA_RATE_SAMPLE == 0;
+}
+
+
+/* policyCollectionTime -- estimate time to collect the world, in seconds
+ *
+ * Use the measured scan rate if there is one (see .rate), falling
+ * back to the average rate of tracing work, and failing that, to the
+ * default.  Add the time to reclaim only once the reclaim rate has
+ * been measured, since the tracing work already includes reclaiming.
+ */
 
 static double policyCollectionTime(Arena arena)
 {
   Size collectableSize;
-  double collectionRate;
+  double collectionRate, reclaimRate;
   double collectionTime;
-  
+
   AVERT(Arena, arena);
 
   collectableSize = ArenaCollectable(arena);
-  /* The condition arena->tracedTime >= 1.0 ensures that the division
-   * can't overflow. */
-  if (arena->tracedTime >= 1.0)
-    collectionRate = arena->tracedWork / arena->tracedTime;
-  else
-    collectionRate = ARENA_DEFAULT_COLLECTION_RATE;
+  collectionRate = RateEstimate(&arena->scanRate);
+  if (collectionRate == 0.0) {
+    /* The condition arena->tracedTime >= 1.0 ensures that the
+     * division can't overflow. */
+    if (arena->tracedTime >= 1.0)
+      collectionRate = arena->tracedWork / arena->tracedTime;
+    else
+      collectionRate = ARENA_DEFAULT_COLLECTION_RATE;
+  }
   collectionTime = collectableSize / collectionRate;
+  reclaimRate = RateEstimate(&arena->reclaimRate);
+  if (reclaimRate > 0.0)
+    collectionTime += collectableSize / reclaimRate;
   collectionTime += ARENA_DEFAULT_COLLECTION_OVERHEAD;
 
   return collectionTime;
 }
 
 
+/* PolicyQuantumWork -- limit the work done in one quantum
+ *
+ * quantumWork is the amount of work per poll needed to finish the
+ * trace in time.  If there is a measured scan rate, limit it to the
+ * amount that can be done in the arena's pause time, so that a single
+ * quantum doesn't overrun the pause: PolicyPollAgain does further
+ * quanta if there is time left.  Then split it according to the
+ * pause controller: see .pause.split.
+ */
+
+Work PolicyQuantumWork(Arena arena, Work quantumWork)
+{
+  double scanRate, pauseTime, work;
+
+  AVERT(Arena, arena);
+
+  work = (double)quantumWork;
+  scanRate = RateEstimate(&arena->scanRate);
+  pauseTime = ArenaPauseTime(arena);
+  if (scanRate > 0.0 && pauseTime > 0.0 && scanRate * pauseTime < work)
+    work = scanRate * pauseTime;
+  work *= arena->quantumScale;
+
+  return (Work)work + 1;
+}
+
+
+/* PolicyPause -- measure a pause and adjust the pause controller
+ *
+ * .pause: The controller aims to keep ARENA_PAUSE_PERCENTILE of the
+ * pauses in ArenaPoll within the arena's pause time.  start and end
+ * are the clock times at which the pause started and ended.
+ *
+ * .pause.background: A step of the background thread holds the arena
+ * lock, so a mutator that needs the lock waits for it just as it would
+ * for its own pause.  So background steps feed the controller too, but
+ * are counted separately (background is TRUE), so that the pause
+ * statistics describe the work done by the mutator itself.
+ *
+ * .pause.percentile: The pause time at the percentile is estimated by
+ * stochastic approximation: after each pause, the estimate moves up
+ * by ARENA_PAUSE_PERCENTILE steps if the pause was longer, and down
+ * by 1 - ARENA_PAUSE_PERCENTILE steps if not, so that it settles
+ * where the given fraction of pauses are shorter.
+ *
+ * .pause.split: If the estimate exceeds the pause time, the fraction
+ * of the trace's quantum of work done at a time is reduced, so that
+ * PolicyPollAgain can check the clock more often; otherwise it is
+ * increased again.  This can't split the scan of a single segment.
+ *
+ * .pause.defer: PolicyPollAgain predicts the time the next quantum
+ * will take from recent quanta, and defers it to the next poll if it
+ * would not fit in the pause time.
+ */
+
+void PolicyPause(Arena arena, Clock start, Clock end, Bool background)
+{
+  double pause, pauseTime, step;
+
+  AVERT(Arena, arena);
+  AVER(start <= end);
+  AVERT(Bool, background);
+
+  pause = (end - start) / (double)ClocksPerSec();
+  pauseTime = ArenaPauseTime(arena);
+  if (background) {
+    ++arena->backgroundCount;
+    arena->backgroundTime += pause;
+  } else {
+    ++arena->pauseCount;
+    if (pause > pauseTime)
+      ++arena->pauseOverCount;
+    arena->pauseTotal += pause;
+    if (pause > arena->pauseMax)
+      arena->pauseMax = pause;
+  }
+
+  /* The controller has nothing to aim at if the pause time is zero or
+     infinite. */
+  if (pauseTime > 0.0 && pauseTime <= DBL_MAX) {
+    step = ARENA_PAUSE_STEP * pauseTime;
+    if (pause > arena->pauseAchieved) {
+      arena->pauseAchieved += step * ARENA_PAUSE_PERCENTILE;
+    } else {
+      arena->pauseAchieved -= step * (1.0 - ARENA_PAUSE_PERCENTILE);
+      if (arena->pauseAchieved < 0.0)
+        arena->pauseAchieved = 0.0;
+    }
+
+    if (arena->pauseAchieved > pauseTime) {
+      arena->quantumScale /= 2.0;
+      if (arena->quantumScale < ARENA_QUANTUM_SCALE_MIN)
+        arena->quantumScale = ARENA_QUANTUM_SCALE_MIN;
+    } else {
+      arena->quantumScale *= 1.25;
+      if (arena->quantumScale > 1.0)
+        arena->quantumScale = 1.0;
+    }
+  }
+
+  EVENT4(ArenaPause, arena, pause, pauseTime, arena->pauseAchieved);
+}
+
+
+/* PolicyPressure -- respond to memory pressure
+ *
+ * Called by ArenaPoll (when there's no background thread) and
+ * ArenaBackgroundStep.  If the arena has a pressure monitor (see
+ * <code/press.h>) and it hasn't been read for ARENA_PRESSURE_INTERVAL,
+ * read it.  If the control group is under pressure, return all spare
+ * committed memory to the operating system now, and ask
+ * PolicyStartTrace to start a collection of the world.  See
+ * <design/arena/#pressure>.
+ */
+
+void PolicyPressure(Arena arena)
+{
+  PressureReadingStruct reading;
+  Clock now;
+  Size purged;
+  Bool pressure;
+
+  AVERT(Arena, arena);
+
+  if (arena->pressure == NULL)
+    return;
+  now = ClockNow();
+  if ((double)(now - arena->pressureLast)
+      < ARENA_PRESSURE_INTERVAL * (double)ClocksPerSec())
+    return;
+  arena->pressureLast = now;
+
+  if (PressureRead(&reading, arena->pressure) != ResOK)
+    return;
+  pressure = (reading.max > 0
+              && reading.current >= reading.max * ARENA_PRESSURE_FRACTION)
+    || reading.stall >= ARENA_PRESSURE_STALL;
+  if (!pressure)
+    return;
+
+  ++arena->pressureCount;
+  purged = Method(Arena, arena, purgeSpare)(arena, ArenaSpareCommitted(arena));
+  arena->pressureCollect = TRUE;
+  EVENT5(ArenaPressure, arena, reading.current, reading.max, reading.stall,
+         purged);
+}
+
+
+/* PolicyDecay -- return spare memory to the operating system gradually
+ *
+ * Called by ArenaBackgroundStep, ArenaStep, and TracePoll when a
+ * trace finishes, but not at every ArenaPoll.  If the arena has a spare decay
+ * time constant, purge the fraction of the spare committed memory
+ * that an exponential decay with that time constant would have lost
+ * since the last step, approximated linearly, but at least a grain so
+ * that the spare memory eventually drains.  See
+ * <design/arena/#spare.decay>.
+ */
+
+void PolicyDecay(Arena arena)
+{
+  Clock now;
+  double elapsed, fraction;
+  Size spare, size, purged;
+
+  AVERT(Arena, arena);
+
+  if (arena->spareDecay == 0.0)
+    return;
+  now = ClockNow();
+  elapsed = (double)(now - arena->spareDecayLast) / (double)ClocksPerSec();
+  if (elapsed < ARENA_SPARE_DECAY_INTERVAL)
+    return;
+  arena->spareDecayLast = now;
+
+  spare = ArenaSpareCommitted(arena);
+  if (spare == 0)
+    return;
+  fraction = elapsed / arena->spareDecay;
+  if (fraction >= 1.0)
+    size = spare;
+  else
+    size = (Size)((double)spare * fraction);
+  if (size < ArenaGrainSize(arena))
+    size = ArenaGrainSize(arena);
+
+  purged = Method(Arena, arena, purgeSpare)(arena, size);
+  EVENT3(ArenaSpareDecay, arena, purged, ArenaSpareCommitted(arena));
+}
+
+
 /* PolicyShouldCollectWorld -- should we collect the world now?
  *
  * Return TRUE if we should try collecting the world now, FALSE if
@@ -291,6 +664,31 @@ Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
   AVER(traceReturn != NULL);
   AVERT(Arena, arena);
 
+  /* Collect the world if PolicyPressure asked us to.  If the pressure
+   * persists (perhaps because of other processes in the control
+   * group), don't spend more than ARENA_PRESSURE_COLLECT_FRACTION of
+   * the time doing so. */
+  if (collectWorldAllowed && arena->pressureCollect) {
+    Clock now = ClockNow();
+    double sinceLast = ((now - arena->pressureCollectLast)
+                        / (double)ClocksPerSec());
+    arena->pressureCollect = FALSE;
+    if (ArenaCollectable(arena) >= ARENA_MINIMUM_COLLECTABLE_SIZE
+        && (arena->pressureCollections == 0
+            || sinceLast > (policyCollectionTime(arena)
+                            / ARENA_PRESSURE_COLLECT_FRACTION))) {
+      res = TraceStartCollectAll(&trace, arena, TraceStartWhyPRESSURE);
+      if (res == ResOK) {
+        ++arena->pressureCollections;
+        arena->pressureCollectLast = now;
+        arena->lastWorldCollect = now;
+        *collectWorldReturn = TRUE;
+        *traceReturn = trace;
+        return TRUE;
+      }
+    }
+  }
+
   if (collectWorldAllowed) {
     Size sFoundation, sCondemned, sSurvivors, sConsTrace;
     double tTracePerScan; /* tTrace/cScan */
@@ -379,6 +777,35 @@ Bool PolicyPoll(Arena arena)
 }
 
 
+/* PolicyPollBuffer -- should this buffer do the work?
+ *
+ * Called by BufferPoll when the arena has passed its poll threshold.
+ * Return TRUE if the buffer owes enough of the allocation debt to
+ * pay for the collection work; FALSE if it should leave the work to
+ * the buffers that allocate more.  See <design/buffer/#poll.debt>.
+ */
+
+Bool PolicyPollBuffer(Arena arena, Buffer buffer)
+{
+  Globals globals;
+
+  AVERT(Arena, arena);
+  AVERT(Buffer, buffer);
+
+  /* If the arena has fallen too far behind, everyone pays, so that
+     the heap can't grow without bound. */
+  globals = ArenaGlobals(arena);
+  if (globals->fillMutatorSize
+      >= globals->pollThreshold + ARENA_POLL_DEBT_LAG)
+    return TRUE;
+
+  if (buffer->exempt)
+    return FALSE;
+  return buffer->debt >= ARENA_POLL_DEBT
+    || buffer->debt >= globals->mutatorDebt * ARENA_POLL_DEBT_SHARE;
+}
+
+
 /* PolicyPollAgain -- do another unit of work?
  *
  * Return TRUE if the MPS should do another unit of work; FALSE if it
@@ -386,22 +813,45 @@ Bool PolicyPoll(Arena arena)
  *
  * start is the clock time when the MPS was entered.
  * moreWork and tracedWork are the results of the last call to TracePoll.
+ * background is TRUE if the caller is ArenaBackgroundStep, which has
+ * its own threshold: see <design/arena/#background.threshold>.
  */
 
-Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
+Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork,
+                     Work tracedWork, Bool background)
 {
   Bool moreTime;
+  Clock now;
   Globals globals;
   double nextPollThreshold;
 
   AVERT(Arena, arena);
   UNUSED(tracedWork);
+  AVERT(Bool, background);
+
+  /* Measure the quantum that just finished, to predict the time the
+     next one will take: see .pause.defer. */
+  now = ClockNow();
+  if (moreWork) {
+    Clock quantumStart = start;
+    double quantumTime;
+    if (arena->quantumStart > start)
+      quantumStart = arena->quantumStart;
+    quantumTime = (now - quantumStart) / (double)ClocksPerSec();
+    if (arena->quantumTime == 0.0)
+      arena->quantumTime = quantumTime;
+    else
+      arena->quantumTime += (ARENA_RATE_ALPHA
+                             * (quantumTime - arena->quantumTime));
+  }
+  arena->quantumStart = now;
 
   if (ArenaEmergency(arena))
     return TRUE;
 
   /* Is there more work to do and more time to do it in? */
-  moreTime = (ClockNow() - start) < ArenaPauseTime(arena) * ClocksPerSec();
+  moreTime = ((now - start) / (double)ClocksPerSec() + arena->quantumTime
+              < ArenaPauseTime(arena));
   if (moreWork && moreTime)
     return TRUE;
 
@@ -409,6 +859,19 @@ Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork)
 
   globals = ArenaGlobals(arena);
 
+  if (background) {
+    /* The background thread works on a timer, not when the mutator
+       reaches its threshold, so its threshold may get ahead of the
+       mutator, and it starts again from the mutator when there's no
+       more work.  See <design/arena/#background.threshold>. */
+    if (moreWork)
+      globals->backgroundThreshold += ArenaPollALLOCTIME;
+    else
+      globals->backgroundThreshold
+        = globals->fillMutatorSize + ArenaPollALLOCTIME;
+    return FALSE;
+  }
+
   if (moreWork) {
     /* We did one quantum of work; consume one unit of 'time'. */
     nextPollThreshold = globals->pollThreshold + ArenaPollALLOCTIME;
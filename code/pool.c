@@ -97,6 +97,7 @@ Bool PoolClassCheck(PoolClass klass)
 Bool PoolCheck(Pool pool)
 {
   PoolClass klass;
+  Rank rank;
   /* Checks ordered as per struct decl in <code/mpmst.h#pool> */
   CHECKS(Pool, pool);
   CHECKC(AbstractPool, pool);
@@ -113,6 +114,9 @@ Bool PoolCheck(Pool pool)
   /* Normally pool->format iff PoolHasAttr(pool, AttrFMT), but during
      pool initialization the class may not yet be set. */
   CHECKL(!PoolHasAttr(pool, AttrFMT) || pool->format != NULL);
+  for (rank = RankMIN; rank < RankLIMIT; ++rank)
+    CHECKD_NOSIG(Rate, &pool->scanRate[rank]);
+  CHECKL(pool->node == NodeANY || pool->node < MPS_WORD_WIDTH);
   return TRUE;
 }
 
@@ -122,6 +126,7 @@ Bool PoolCheck(Pool pool)
 ARG_DEFINE_KEY(FORMAT, Format);
 ARG_DEFINE_KEY(CHAIN, Chain);
 ARG_DEFINE_KEY(GEN, Cant);
+ARG_DEFINE_KEY(NUMA_NODE, Cant);
 ARG_DEFINE_KEY(RANK, Rank);
 ARG_DEFINE_KEY(EXTEND_BY, Size);
 ARG_DEFINE_KEY(LARGE_SIZE, Size);
@@ -209,6 +214,7 @@ void PoolDestroy(Pool pool)
   AVERT(Pool, pool); 
   arena = pool->arena;
   size = ClassOfPoly(Pool, pool)->size;
+  ArenaDefinalizePool(arena, pool);
   PoolFinish(pool);
 
   /* .space.free: Free the pool instance structure.  See .space.alloc */
@@ -107,6 +107,7 @@ static Res PoolAutoSetFix(Pool pool, ScanState ss, Seg seg, Ref *refIO);
 Res PoolAbsInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
   ArgStruct arg;
+  Rank rank;
   
   AVER(pool != NULL);
   AVERT(Arena, arena);
@@ -123,7 +124,14 @@ Res PoolAbsInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   pool->bufferSerial = (Serial)0;
   pool->alignment = MPS_PF_ALIGN;
   pool->format = NULL;
+  for (rank = RankMIN; rank < RankLIMIT; ++rank)
+    RateInit(&pool->scanRate[rank]);
   pool->fix = PoolAutoSetFix;
+  pool->node = NodeANY;
+  if (ArgPick(&arg, args, MPS_KEY_NUMA_NODE)) {
+    AVER(arg.val.u < MPS_WORD_WIDTH);
+    pool->node = arg.val.u;
+  }
 
   if (ArgPick(&arg, args, MPS_KEY_FORMAT)) {
     Format format = arg.val.format;
@@ -456,9 +464,8 @@ Res PoolSegAccess(Pool pool, Seg seg, Addr addr,
   AVERT(AccessSet, mode);
   /* can't check context as there is no Check method */
 
-  UNUSED(addr);
   UNUSED(context);
-  TraceSegAccess(PoolArena(pool), seg, mode);
+  TraceSegAccess(PoolArena(pool), seg, addr, mode);
   return ResOK;
 }
 
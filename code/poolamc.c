@@ -92,6 +92,12 @@ enum {
  * collection via TracePoll), and by hash array allocations (where we
  * don't want the allocation to provoke a collection that makes the
  * location dependency stale immediately).
+ *
+ * .seg.site: The "hasSite" flag is TRUE if the segment was filled by
+ * a mutator allocation point and has not yet been reclaimed, in which
+ * case "site" is the serial number of the allocation point's buffer,
+ * to which the survival of the segment's objects is attributed.  See
+ * <design/poolamc/#pretenure>.
  */
 
 typedef struct amcSegStruct *amcSeg;
@@ -106,6 +112,8 @@ typedef struct amcSegStruct {
   BOOLFIELD(accountedAsBuffered); /* .seg.accounted-as-buffered */
   BOOLFIELD(old);           /* .seg.old */
   BOOLFIELD(deferred);      /* .seg.deferred */
+  BOOLFIELD(hasSite);       /* .seg.site */
+  Serial site;              /* .seg.site */
   Sig sig;                  /* <code/misc.h#sig> */
 } amcSegStruct;
 
@@ -123,6 +131,7 @@ static Bool amcSegCheck(amcSeg amcseg)
   /* CHECKL(BoolCheck(amcseg->accountedAsBuffered)); <design/type/#bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->old)); <design/type/#bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->deferred)); <design/type/#bool.bitfield.check> */
+  /* CHECKL(BoolCheck(amcseg->hasSite)); <design/type/#bool.bitfield.check> */
   return TRUE;
 }
 
@@ -153,6 +162,8 @@ static Res AMCSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   amcseg->accountedAsBuffered = FALSE;
   amcseg->old = FALSE;
   amcseg->deferred = FALSE;
+  amcseg->hasSite = FALSE;
+  amcseg->site = 0;
 
   SetClassOfPoly(seg, CLASS(amcSeg));
   amcseg->sig = amcSegSig;
@@ -416,7 +427,9 @@ static Bool amcGenCheck(amcGen gen)
 
 /* amcBufStruct -- AMC Buffer subclass
  *
- * This subclass of SegBuf records a link to a generation.
+ * This subclass of SegBuf records a link to a generation, and for
+ * mutator buffers, the survival of the objects allocated through the
+ * buffer.  See <design/poolamc/#pretenure>.
  */
 
 #define amcBufSig ((Sig)0x519A3CBF) /* SIGnature AMC BuFfer  */
@@ -427,6 +440,13 @@ typedef struct amcBufStruct {
   SegBufStruct segbufStruct;    /* superclass fields must come first */
   amcGen gen;                   /* The AMC generation */
   Bool forHashArrays;           /* allocates hash table arrays, see AMCBufferFill */
+  Bool genPinned;               /* generation set by MPS_KEY_GEN */
+  Bool pretenure;               /* automatic pretenuring */
+  Count sampleSegs;             /* segments condemned in this sample */
+  Size sampleCondemned;         /* bytes condemned in this sample */
+  Size sampleSurvived;          /* bytes that survived in this sample */
+  Bool measured;                /* survival measured since gen set? */
+  double survival;              /* moving average of survival */
   Sig sig;                      /* <design/sig/> */
 } amcBufStruct;
 
@@ -441,6 +461,13 @@ static Bool amcBufCheck(amcBuf amcbuf)
   if(amcbuf->gen != NULL)
     CHECKD(amcGen, amcbuf->gen);
   CHECKL(BoolCheck(amcbuf->forHashArrays));
+  CHECKL(BoolCheck(amcbuf->genPinned));
+  CHECKL(BoolCheck(amcbuf->pretenure));
+  CHECKL(!(amcbuf->genPinned && amcbuf->pretenure));
+  CHECKL(amcbuf->sampleSurvived <= amcbuf->sampleCondemned);
+  CHECKL(BoolCheck(amcbuf->measured));
+  CHECKL(0.0 <= amcbuf->survival);
+  CHECKL(amcbuf->survival <= 1.0);
   /* hash array buffers only created by mutator */
   CHECKL(BufferIsMutator(MustBeA(Buffer, amcbuf)) || !amcbuf->forHashArrays);
   return TRUE;
@@ -466,7 +493,82 @@ static void amcBufSetGen(Buffer buffer, amcGen gen)
 }
 
 
+/* amcBufAccount -- account for the survival of a mutator buffer's
+ * objects
+ *
+ * condemned is the size of a segment filled by the buffer that has
+ * been condemned for the first time, and survived is the size of the
+ * objects in it that survived.  See <design/poolamc/#pretenure.stats>.
+ */
+
+static void amcBufAccount(Buffer buffer, Size condemned, Size survived)
+{
+  amcBuf amcbuf = MustBeA(amcBuf, buffer);
+  double observed;
+
+  AVER(BufferIsMutator(buffer));
+  AVER(survived <= condemned);
+
+  ++amcbuf->sampleSegs;
+  amcbuf->sampleCondemned += condemned;
+  amcbuf->sampleSurvived += survived;
+  if (amcbuf->sampleSegs < AMC_PRETENURE_SAMPLE)
+    return;
+
+  observed = (double)amcbuf->sampleSurvived / (double)amcbuf->sampleCondemned;
+  if (amcbuf->measured)
+    amcbuf->survival += AMC_PRETENURE_ALPHA * (observed - amcbuf->survival);
+  else
+    amcbuf->survival = observed;
+  amcbuf->measured = TRUE;
+  amcbuf->sampleSegs = 0;
+  amcbuf->sampleCondemned = 0;
+  amcbuf->sampleSurvived = 0;
+}
+
+
+/* amcBufPretenure -- choose the generation for a mutator buffer
+ *
+ * If automatic pretenuring is enabled for the buffer, move it to the
+ * next generation of the chain if its objects mostly survive, or back
+ * to the nursery if they mostly die.  See <design/poolamc/#pretenure.auto>.
+ */
+
+static void amcBufPretenure(AMC amc, Buffer buffer)
+{
+  amcBuf amcbuf = MustBeA(amcBuf, buffer);
+  amcGen gen, newGen;
+
+  AVER(BufferIsReset(buffer));
+  if (!amcbuf->pretenure || !amcbuf->measured)
+    return;
+
+  gen = amcbuf->gen;
+  newGen = gen;
+  if (amcbuf->survival >= AMC_PRETENURE_SURVIVAL)
+    /* The forwarding buffer of the ramp generation forwards to itself
+       while ramping. */
+    newGen = amcBufGen(gen->forward);
+  else if (amcbuf->survival < AMC_PRETENURE_DEMOTE)
+    newGen = amc->nursery;
+
+  /* Don't pretenure into the top generation: it's only collected by
+     collections of the world, so the objects might never die. */
+  if (newGen != gen && newGen != NULL && newGen != amc->gen[amc->gens]) {
+    EVENT4(AMCPretenure, amc, buffer, newGen, amcbuf->survival);
+    amcBufSetGen(buffer, newGen);
+    /* Survival must be measured afresh in the new generation. */
+    amcbuf->measured = FALSE;
+    amcbuf->survival = 0.0;
+    amcbuf->sampleSegs = 0;
+    amcbuf->sampleCondemned = 0;
+    amcbuf->sampleSurvived = 0;
+  }
+}
+
+
 ARG_DEFINE_KEY(ap_hash_arrays, Bool);
+ARG_DEFINE_KEY(AP_PRETENURE, Bool);
 
 #define amcKeyAPHashArrays (&_mps_key_ap_hash_arrays)
 
@@ -478,10 +580,20 @@ static Res AMCBufInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   amcBuf amcbuf;
   Res res;
   Bool forHashArrays = FALSE;
+  Bool pretenure = AMC_AP_PRETENURE_DEFAULT;
+  Bool genPinned = FALSE;
+  unsigned gen = 0;
   ArgStruct arg;
 
   if (ArgPick(&arg, args, amcKeyAPHashArrays))
     forHashArrays = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_AP_PRETENURE))
+    pretenure = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_GEN)) {
+    genPinned = TRUE;
+    gen = arg.val.u;
+    AVER(gen <= amc->gens);
+  }
 
   /* call next method */
   res = NextMethod(Buffer, amcBuf, init)(buffer, pool, isMutator, args);
@@ -489,14 +601,25 @@ static Res AMCBufInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
     return res;
   amcbuf = CouldBeA(amcBuf, buffer);
 
-  if (BufferIsMutator(buffer)) {
-    /* Set up the buffer to be allocating in the nursery. */
-    amcbuf->gen = amc->nursery;
-  } else {
+  if (!BufferIsMutator(buffer)) {
     /* No gen yet -- see <design/poolamc/#gen.forward>. */
     amcbuf->gen = NULL;
+  } else if (genPinned) {
+    /* Allocate in the generation the client asked for. */
+    amcbuf->gen = amc->gen[gen];
+  } else {
+    /* Set up the buffer to be allocating in the nursery. */
+    amcbuf->gen = amc->nursery;
   }
   amcbuf->forHashArrays = forHashArrays;
+  amcbuf->genPinned = BOOLOF(BufferIsMutator(buffer) && genPinned);
+  amcbuf->pretenure = BOOLOF(BufferIsMutator(buffer) && !genPinned
+                             && pretenure);
+  amcbuf->sampleSegs = 0;
+  amcbuf->sampleCondemned = 0;
+  amcbuf->sampleSurvived = 0;
+  amcbuf->measured = FALSE;
+  amcbuf->survival = 0.0;
 
   SetClassOfPoly(buffer, CLASS(amcBuf));
   amcbuf->sig = amcBufSig;
@@ -519,12 +642,39 @@ static void AMCBufFinish(Inst inst)
 }
 
 
+/* AMCBufDescribe -- describe an amcBuf */
+
+static Res AMCBufDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
+{
+  amcBuf amcbuf = CouldBeA(amcBuf, inst);
+  Res res;
+
+  if (!TESTC(amcBuf, amcbuf))
+    return ResPARAM;
+  if (stream == NULL)
+    return ResPARAM;
+
+  res = NextMethod(Inst, amcBuf, describe)(inst, stream, depth);
+  if (res != ResOK)
+    return res;
+
+  return WriteF(stream, depth + 2,
+                "gen $P", (WriteFP)amcbuf->gen,
+                amcbuf->genPinned ? " pinned" : "",
+                amcbuf->pretenure ? " pretenure" : "", "\n",
+                "survival $D", (WriteFD)amcbuf->survival,
+                amcbuf->measured ? "\n" : " (not measured)\n",
+                NULL);
+}
+
+
 /* amcBufClass -- The class definition */
 
 DEFINE_CLASS(Buffer, amcBuf, klass)
 {
   INHERIT_CLASS(klass, amcBuf, SegBuf);
   klass->instClassStruct.finish = AMCBufFinish;
+  klass->instClassStruct.describe = AMCBufDescribe;
   klass->size = sizeof(amcBufStruct);
   klass->init = AMCBufInit;
 }
@@ -750,6 +900,7 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   } else {
     amc->pinned = amcPinnedBase;
   }
+  amc->gens = 0; /* set below */
   /* .extend-by.aligned: extendBy is aligned to the arena alignment. */
   amc->extendBy = SizeArenaGrains(extendBy, arena);
   amc->largeSize = largeSize;
@@ -781,6 +932,7 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
     /* Dynamic gen forwards to itself. */
     amcBufSetGen(amc->gen[genCount]->forward, amc->gen[genCount]);
   }
+  amc->gens = genCount;
   amc->nursery = amc->gen[0];
   amc->rampGen = amc->gen[genCount-1]; /* last ephemeral gen */
   amc->afterRampGen = amc->gen[genCount];
@@ -901,6 +1053,8 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   AVER(SizeIsAligned(size, PoolAlignment(pool)));
 
   arena = PoolArena(pool);
+  if (BufferIsMutator(buffer))
+    amcBufPretenure(amc, buffer);
   gen = amcBufGen(buffer);
   AVERT(amcGen, gen);
   pgen = &gen->pgen;
@@ -915,7 +1069,8 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   }
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, amcKeySegGen, p, gen);
-    res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize, args);
+    res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize,
+                       BufferNode(buffer), args);
   } MPS_ARGS_END(args);
   if(res != ResOK)
     return res;
@@ -927,6 +1082,14 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   else
     SegSetRankAndSummary(seg, BufferRankSet(buffer), RefSetUNIV);
 
+  /* Large segments of scannable objects get cards, so that a write
+     barrier hit doesn't cause the whole segment to be scanned.  Cards
+     are only an optimization, so failure is ignored.  See
+     <design/poolamc/#scan.cards>. */
+  if (BufferRankSet(buffer) != RankSetEMPTY
+      && grainsSize >= AMC_CARDS_MIN * ArenaGrainSize(arena))
+    (void)SegCardsInit(seg);
+
   /* If ramping, or if the buffer is intended for allocating hash
    * table arrays, defer the size accounting. */
   if ((amc->rampMode == RampRAMPING
@@ -937,6 +1100,13 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
     MustBeA(amcSeg, seg)->deferred = TRUE;
   }
 
+  /* Attribute the survival of the segment's objects to the buffer.
+     See <design/poolamc/#pretenure.stats>. */
+  if (BufferIsMutator(buffer)) {
+    MustBeA(amcSeg, seg)->hasSite = TRUE;
+    MustBeA(amcSeg, seg)->site = buffer->serial;
+  }
+
   base = SegBase(seg);
   if (size < amc->largeSize) {
     /* Small or Medium segment: give the buffer the entire seg. */
@@ -1352,6 +1522,114 @@ static Res amcScanNailed(Bool *totalReturn, ScanState ss, Pool pool,
 }
 
 
+/* amcScanCardsRun -- scan a run of objects for amcScanCards
+ *
+ * Scans the objects from base to limit (client pointers) and adds the
+ * summary of their references to the cards from card0 to card1
+ * inclusive, which are the cards that the objects overlap.
+ */
+
+static Res amcScanCardsRun(ScanState ss, Seg seg, Format format,
+                           Addr base, Addr limit, Index card0, Index card1)
+{
+  RefSet unfixed = ScanStateUnfixedSummary(ss);
+  RefSet fixed = ss->fixedSummary;
+  RefSet summary;
+  Index i;
+  Res res;
+
+  ScanStateSetSummary(ss, RefSetEMPTY);
+  res = FormatScan(format, ss, base, limit);
+  summary = ScanStateSummary(ss);
+  ScanStateSetUnfixedSummary(ss, RefSetUnion(unfixed,
+                                             ScanStateUnfixedSummary(ss)));
+  ss->fixedSummary = RefSetUnion(fixed, ss->fixedSummary);
+  if (res != ResOK)
+    return res;
+
+  for (i = card0; i <= card1; ++i)
+    SegSetCardSummary(seg, i, RefSetUnion(SegCardSummary(seg, i), summary));
+  return ResOK;
+}
+
+
+/* amcScanCards -- scan the cards of a segment that need it
+ *
+ * A card needs scanning if it is dirty or its summary meets the white
+ * set.  Runs of objects that overlap such cards are scanned, and the
+ * rest are skipped over using the format's skip method.  The cards
+ * that need scanning get new summaries; the others keep their old
+ * summaries, which are added to the scan state's summary, so that the
+ * scan is total.  If the scan fails, some cards have been cleared
+ * without being scanned, but they all get the summary that the trace
+ * then sets on the segment.  See <design/poolamc/#scan.cards>.
+ */
+
+static Res amcScanCards(ScanState ss, Seg seg, Format format)
+{
+  Size headerSize = format->headerSize;
+  ZoneSet white = ScanStateWhite(ss);
+  RefSet skipped = RefSetEMPTY;
+  Addr p, limit, runBase = NULL;
+  Index nextCard = 0, runCard0 = 0, runCard1 = 0;
+  Bool lastNeeded = FALSE;
+  Res res;
+
+  p = AddrAdd(SegBase(seg), headerSize);
+  limit = AddrAdd(SegLimit(seg), headerSize);
+  while (p < limit) {
+    Addr q = (*format->skip)(p);
+    Index i, card0, card1;
+    Bool needed;
+
+    AVER(p < q);
+    card0 = SegCardIndex(seg, AddrSub(p, headerSize));
+    card1 = SegCardIndex(seg, AddrSub(q, headerSize + 1));
+
+    /* Objects are contiguous, so only the first card of this object
+       can have been seen before, as the last card of the previous one. */
+    AVER(card0 + 1 >= nextCard);
+    needed = card0 < nextCard && lastNeeded;
+    for (i = nextCard; i <= card1; ++i) {
+      lastNeeded = SegCardIsDirty(seg, i)
+        || ZoneSetInter(SegCardSummary(seg, i), white) != ZoneSetEMPTY;
+      if (lastNeeded)
+        SegSetCardSummary(seg, i, RefSetEMPTY);
+      else
+        skipped = RefSetUnion(skipped, SegCardSummary(seg, i));
+      needed = needed || lastNeeded;
+    }
+    if (nextCard <= card1)
+      nextCard = card1 + 1;
+
+    if (needed) {
+      if (runBase == NULL) {
+        runBase = p;
+        runCard0 = card0;
+      }
+      runCard1 = card1;
+    } else if (runBase != NULL) {
+      res = amcScanCardsRun(ss, seg, format, runBase, p, runCard0, runCard1);
+      if (res != ResOK)
+        return res;
+      runBase = NULL;
+    }
+    p = q;
+  }
+  AVER(p == limit);
+
+  if (runBase != NULL) {
+    res = amcScanCardsRun(ss, seg, format, runBase, p, runCard0, runCard1);
+    if (res != ResOK)
+      return res;
+  }
+
+  ss->fixedSummary = RefSetUnion(ss->fixedSummary, skipped);
+  SegCardsScanned(seg);
+  return ResOK;
+}
+
+
 /* AMCScan -- scan a single seg, turning it black
  *
  * See <design/poolamc/#seg-scan>.
@@ -1377,6 +1655,18 @@ static Res AMCScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
 
   EVENT3(AMCScanBegin, amc, seg, ss);
 
+  /* <design/poolamc/#scan.cards> */
+  if (SegHasCards(seg) && !SegHasBuffer(seg)) {
+    res = amcScanCards(ss, seg, format);
+    if (res != ResOK) {
+      *totalReturn = FALSE;
+      return res;
+    }
+    EVENT3(AMCScanEnd, amc, seg, ss);
+    *totalReturn = TRUE;
+    return ResOK;
+  }
+
   base = AddrAdd(SegBase(seg), format->headerSize);
   /* <design/poolamc/#seg-scan.loop> */
   while (SegBuffer(&buffer, seg)) {
@@ -1476,8 +1766,10 @@ static Res AMCFixEmergency(Pool pool, ScanState ss, Seg seg,
 
   ss->wasMarked = TRUE;
 
-  if(ss->rank == RankAMBIG)
+  if(ss->rank == RankAMBIG) {
+    LocusAmbigHit(arena, *refIO); /* <design/arena/#zone.blacklist> */
     goto fixInPlace;
+  }
 
   ShieldExpose(arena, seg);
   newRef = (*pool->format->isMoved)(*refIO);
@@ -1550,6 +1842,7 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
       STATISTIC(++ss->nailCount);
       SegSetNailed(seg, TraceSetUnion(SegNailed(seg), ss->traces));
     }
+    LocusAmbigHit(PoolArena(pool), *refIO); /* <design/arena/#zone.blacklist> */
     amcFixInPlace(pool, seg, ss, refIO);
     return ResOK;
   }
@@ -1658,6 +1951,34 @@ returnRes:
 }
 
 
+/* amcSegAccountSite -- attribute survival to the segment's buffer
+ *
+ * Called when the segment is reclaimed.  Only the first reclaim of a
+ * segment filled by a mutator buffer is attributed, and only if the
+ * buffer still exists.  See <design/poolamc/#pretenure.stats>.
+ */
+
+static void amcSegAccountSite(Pool pool, Seg seg, Size survived)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  Ring node, next;
+
+  if (!amcseg->hasSite)
+    return;
+  amcseg->hasSite = FALSE;
+
+  RING_FOR(node, &pool->bufferRing, next) {
+    Buffer buffer = RING_ELT(Buffer, poolRing, node);
+    if (buffer->serial == amcseg->site) {
+      Size condemned = SegSize(seg);
+      amcBufAccount(buffer, condemned,
+                    survived < condemned ? survived : condemned);
+      break;
+    }
+  }
+}
+
+
 /* amcReclaimNailed -- reclaim what you can from a nailed segment */
 
 static void amcReclaimNailed(Pool pool, Trace trace, Seg seg)
@@ -1752,6 +2073,12 @@ static void amcReclaimNailed(Pool pool, Trace trace, Seg seg)
   }
   GenDescSurvived(pgen->gen, trace, MustBeA(amcSeg, seg)->forwarded[trace->ti],
                   preservedInPlaceSize);
+  if (!SegHasBuffer(seg))
+    amcSegAccountSite(pool, seg, (MustBeA(amcSeg, seg)->forwarded[trace->ti]
+                                  + preservedInPlaceSize));
+  else
+    /* The buffer's unused space would count as survival. */
+    MustBeA(amcSeg, seg)->hasSite = FALSE;
 
   /* Free the seg if we can; fixes .nailboard.limitations.middle. */
   if(preservedInPlaceCount == 0
@@ -1807,6 +2134,7 @@ static void AMCReclaim(Pool pool, Trace trace, Seg seg)
   STATISTIC(trace->reclaimSize += SegSize(seg));
 
   GenDescSurvived(gen->pgen.gen, trace, amcseg->forwarded[trace->ti], 0);
+  amcSegAccountSite(pool, seg, amcseg->forwarded[trace->ti]);
   PoolGenFree(&gen->pgen, seg, 0, SegSize(seg), 0, amcseg->deferred);
 }
 
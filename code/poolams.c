@@ -639,7 +639,7 @@ static Res AMSSegSizePolicy(Size *sizeReturn,
 /* AMSSegCreate -- create a single AMSSeg */
 
 static Res AMSSegCreate(Seg *segReturn, Pool pool, Size size,
-                        RankSet rankSet)
+                        RankSet rankSet, Index node)
 {
   Seg seg;
   AMS ams;
@@ -661,13 +661,13 @@ static Res AMSSegCreate(Seg *segReturn, Pool pool, Size size,
     goto failSize;
 
   res = PoolGenAlloc(&seg, ams->pgen, (*ams->segClass)(), prefSize,
-                     argsNone);
+                     node, argsNone);
   if (res != ResOK) { /* try to allocate one that's just large enough */
     Size minSize = SizeArenaGrains(size, arena);
     if (minSize == prefSize)
       goto failSeg;
     res = PoolGenAlloc(&seg, ams->pgen, (*ams->segClass)(), prefSize,
-                       argsNone);
+                       node, argsNone);
     if (res != ResOK)
       goto failSeg;
   }
@@ -945,7 +945,7 @@ static Res AMSBufferFill(Addr *baseReturn, Addr *limitReturn,
   }
 
   /* No suitable segment found; make a new one. */
-  res = AMSSegCreate(&seg, pool, size, rankSet);
+  res = AMSSegCreate(&seg, pool, size, rankSet, BufferNode(buffer));
   if (res != ResOK)
     return res;
   b = amsSegAlloc(&base, &limit, seg, size);
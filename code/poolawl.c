@@ -432,7 +432,7 @@ static void AWLNoteScan(AWL awl, Seg seg, ScanState ss)
 /* AWLSegCreate -- Create a new segment of at least given size */
 
 static Res AWLSegCreate(AWLSeg *awlsegReturn,
-                        RankSet rankSet, Pool pool, Size size)
+                        RankSet rankSet, Pool pool, Size size, Index node)
 {
   AWL awl = MustBeA(AWLPool, pool);
   Arena arena = PoolArena(pool);
@@ -449,7 +449,7 @@ static Res AWLSegCreate(AWLSeg *awlsegReturn,
     return ResMEMORY;
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, awlKeySegRankSet, u, rankSet);
-    res = PoolGenAlloc(&seg, awl->pgen, CLASS(AWLSeg), size, args);
+    res = PoolGenAlloc(&seg, awl->pgen, CLASS(AWLSeg), size, node, args);
   } MPS_ARGS_END(args);
   if (res != ResOK)
     return res;
@@ -639,7 +639,8 @@ static Res AWLBufferFill(Addr *baseReturn, Addr *limitReturn,
 
   /* No free space in existing awlsegs, so create new awlseg */
 
-  res = AWLSegCreate(&awlseg, BufferRankSet(buffer), pool, size);
+  res = AWLSegCreate(&awlseg, BufferRankSet(buffer), pool, size,
+                     BufferNode(buffer));
   if (res != ResOK)
     return res;
   base = SegBase(MustBeA(Seg, awlseg));
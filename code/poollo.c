@@ -258,7 +258,8 @@ static Bool loSegFindFree(Addr *bReturn, Addr *lReturn,
  * Segments will be multiples of ArenaGrainSize.
  */
 
-static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size)
+static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size,
+                       Index node)
 {
   LO lo = MustBeA(LOPool, pool);
   Seg seg;
@@ -269,7 +270,7 @@ static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size)
 
   res = PoolGenAlloc(&seg, lo->pgen, CLASS(LOSeg),
                      SizeArenaGrains(size, PoolArena(pool)),
-                     argsNone);
+                     node, argsNone);
   if (res != ResOK)
     return res;
 
@@ -567,7 +568,7 @@ static Res LOBufferFill(Addr *baseReturn, Addr *limitReturn,
   }
 
   /* No segment had enough space, so make a new one. */
-  res = loSegCreate(&loseg, pool, size);
+  res = loSegCreate(&loseg, pool, size, BufferNode(buffer));
   if(res != ResOK)
     return res;
   seg = MustBeA(Seg, loseg);
@@ -766,6 +766,53 @@ Res MRGDeregister(Pool pool, Ref obj)
 }
 
 
+/* MRGDeregisterPool -- deregister every object in a pool
+ *
+ * Called when objPool is being destroyed, so that guardians don't
+ * keep references to its memory, which might be reused by another
+ * pool.  Like MRGDeregister, this loops over all finalizable objects.
+ * See <design/finalize/#int.pool-destroy>.
+ */
+
+void MRGDeregisterPool(Pool pool, Pool objPool)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Arena arena = PoolArena(pool);
+  Ring node, nextNode;
+  Count nGuardians;       /* guardians per seg */
+
+  AVERT(Pool, objPool);
+  AVER(objPool != pool);
+
+  nGuardians = MRGGuardiansPerSeg(mrg);
+
+  RING_FOR(node, &mrg->refRing, nextNode) {
+    MRGRefSeg refSeg = RING_ELT(MRGRefSeg, mrgRing, node);
+    MRGLinkSeg linkSeg;
+    Count i;
+    Link link;
+    RefPart refPart;
+
+    AVERT(MRGRefSeg, refSeg);
+    linkSeg = refSeg->linkSeg;
+    for(i = 0, link = (Link)SegBase(MustBeA(Seg, linkSeg)),
+          refPart = (RefPart)SegBase(MustBeA(Seg, refSeg));
+        i < nGuardians;
+        ++i, ++link, ++refPart) {
+      Pool refPool;
+      if (link->state == MRGGuardianPREFINAL
+          && PoolOfAddr(&refPool, arena,
+                        (Addr)MRGRefPartRef(arena, refPart))
+          && refPool == objPool) {
+        RingRemove(&link->the.linkRing);
+        RingFinish(&link->the.linkRing);
+        MRGGuardianInit(mrg, link, refPart);
+      }
+    }
+  }
+}
+
+
 /* MRGDescribe -- describe an MRG pool
  *
  * This could be improved by implementing MRGSegDescribe
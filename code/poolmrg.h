@@ -15,6 +15,7 @@ typedef struct MRGStruct *MRG;
 extern PoolClass PoolClassMRG(void);
 extern Res MRGRegister(Pool, Ref);
 extern Res MRGDeregister(Pool, Ref);
+extern void MRGDeregisterPool(Pool, Pool);
 
 #endif /* poolmrg_h */
 
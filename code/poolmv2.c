@@ -41,7 +41,7 @@ static void MVTFree(Pool pool, Addr base, Size size);
 static Res MVTDescribe(Inst inst, mps_lib_FILE *stream, Count depth);
 static Size MVTTotalSize(Pool pool);
 static Size MVTFreeSize(Pool pool);
-static Res MVTSegAlloc(Seg *segReturn, MVT mvt, Size size);
+static Res MVTSegAlloc(Seg *segReturn, MVT mvt, Size size, Index node);
 
 static void MVTSegFree(MVT mvt, Seg seg);
 static Bool MVTReturnSegs(MVT mvt, Range range, Arena arena);
@@ -496,7 +496,8 @@ static void MVTNoteFill(MVT mvt, Addr base, Addr limit, Size minSize) {
 static Res MVTOversizeFill(Addr *baseReturn,
                            Addr *limitReturn,
                            MVT mvt,
-                           Size minSize)
+                           Size minSize,
+                           Index node)
 {
   Res res;
   Seg seg;
@@ -505,7 +506,7 @@ static Res MVTOversizeFill(Addr *baseReturn,
 
   alignedSize = SizeArenaGrains(minSize, PoolArena(MVTPool(mvt)));
 
-  res = MVTSegAlloc(&seg, mvt, alignedSize);
+  res = MVTSegAlloc(&seg, mvt, alignedSize, node);
   if (res != ResOK)
     return res;
 
@@ -664,13 +665,13 @@ static Bool MVTContingencyFill(Addr *baseReturn, Addr *limitReturn,
 
 static Res MVTSegFill(Addr *baseReturn, Addr *limitReturn,
                       MVT mvt, Size fillSize,
-                      Size minSize)
+                      Size minSize, Index node)
 {
   Res res;
   Seg seg;
   Addr base, limit;
 
-  res = MVTSegAlloc(&seg, mvt, fillSize);
+  res = MVTSegAlloc(&seg, mvt, fillSize, node);
   if (res != ResOK)
     return res;
 
@@ -708,7 +709,7 @@ static Res MVTBufferFill(Addr *baseReturn, Addr *limitReturn,
      <design/poolmvt/#arch.ap.no-fit.oversize> */
   if (minSize > mvt->fillSize) {
     return MVTOversizeFill(baseReturn, limitReturn, mvt,
-                           minSize);
+                           minSize, BufferNode(buffer));
   }
 
   /* Use any splinter, if available.
@@ -733,7 +734,7 @@ static Res MVTBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* Attempt to request a block from the arena.
      <design/poolmvt/#impl.c.free.merge.segment> */
   res = MVTSegFill(baseReturn, limitReturn,
-                   mvt, mvt->fillSize, minSize);
+                   mvt, mvt->fillSize, minSize, BufferNode(buffer));
   if (res == ResOK)
     return ResOK;
 
@@ -1133,11 +1134,17 @@ mps_pool_class_t mps_class_mvt(void)
 
 /* MVTSegAlloc -- encapsulates SegAlloc with associated accounting and
  * metering
+ *
+ * The node is the preferred NUMA node of the buffer being filled.
  */
-static Res MVTSegAlloc(Seg *segReturn, MVT mvt, Size size)
+static Res MVTSegAlloc(Seg *segReturn, MVT mvt, Size size, Index node)
 {
-  Res res = SegAlloc(segReturn, CLASS(Seg), LocusPrefDefault(), size,
-                     MVTPool(mvt), argsNone);
+  LocusPrefStruct pref;
+  Res res;
+
+  LocusPrefInit(&pref);
+  LocusPrefExpress(&pref, LocusPrefNODE, &node);
+  res = SegAlloc(segReturn, CLASS(Seg), &pref, size, MVTPool(mvt), argsNone);
 
   if (res == ResOK) {
     Size segSize = SegSize(*segReturn);
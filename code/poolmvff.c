@@ -199,8 +199,9 @@ static void MVFFReduce(MVFF mvff)
  * size. The specified size should be pool-aligned. Add it to the
  * allocated and free lists.
  */
-static Res MVFFExtend(Range rangeReturn, MVFF mvff, Size size)
+static Res MVFFExtend(Range rangeReturn, MVFF mvff, Size size, Index node)
 {
+  LocusPrefStruct pref;
   Pool pool;
   Arena arena;
   Size allocSize;
@@ -225,12 +226,14 @@ static Res MVFFExtend(Range rangeReturn, MVFF mvff, Size size)
 
   allocSize = SizeArenaGrains(allocSize, arena);
 
-  res = ArenaAlloc(&base, MVFFLocusPref(mvff), allocSize, pool);
+  pref = *MVFFLocusPref(mvff);
+  LocusPrefExpress(&pref, LocusPrefNODE, &node);
+  res = ArenaAlloc(&base, &pref, allocSize, pool);
   if (res != ResOK) {
     /* try again with a range just large enough for object */
     /* see <design/poolmvff/#design.seg-fail> */
     allocSize = SizeArenaGrains(size, arena);
-    res = ArenaAlloc(&base, MVFFLocusPref(mvff), allocSize, pool);
+    res = ArenaAlloc(&base, &pref, allocSize, pool);
     if (res != ResOK)
       return res;
   }
@@ -260,10 +263,12 @@ static Res MVFFExtend(Range rangeReturn, MVFF mvff, Size size)
  * policy (first fit, last fit, or worst fit) specified by findMethod
  * and findDelete.
  *
- * If there is no suitable free block, try extending the pool.
+ * If there is no suitable free block, try extending the pool, with
+ * memory from the given NUMA node (or NodeANY for the pool's).
  */
 static Res mvffFindFree(Range rangeReturn, MVFF mvff, Size size,
-                        LandFindMethod findMethod, FindDelete findDelete)
+                        LandFindMethod findMethod, FindDelete findDelete,
+                        Index node)
 {
   Bool found;
   RangeStruct oldRange;
@@ -281,7 +286,7 @@ static Res mvffFindFree(Range rangeReturn, MVFF mvff, Size size,
   if (!found) {
     RangeStruct newRange;
     Res res;
-    res = MVFFExtend(&newRange, mvff, size);
+    res = MVFFExtend(&newRange, mvff, size, node);
     if (res != ResOK)
       return res;
     found = (*findMethod)(rangeReturn, &oldRange, land, size, findDelete);
@@ -321,7 +326,7 @@ static Res MVFFAlloc(Addr *aReturn, Pool pool, Size size)
   findMethod = mvff->firstFit ? LandFindFirst : LandFindLast;
   findDelete = mvff->slotHigh ? FindDeleteHIGH : FindDeleteLOW;
 
-  res = mvffFindFree(&range, mvff, size, findMethod, findDelete);
+  res = mvffFindFree(&range, mvff, size, findMethod, findDelete, NodeANY);
   if (res != ResOK)
     return res;
 
@@ -380,7 +385,8 @@ static Res MVFFBufferFill(Addr *baseReturn, Addr *limitReturn,
   AVER(size > 0);
   AVER(SizeIsAligned(size, PoolAlignment(pool)));
 
-  res = mvffFindFree(&range, mvff, size, LandFindLargest, FindDeleteENTIRE);
+  res = mvffFindFree(&range, mvff, size, LandFindLargest, FindDeleteENTIRE,
+                     BufferNode(buffer));
   if (res != ResOK)
     return res;
   AVER(RangeSize(&range) >= size);
@@ -408,6 +408,8 @@ static Res SNCBufferFill(Addr *baseReturn, Addr *limitReturn,
   Res res;
   Seg seg;
   Size asize;           /* aligned size */
+  LocusPrefStruct pref;
+  Index node;
 
   AVER(baseReturn != NULL);
   AVER(limitReturn != NULL);
@@ -427,8 +429,10 @@ static Res SNCBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* No free seg, so create a new one */
   arena = PoolArena(pool);
   asize = SizeArenaGrains(size, arena);
-  res = SegAlloc(&seg, CLASS(SNCSeg), LocusPrefDefault(),
-                 asize, pool, argsNone);
+  node = BufferNode(buffer);
+  LocusPrefInit(&pref);
+  LocusPrefExpress(&pref, LocusPrefNODE, &node);
+  res = SegAlloc(&seg, CLASS(SNCSeg), &pref, asize, pool, argsNone);
   if (res != ResOK)
     return res;
 
@@ -0,0 +1,115 @@
+/* press.h: MEMORY PRESSURE MONITOR
+ *
+ *  $Id$
+ *  Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ *  .purpose: Reads the memory usage and memory pressure of the
+ *  control group the process runs in, so that the arena can give
+ *  memory back before the kernel kills the process.  See
+ *  <design/arena/#pressure>.  The reading is platform specific (see
+ *  pressli.c, pressan.c); what the arena does about it is in
+ *  PolicyPressure in policy.c.
+ */
+
+#ifndef press_h
+#define press_h
+
+#include "mpmtypes.h"
+
+
+#define PressureSig     ((Sig)0x519B4E55) /* SIGnature PRESSure */
+
+
+/* PressureReadingStruct -- a reading of the memory pressure
+ *
+ * current is the memory in use by the control group, and max is its
+ * limit, both in bytes; max is zero if there is no limit.  stall is
+ * the percentage of the last ten seconds in which some tasks were
+ * stalled waiting for memory, or zero if the kernel doesn't report
+ * this.
+ */
+
+typedef struct PressureReadingStruct {
+  Size current;                 /* memory in use */
+  Size max;                     /* memory limit, or zero */
+  double stall;                 /* percentage of time stalled on memory */
+} PressureReadingStruct;
+
+
+/* PressureSize -- return the size of a PressureStruct
+ *
+ * Supports allocation of pressure monitors in the control pool.
+ */
+
+extern size_t PressureSize(void);
+
+extern Bool PressureCheck(Pressure pressure);
+
+
+/* PressureInit -- initialize a pressure monitor
+ *
+ * path is the control group directory to read.  It is copied, so
+ * need not outlive the monitor.  Returns ResIO if the directory
+ * can't be read, and ResUNIMPL on platforms without control groups.
+ */
+
+extern Res PressureInit(Pressure pressure, Arena arena, const char *path);
+
+
+/* PressureRead -- read the memory pressure
+ *
+ * Returns ResIO if the control group files can't be read.
+ */
+
+extern Res PressureRead(PressureReadingStruct *readingReturn,
+                        Pressure pressure);
+
+
+/* PressureFinish -- finish a pressure monitor */
+
+extern void PressureFinish(Pressure pressure);
+
+
+#endif /* press_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,103 @@
+/* pressan.c: MEMORY PRESSURE MONITOR FOR ANSI
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Standard C has no way to find out about memory pressure,
+ * so PressureInit fails, and so creating an arena with
+ * MPS_KEY_ARENA_PRESSURE_PATH fails with MPS_RES_UNIMPL.  See
+ * <design/arena/#pressure>.
+ */
+
+#include "press.h"
+#include "mpm.h"
+
+SRCID(pressan, "$Id$");
+
+
+typedef struct PressureStruct {
+  Sig sig;                      /* <design/sig/> */
+} PressureStruct;
+
+
+size_t (PressureSize)(void)
+{
+  return sizeof(PressureStruct);
+}
+
+
+Bool (PressureCheck)(Pressure pressure)
+{
+  CHECKS(Pressure, pressure);
+  return TRUE;
+}
+
+
+Res (PressureInit)(Pressure pressure, Arena arena, const char *path)
+{
+  AVER(pressure != NULL);
+  AVER(TESTT(Arena, arena));
+  AVER(path != NULL);
+  UNUSED(pressure);
+  UNUSED(arena);
+  UNUSED(path);
+  return ResUNIMPL;
+}
+
+
+Res (PressureRead)(PressureReadingStruct *readingReturn, Pressure pressure)
+{
+  AVER(readingReturn != NULL);
+  AVERT(Pressure, pressure);
+  NOTREACHED;
+  return ResUNIMPL;
+}
+
+
+void (PressureFinish)(Pressure pressure)
+{
+  AVERT(Pressure, pressure);
+  NOTREACHED;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,285 @@
+/* pressli.c: MEMORY PRESSURE MONITOR FOR LINUX
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .cgroup: Reads the control group version 2 interface files
+ * memory.current, memory.max and memory.pressure in a directory given
+ * by the client, normally the control group's directory under
+ * /sys/fs/cgroup.  Tests may point it at a directory of fake files.
+ * See <design/arena/#pressure>.
+ *
+ * .psi: memory.pressure holds the kernel's pressure stall information
+ * for memory, in the form:
+ *
+ *   some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ *   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ *
+ * We use the "some avg10" figure: the percentage of the last ten
+ * seconds in which at least one task was stalled waiting for memory.
+ *
+ * .missing: Any of the files may be missing (for example, the root
+ * control group has no memory.max, and kernels before 4.20 have no
+ * memory.pressure), in which case that part of the reading is zero.
+ * Only if none of them can be read is the directory considered
+ * unreadable.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "press.h"
+#include "mpm.h"
+
+
+#if !defined(MPS_OS_LI)
+#error "pressli.c is Linux specific."
+#endif
+
+SRCID(pressli, "$Id$");
+
+
+/* The longest of the file names, used to size the name buffers. */
+#define pressureLONGEST "/memory.pressure"
+
+/* Size of the buffer into which each file is read.  The figures we
+ * need are all near the start of their files. */
+#define pressureBUFFER_SIZE ((size_t)128)
+
+
+typedef struct PressureStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* arena owning the monitor */
+  char *names;                  /* block holding the file names */
+  Size namesSize;               /* size of the block */
+  char *currentName;            /* name of memory.current */
+  char *maxName;                /* name of memory.max */
+  char *stallName;              /* name of memory.pressure */
+} PressureStruct;
+
+
+size_t (PressureSize)(void)
+{
+  return sizeof(PressureStruct);
+}
+
+
+Bool (PressureCheck)(Pressure pressure)
+{
+  CHECKS(Pressure, pressure);
+  CHECKL(TESTT(Arena, pressure->arena));
+  CHECKL(pressure->names != NULL);
+  CHECKL(pressure->currentName == pressure->names);
+  CHECKL(pressure->currentName < pressure->maxName);
+  CHECKL(pressure->maxName < pressure->stallName);
+  CHECKL(pressure->stallName < pressure->names + pressure->namesSize);
+  return TRUE;
+}
+
+
+/* pressureName -- build the name of a file in the directory */
+
+static void pressureName(char *name, const char *path, Size length,
+                         const char *leaf)
+{
+  (void)mps_lib_memcpy(name, path, length);
+  (void)mps_lib_memcpy(name + length, leaf, StringLength(leaf) + 1);
+}
+
+
+/* pressureReadFile -- read the start of a file into a buffer
+ *
+ * The contents are NUL-terminated.  Returns FALSE if the file can't
+ * be read.
+ */
+
+static Bool pressureReadFile(char *buf, size_t size, const char *name)
+{
+  int fd;
+  ssize_t n;
+
+  AVER(size > 0);
+
+  fd = open(name, O_RDONLY);
+  if (fd == -1)
+    return FALSE;
+  n = read(fd, buf, size - 1);
+  (void)close(fd);
+  if (n < 0)
+    return FALSE;
+  buf[n] = '\0';
+  return TRUE;
+}
+
+
+/* pressureParseSize -- parse a decimal size
+ *
+ * Returns FALSE if the string doesn't start with a digit.  Sizes too
+ * large to represent are taken to be SizeMAX.
+ */
+
+static Bool pressureParseSize(Size *sizeReturn, const char *s)
+{
+  Size size = 0;
+
+  if (*s < '0' || *s > '9')
+    return FALSE;
+  for (; *s >= '0' && *s <= '9'; ++s) {
+    Size digit = (Size)(*s - '0');
+    if (size > (SizeMAX - digit) / 10) {
+      size = SizeMAX;
+      break;
+    }
+    size = size * 10 + digit;
+  }
+  *sizeReturn = size;
+  return TRUE;
+}
+
+
+/* pressureParseStall -- parse the "some avg10" figure, see .psi */
+
+static Bool pressureParseStall(double *stallReturn, const char *s)
+{
+  static const char key[] = "some avg10=";
+  double stall = 0.0, scale = 1.0;
+  size_t i;
+
+  for (i = 0; i < sizeof key - 1; ++i)
+    if (s[i] != key[i])
+      return FALSE;
+  s += i;
+  if (*s < '0' || *s > '9')
+    return FALSE;
+  for (; *s >= '0' && *s <= '9'; ++s)
+    stall = stall * 10.0 + (*s - '0');
+  if (*s == '.')
+    for (++s; *s >= '0' && *s <= '9'; ++s) {
+      scale /= 10.0;
+      stall += (*s - '0') * scale;
+    }
+  *stallReturn = stall;
+  return TRUE;
+}
+
+
+Res (PressureRead)(PressureReadingStruct *readingReturn, Pressure pressure)
+{
+  char buf[pressureBUFFER_SIZE];
+  Bool found = FALSE;
+
+  AVER(readingReturn != NULL);
+  AVERT(Pressure, pressure);
+
+  readingReturn->current = 0;
+  readingReturn->max = 0;
+  readingReturn->stall = 0.0;
+
+  if (pressureReadFile(buf, sizeof buf, pressure->currentName)
+      && pressureParseSize(&readingReturn->current, buf))
+    found = TRUE;
+  /* memory.max contains "max" if there is no limit. */
+  if (pressureReadFile(buf, sizeof buf, pressure->maxName)
+      && pressureParseSize(&readingReturn->max, buf))
+    found = TRUE;
+  if (pressureReadFile(buf, sizeof buf, pressure->stallName)
+      && pressureParseStall(&readingReturn->stall, buf))
+    found = TRUE;
+
+  return found ? ResOK : ResIO;
+}
+
+
+Res (PressureInit)(Pressure pressure, Arena arena, const char *path)
+{
+  PressureReadingStruct reading;
+  Size length, nameSize;
+  char *names;
+  void *p;
+  Res res;
+
+  AVER(pressure != NULL);
+  AVER(TESTT(Arena, arena));
+  AVER(path != NULL);
+
+  length = StringLength(path);
+  nameSize = length + sizeof pressureLONGEST;
+  res = ControlAlloc(&p, arena, 3 * nameSize);
+  if (res != ResOK)
+    return res;
+  names = p;
+  pressureName(names, path, length, "/memory.current");
+  pressureName(names + nameSize, path, length, "/memory.max");
+  pressureName(names + 2 * nameSize, path, length, pressureLONGEST);
+
+  pressure->arena = arena;
+  pressure->names = names;
+  pressure->namesSize = 3 * nameSize;
+  pressure->currentName = names;
+  pressure->maxName = names + nameSize;
+  pressure->stallName = names + 2 * nameSize;
+  pressure->sig = PressureSig;
+  AVERT(Pressure, pressure);
+
+  /* Fail now if the directory can't be read, rather than silently
+     monitoring nothing. */
+  res = PressureRead(&reading, pressure);
+  if (res != ResOK) {
+    PressureFinish(pressure);
+    return res;
+  }
+
+  return ResOK;
+}
+
+
+void (PressureFinish)(Pressure pressure)
+{
+  AVERT(Pressure, pressure);
+  pressure->sig = SigInvalid;
+  ControlFree(pressure->arena, pressure->names, pressure->namesSize);
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -61,7 +61,7 @@ void ProtSync(Arena arena)
       do {
         if (SegPM(seg) != AccessSetEMPTY) { /* <design/protan/#fun.sync.seg> */
           ShieldEnter(arena);
-          TraceSegAccess(arena, seg, SegPM(seg));
+          TraceSegAccess(arena, seg, NULL, SegPM(seg));
           ShieldLeave(arena);
           synced = FALSE;
         }
@@ -373,6 +373,7 @@ static void *go(void *p, size_t s)
   mps_ap_destroy(ap);
   mps_pool_destroy(pool);
   mps_pool_destroy(mpool);
+  list = NULL;
   mps_chain_destroy(chain);
   mps_fmt_destroy(format);
   mps_arena_release(arena);
@@ -522,17 +523,60 @@ static void copy(mps_addr_t object, mps_addr_t to)
 }
 
 
-int main(int argc, char *argv[])
+/* test -- sort in an arena distinguishing the given number of zones
+ *
+ * Each test sorts the same list, so that with more than MPS_WORD_WIDTH
+ * zones the fine zone test in TraceFix, and the placement of segments
+ * in fine zones, are checked on the same work as the plain zone test.
+ * See <design/arena/#zone.fine>.
+ */
+
+static void test(rnd_state_t state, size_t zones)
 {
   void *r;
 
-  testlib_init(argc, argv);
-
-  die(mps_arena_create(&arena, mps_arena_class_vm(), testArenaSIZE),
-      "mps_arena_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONES, zones);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "mps_arena_create");
+  } MPS_ARGS_END(args);
 
+  rnd_state_set(state);
   mps_tramp(&r, &go, NULL, 0);
   mps_arena_destroy(arena);
+}
+
+
+/* test_zones_param -- check that bad numbers of zones are rejected */
+
+static void test_zones_param(size_t zones)
+{
+  mps_res_t res;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONES, zones);
+    res = mps_arena_create_k(&arena, mps_arena_class_vm(), args);
+  } MPS_ARGS_END(args);
+  cdie(res == MPS_RES_PARAM, "arena_create(zones)");
+}
+
+
+int main(int argc, char *argv[])
+{
+  size_t zones = sizeof(mps_word_t) * CHAR_BIT;
+  rnd_state_t state;
+
+  testlib_init(argc, argv);
+  state = rnd_state();
+
+  test(state, zones);
+  test(state, zones * 4);
+  test(state, zones * zones);
+  test_zones_param(zones / 2);
+  test_zones_param(zones * 3);
+  test_zones_param(zones * zones * 2);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
@@ -33,20 +33,23 @@ Bool RankSetCheck(RankSet rankSet)
 }
 
 
-/* ZoneSetOfRange -- calculate the zone set of a range of addresses */
+/* zoneSetOfRange -- calculate the zone set of a range of addresses
+ *
+ * The zones are the stripes of size 2^shift, so this serves for both
+ * the zone set and the fine zone set of the range.
+ */
 
-ZoneSet ZoneSetOfRange(Arena arena, Addr base, Addr limit)
+static ZoneSet zoneSetOfRange(Shift shift, Addr base, Addr limit)
 {
   Word zbase, zlimit;
 
-  AVERT(Arena, arena);
   AVER(limit > base);
 
   /* The base and limit zones of the range are calculated.  The limit */
   /* zone is the zone after the last zone of the range, not the zone of */
   /* the limit address. */
-  zbase = (Word)base >> arena->zoneShift;
-  zlimit = (((Word)limit-1) >> arena->zoneShift) + 1;
+  zbase = (Word)base >> shift;
+  zlimit = (((Word)limit-1) >> shift) + 1;
 
 
   /* If the range is large enough to span all zones, its zone set is */
@@ -66,6 +69,124 @@ ZoneSet ZoneSetOfRange(Arena arena, Addr base, Addr limit)
 }
 
 
+/* ZoneSetOfRange -- calculate the zone set of a range of addresses */
+
+ZoneSet ZoneSetOfRange(Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  return zoneSetOfRange(arena->zoneShift, base, limit);
+}
+
+
+/* FineZoneSetOfRange -- calculate the fine zone set of a range
+ *
+ * See <design/arena/#zone.fine>.
+ */
+
+ZoneSet FineZoneSetOfRange(Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  return zoneSetOfRange(arena->fineZoneShift, base, limit);
+}
+
+
+/* ZoneSizeAdd, ZoneSizeSub -- account for a range of addresses by zone
+ *
+ * zoneSize is an array of MPS_WORD_WIDTH sizes, one for each zone.
+ * Add the size of the part of the range [base, limit) in each zone to
+ * that zone's size (or subtract it).  Return the set of zones whose
+ * size was zero (or has become zero).  See
+ * <design/arena/#zone.recycle>.  FineZoneSizeAdd and FineZoneSizeSub
+ * do the same for fine zones.  See <design/arena/#zone.fine.locus>.
+ */
+
+static ZoneSet zoneSizeUpdate(ZoneSet changed, Size *zoneSize, Index zone,
+                              Size size, Bool add)
+{
+  if (add) {
+    if (zoneSize[zone] == 0)
+      changed = BS_ADD(ZoneSet, changed, zone);
+    zoneSize[zone] += size;
+  } else {
+    AVER(zoneSize[zone] >= size);
+    zoneSize[zone] -= size;
+    if (zoneSize[zone] == 0)
+      changed = BS_ADD(ZoneSet, changed, zone);
+  }
+  return changed;
+}
+
+#define zoneOfStripe(stripe) ((Index)((stripe) & (MPS_WORD_WIDTH - 1)))
+
+static ZoneSet zoneSizeAccount(Size *zoneSize, Shift shift,
+                               Addr base, Addr limit, Bool add)
+{
+  ZoneSet changed = ZoneSetEMPTY;
+  Word stripe, lastStripe, fullStripes, cycles;
+  Size stripeSize;
+  Index i;
+
+  AVER(zoneSize != NULL);
+  AVER(shift < MPS_WORD_WIDTH);
+  AVER(base < limit);
+  AVERT(Bool, add);
+
+  stripeSize = (Size)1 << shift;
+  stripe = (Word)base >> shift;
+  lastStripe = ((Word)limit - 1) >> shift;
+  if (stripe == lastStripe)
+    return zoneSizeUpdate(changed, zoneSize, zoneOfStripe(stripe),
+                          AddrOffset(base, limit), add);
+
+  /* The partial stripes at each end of the range. */
+  changed = zoneSizeUpdate(changed, zoneSize, zoneOfStripe(stripe),
+                           AddrOffset(base, (Addr)((stripe + 1) << shift)),
+                           add);
+  changed = zoneSizeUpdate(changed, zoneSize, zoneOfStripe(lastStripe),
+                           AddrOffset((Addr)(lastStripe << shift), limit),
+                           add);
+
+  /* The whole stripes in between: each complete cycle of
+     MPS_WORD_WIDTH stripes adds the same amount to every zone, so
+     this takes at most one cycle however large the range. */
+  fullStripes = lastStripe - stripe - 1;
+  cycles = fullStripes / MPS_WORD_WIDTH;
+  if (cycles > 0)
+    for (i = 0; i < MPS_WORD_WIDTH; ++i)
+      changed = zoneSizeUpdate(changed, zoneSize, i,
+                               (Size)cycles * stripeSize, add);
+  for (i = 0; i < fullStripes % MPS_WORD_WIDTH; ++i)
+    changed = zoneSizeUpdate(changed, zoneSize, zoneOfStripe(stripe + 1 + i),
+                             stripeSize, add);
+
+  return changed;
+}
+
+ZoneSet ZoneSizeAdd(Size *zoneSize, Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  return zoneSizeAccount(zoneSize, arena->zoneShift, base, limit, TRUE);
+}
+
+ZoneSet ZoneSizeSub(Size *zoneSize, Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  return zoneSizeAccount(zoneSize, arena->zoneShift, base, limit, FALSE);
+}
+
+ZoneSet FineZoneSizeAdd(Size *zoneSize, Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  return zoneSizeAccount(zoneSize, arena->fineZoneShift, base, limit, TRUE);
+}
+
+ZoneSet FineZoneSizeSub(Size *zoneSize, Arena arena, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  return zoneSizeAccount(zoneSize, arena->fineZoneShift, base, limit, FALSE);
+}
+
+
 /* ZoneSetOfSeg -- calculate the zone set of segment addresses
  *
  * .rsor.def: The zone set of a segment is the union of the zones the
@@ -81,16 +202,58 @@ ZoneSet ZoneSetOfSeg(Arena arena, Seg seg)
 }
 
 
+/* ZoneSetOfNode -- calculate the zone set of a NUMA node
+ *
+ * .node.zones: The arena deals the zones out to its NUMA nodes in
+ * turn, so zone z belongs to node z % nodes, and the memory in each
+ * stripe is bound to the node of its zone.  See <design/arena/#numa>.
+ */
+
+ZoneSet ZoneSetOfNode(Arena arena, Index node)
+{
+  ZoneSet zones = ZoneSetEMPTY;
+  Index zone;
+
+  AVERT(Arena, arena);
+  AVER(node < arena->nodes);
+
+  for (zone = node; zone < MPS_WORD_WIDTH; zone += arena->nodes)
+    zones = BS_ADD(ZoneSet, zones, zone);
+  return zones;
+}
+
+
 /* RangeInZoneSetFirst -- find an area of address space within a zone set
  *
  * Given a range of addresses, find the first sub-range of at least size that
  * is also within a zone set.  i.e. ZoneSetOfRange is a subset of the zone set.
+ * Unless fineZoneSet is ZoneSetUNIV, the sub-range must also be within
+ * it, i.e. FineZoneSetOfRange is a subset of fineZoneSet, and the search
+ * goes a fine stripe at a time.  See <design/arena/#zone.fine.locus>.
  * Returns FALSE if no range satisfying the conditions could be found.
  */
 
-static Addr nextStripe(Addr base, Addr limit, Arena arena)
+/* rangeStripeSize -- size of the stripes to search by */
+
+static Size rangeStripeSize(Arena arena, ZoneSet fineZoneSet)
+{
+  if (fineZoneSet == ZoneSetUNIV)
+    return ArenaStripeSize(arena);
+  AVER(((Size)1 << arena->fineZoneShift) >= ArenaGrainSize(arena));
+  return (Size)1 << arena->fineZoneShift;
+}
+
+/* rangeInZones -- is an address in a zone set and a fine zone set? */
+
+#define rangeInZones(arena, zoneSet, fineZoneSet, addr) \
+  (ZoneSetHasAddr(arena, zoneSet, addr) \
+   && ZoneSetIsMember(fineZoneSet, \
+                      (Word)(addr) >> (arena)->fineZoneShift \
+                      & (MPS_WORD_WIDTH - 1)))
+
+static Addr nextStripe(Addr base, Addr limit, Size stripeSize)
 {
-  Addr next = AddrAlignUp(AddrAdd(base, 1), ArenaStripeSize(arena));
+  Addr next = AddrAlignUp(AddrAdd(base, 1), stripeSize);
   AVER(next > base || next == (Addr)0);
   if (next >= limit || next < base)
     next = limit;
@@ -99,9 +262,10 @@ static Addr nextStripe(Addr base, Addr limit, Arena arena)
 
 Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
                          Addr base, Addr limit,
-                         Arena arena, ZoneSet zoneSet, Size size)
+                         Arena arena, ZoneSet zoneSet,
+                         ZoneSet fineZoneSet, Size size)
 {
-  Size zebra;
+  Size zebra, stripeSize;
   Addr searchLimit;
 
   AVER(baseReturn != NULL);
@@ -110,6 +274,7 @@ Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
   AVERT(Arena, arena);
   AVER(size > 0);
   AVER(zoneSet != ZoneSetEMPTY);
+  AVER(fineZoneSet != ZoneSetEMPTY);
   
   /* TODO: Consider whether this search is better done by bit twiddling
      zone sets, e.g. by constructing a mask of zone bits as wide as the
@@ -118,7 +283,7 @@ Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
   if (AddrOffset(base, limit) < size)
     return FALSE;
   
-  if (zoneSet == ZoneSetUNIV) {
+  if (zoneSet == ZoneSetUNIV && fineZoneSet == ZoneSetUNIV) {
     *baseReturn = base;
     *limitReturn = limit;
     return TRUE;
@@ -126,10 +291,9 @@ Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
 
   /* A "zebra" is the size of a complete set of stripes. */
   zebra = (sizeof(ZoneSet) * CHAR_BIT) << ArenaZoneShift(arena);
-  if (size >= zebra) {
-    AVER(zoneSet != ZoneSetUNIV);
+  if (size >= zebra)
     return FALSE;
-  }
+  stripeSize = rangeStripeSize(arena, fineZoneSet);
   
   /* There's no point searching through the zoneSet more than once. */
   searchLimit = AddrAdd(AddrAlignUp(base, ArenaStripeSize(arena)), zebra);
@@ -141,8 +305,8 @@ Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
 
     /* Search for a stripe in the zoneSet and within the block. */
     /* (Find the first set bit in the zoneSet not below the base zone.) */
-    while (!ZoneSetHasAddr(arena, zoneSet, base)) {
-      base = nextStripe(base, limit, arena);
+    while (!rangeInZones(arena, zoneSet, fineZoneSet, base)) {
+      base = nextStripe(base, limit, stripeSize);
       if (base >= limit)
         return FALSE;
     }
@@ -151,8 +315,8 @@ Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
     /* (Find a run of set bits in the zoneSet.) */
     next = base;
     do
-      next = nextStripe(next, limit, arena);
-    while (next < limit && ZoneSetHasAddr(arena, zoneSet, next));
+      next = nextStripe(next, limit, stripeSize);
+    while (next < limit && rangeInZones(arena, zoneSet, fineZoneSet, next));
     
     /* Is the run big enough to satisfy the size? */
     if (AddrOffset(base, next) >= size) {
@@ -172,14 +336,15 @@ Bool RangeInZoneSetFirst(Addr *baseReturn, Addr *limitReturn,
  *
  * Given a range of addresses, find the last sub-range of at least size that
  * is also within a zone set.  i.e. ZoneSetOfRange is a subset of the zone set.
+ * The fine zone set is as for RangeInZoneSetFirst.
  * Returns FALSE if no range satisfying the conditions could be found.
  */
 
-static Addr prevStripe(Addr base, Addr limit, Arena arena)
+static Addr prevStripe(Addr base, Addr limit, Size stripeSize)
 {
   Addr prev;
   AVER(limit != (Addr)0);
-  prev = AddrAlignDown(AddrSub(limit, 1), ArenaStripeSize(arena));
+  prev = AddrAlignDown(AddrSub(limit, 1), stripeSize);
   AVER(prev < limit);
   if (prev < base)
     prev = base;
@@ -188,9 +353,10 @@ static Addr prevStripe(Addr base, Addr limit, Arena arena)
 
 Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
                         Addr base, Addr limit,
-                        Arena arena, ZoneSet zoneSet, Size size)
+                        Arena arena, ZoneSet zoneSet,
+                        ZoneSet fineZoneSet, Size size)
 {
-  Size zebra;
+  Size zebra, stripeSize;
   Addr searchBase;
 
   AVER(baseReturn != NULL);
@@ -199,6 +365,7 @@ Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
   AVERT(Arena, arena);
   AVER(size > 0);
   AVER(zoneSet != ZoneSetEMPTY);
+  AVER(fineZoneSet != ZoneSetEMPTY);
   
   /* TODO: Consider whether this search is better done by bit twiddling
      zone sets, e.g. by constructing a mask of zone bits as wide as the
@@ -207,7 +374,7 @@ Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
   if (AddrOffset(base, limit) < size)
     return FALSE;
   
-  if (zoneSet == ZoneSetUNIV) {
+  if (zoneSet == ZoneSetUNIV && fineZoneSet == ZoneSetUNIV) {
     *baseReturn = base;
     *limitReturn = limit;
     return TRUE;
@@ -215,10 +382,9 @@ Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
 
   /* A "zebra" is the size of a complete set of stripes. */
   zebra = (sizeof(ZoneSet) * CHAR_BIT) << ArenaZoneShift(arena);
-  if (size >= zebra) {
-    AVER(zoneSet != ZoneSetUNIV);
+  if (size >= zebra)
     return FALSE;
-  }
+  stripeSize = rangeStripeSize(arena, fineZoneSet);
   
   /* There's no point searching through the zoneSet more than once. */
   searchBase = AddrSub(AddrAlignDown(limit, ArenaStripeSize(arena)), zebra);
@@ -230,8 +396,8 @@ Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
 
     /* Search for a stripe in the zoneSet and within the block. */
     /* (Find the last set bit in the zoneSet below the limit zone.) */
-    while (!ZoneSetHasAddr(arena, zoneSet, AddrSub(limit, 1))) {
-      limit = prevStripe(base, limit, arena);
+    while (!rangeInZones(arena, zoneSet, fineZoneSet, AddrSub(limit, 1))) {
+      limit = prevStripe(base, limit, stripeSize);
       if (base >= limit)
         return FALSE;
     }
@@ -240,8 +406,9 @@ Bool RangeInZoneSetLast(Addr *baseReturn, Addr *limitReturn,
     /* (Find a run of set bits in the zoneSet.) */
     prev = limit;
     do
-      prev = prevStripe(base, prev, arena);
-    while (prev > base && ZoneSetHasAddr(arena, zoneSet, AddrSub(prev, 1)));
+      prev = prevStripe(base, prev, stripeSize);
+    while (prev > base
+           && rangeInZones(arena, zoneSet, fineZoneSet, AddrSub(prev, 1)));
     
     /* Is the run big enough to satisfy the size? */
     if (AddrOffset(prev, limit) >= size) {
@@ -8,6 +8,7 @@
  * .design: For design, see <design/root/> and
  * design.mps.root-interface. */
 
+#include "bt.h"
 #include "mpm.h"
 
 SRCID(root, "$Id$");
@@ -47,6 +48,10 @@ typedef struct RootStruct {
       Word *limit;              /* limit of area to be scanned */
       mps_area_scan_t scan_area;/* area scanning function */
       AreaScanUnion the;
+      Count pages;              /* number of pages, or 0 if none */
+      Shift pageShift;          /* log2 of the page size */
+      RefSet *pageSummary;      /* summary of references in each page */
+      BT pageDirty;             /* pages written by the mutator */
     } area;
     struct {
       Thread thread;            /* passed to scan */
@@ -82,17 +87,48 @@ Bool RootVarCheck(RootVar rootVar)
 Bool RootModeCheck(RootMode mode)
 {
   CHECKL((mode & (RootModeCONSTANT | RootModePROTECTABLE
-                  | RootModePROTECTABLE_INNER))
+                  | RootModePROTECTABLE_INNER | RootModePROTECTABLE_PAGES))
          == mode);
   /* RootModePROTECTABLE_INNER implies RootModePROTECTABLE */
   CHECKL((mode & RootModePROTECTABLE_INNER) == 0
          || (mode & RootModePROTECTABLE));
+  /* RootModePROTECTABLE_PAGES implies RootModePROTECTABLE, and the
+     pages must cover the whole root: see <design/root/#pages>. */
+  CHECKL((mode & RootModePROTECTABLE_PAGES) == 0
+         || ((mode & RootModePROTECTABLE)
+             && (mode & RootModePROTECTABLE_INNER) == 0));
   UNUSED(mode);
 
   return TRUE;
 }
 
 
+/* rootHasPages -- does a root keep a summary for each page? */
+
+static Bool rootHasPages(Root root)
+{
+  return (root->var == RootAREA || root->var == RootAREA_TAGGED)
+    && root->the.area.pages > 0;
+}
+
+
+/* rootPagesCheck -- check the page table of an area root */
+
+static Bool rootPagesCheck(Root root)
+{
+  if (root->the.area.pages > 0) {
+    CHECKL(root->mode & RootModePROTECTABLE_PAGES);
+    CHECKL(root->protectable);
+    CHECKL(root->the.area.pageSummary != NULL);
+    CHECKL(root->the.area.pageDirty != NULL);
+    CHECKL(ShiftCheck(root->the.area.pageShift));
+    CHECKL((root->the.area.pages << root->the.area.pageShift)
+           == AddrOffset(root->protBase, root->protLimit));
+  }
+  return TRUE;
+}
+
+
 /* RootCheck -- check the consistency of a root structure
  *
  * .rootcheck: Keep synchonized with <code/mpmst.h#root>. */
@@ -113,6 +149,7 @@ Bool RootCheck(Root root)
     CHECKL(root->the.area.base < root->the.area.limit);
     CHECKL(FUNCHECK(root->the.area.scan_area));
     /* Can't check anything about closure */
+    CHECKL(rootPagesCheck(root));
     break;
 
   case RootAREA_TAGGED:
@@ -121,6 +158,7 @@ Bool RootCheck(Root root)
     CHECKL(FUNCHECK(root->the.area.scan_area));
     /* Can't check anything about tag as it could mean anything to
        scan_area. */
+    CHECKL(rootPagesCheck(root));
     break;
 
   case RootFUN:
@@ -225,6 +263,42 @@ static Res rootCreate(Root *rootReturn, Arena arena,
   return ResOK;
 }
 
+/* rootPagesInit -- give an area root a summary for each page
+ *
+ * The pages are arena grains, so that they can be protected
+ * separately.  See <design/root/#pages>.
+ */
+
+static Res rootPagesInit(Root root)
+{
+  Arena arena = root->arena;
+  Shift pageShift = SizeLog2(ArenaGrainSize(arena));
+  Count pages = AddrOffset(root->protBase, root->protLimit) >> pageShift;
+  Index i;
+  void *p;
+  Res res;
+
+  AVER(root->var == RootAREA || root->var == RootAREA_TAGGED);
+  AVER(root->protectable);
+  AVER(ArenaGrainSize(arena) % ProtGranularity() == 0);
+
+  res = ControlAlloc(&p, arena, pages * sizeof(RefSet));
+  if (res != ResOK)
+    return res;
+  res = BTCreate(&root->the.area.pageDirty, arena, pages);
+  if (res != ResOK) {
+    ControlFree(arena, p, pages * sizeof(RefSet));
+    return res;
+  }
+  BTResRange(root->the.area.pageDirty, 0, pages);
+  root->the.area.pageSummary = p;
+  for (i = 0; i < pages; ++i)
+    root->the.area.pageSummary[i] = root->summary;
+  root->the.area.pageShift = pageShift;
+  root->the.area.pages = pages;
+  return ResOK;
+}
+
 static Res rootCreateProtectable(Root *rootReturn, Arena arena,
                                  Rank rank, RootMode mode, RootVar var,
                                  Addr base, Addr limit,
@@ -269,6 +343,14 @@ static Res rootCreateProtectable(Root *rootReturn, Arena arena,
     }
   }
 
+  if (mode & RootModePROTECTABLE_PAGES) {
+    res = rootPagesInit(root);
+    if (res != ResOK) {
+      RootDestroy(root);
+      return res;
+    }
+  }
+
   AVERT(Root, root);
 
   *rootReturn = root;
@@ -299,6 +381,10 @@ Res RootCreateArea(Root *rootReturn, Arena arena,
   theUnion.area.limit = limit;
   theUnion.area.scan_area = scan_area;
   theUnion.area.the.closure = closure;
+  theUnion.area.pages = 0;
+  theUnion.area.pageShift = 0;
+  theUnion.area.pageSummary = NULL;
+  theUnion.area.pageDirty = NULL;
 
   res = rootCreateProtectable(rootReturn, arena, rank, mode,
                               RootAREA, (Addr)base, (Addr)limit, &theUnion);
@@ -325,6 +411,10 @@ Res RootCreateAreaTagged(Root *rootReturn, Arena arena,
   theUnion.area.scan_area = scan_area;
   theUnion.area.the.tag.mask = mask;
   theUnion.area.the.tag.pattern = pattern;
+  theUnion.area.pages = 0;
+  theUnion.area.pageShift = 0;
+  theUnion.area.pageSummary = NULL;
+  theUnion.area.pageDirty = NULL;
 
   return rootCreateProtectable(rootReturn, arena, rank, mode, RootAREA_TAGGED,
                                (Addr)base, (Addr)limit, &theUnion);
@@ -399,6 +489,7 @@ Res RootCreateFmt(Root *rootReturn, Arena arena,
   AVERT(Arena, arena);
   AVERT(Rank, rank);
   AVERT(RootMode, mode);
+  AVER((mode & RootModePROTECTABLE_PAGES) == 0); /* area roots only */
   AVER(FUNCHECK(scan));
   AVER(base != 0);
   AVER(base < limit);
@@ -444,6 +535,15 @@ void RootDestroy(Root root)
   RingRemove(&root->arenaRing);
   RingFinish(&root->arenaRing);
 
+  if (root->pm != AccessSetEMPTY)
+    ProtSet(root->protBase, root->protLimit, AccessSetEMPTY);
+
+  if (rootHasPages(root)) {
+    BTDestroy(root->the.area.pageDirty, arena, root->the.area.pages);
+    ControlFree(arena, root->the.area.pageSummary,
+                root->the.area.pages * sizeof(RefSet));
+  }
+
   root->sig = SigInvalid;
 
   ControlFree(arena, root, sizeof(RootStruct));
@@ -504,7 +604,9 @@ static void rootSetSummary(Root root, RefSet summary)
   AVERT(Root, root);
   /* Can't check summary */
   if (root->protectable) {
-    if (summary == RefSetUNIV) {
+    /* A root with pages keeps its write barrier, since a write only
+       exposes one page: see <design/root/#pages.write>. */
+    if (summary == RefSetUNIV && !rootHasPages(root)) {
       root->summary = summary;
       root->pm &= ~AccessWRITE;
     } else {
@@ -516,6 +618,58 @@ static void rootSetSummary(Root root, RefSet summary)
 }
 
 
+/* rootScanPages -- scan the pages of an area root that need it
+ *
+ * A page needs scanning if it is dirty or its summary meets the white
+ * set.  Each page is scanned separately so that it gets a summary of
+ * its own.  The summaries of the pages that weren't scanned are added
+ * to the scan state's summary, which is then the union of the page
+ * summaries.  See <design/root/#pages.scan>.
+ */
+
+static Res rootScanPages(ScanState ss, Root root, void *closure)
+{
+  ZoneSet white = ScanStateWhite(ss);
+  RefSet skipped = RefSetEMPTY;
+  Size pageSize = (Size)1 << root->the.area.pageShift;
+  Index i;
+
+  for (i = 0; i < root->the.area.pages; ++i) {
+    RefSet *pageSummary = &root->the.area.pageSummary[i];
+    if (BTGet(root->the.area.pageDirty, i)
+        || ZoneSetInter(*pageSummary, white) != ZoneSetEMPTY) {
+      Addr base = AddrAdd(root->protBase, i * pageSize);
+      Addr limit = AddrAdd(base, pageSize);
+      RefSet unfixed = ScanStateUnfixedSummary(ss);
+      RefSet fixed = ss->fixedSummary;
+      Res res;
+
+      if (base < (Addr)root->the.area.base)
+        base = (Addr)root->the.area.base;
+      if (limit > (Addr)root->the.area.limit)
+        limit = (Addr)root->the.area.limit;
+      ScanStateSetSummary(ss, RefSetEMPTY);
+      res = TraceScanArea(ss, (Word *)base, (Word *)limit,
+                          root->the.area.scan_area, closure);
+      if (res == ResOK) {
+        *pageSummary = ScanStateSummary(ss);
+        BTRes(root->the.area.pageDirty, i);
+      }
+      ScanStateSetUnfixedSummary(ss, RefSetUnion(unfixed,
+                                                 ScanStateUnfixedSummary(ss)));
+      ss->fixedSummary = RefSetUnion(fixed, ss->fixedSummary);
+      if (res != ResOK)
+        return res;
+    } else {
+      skipped = RefSetUnion(skipped, *pageSummary);
+    }
+  }
+
+  ss->fixedSummary = RefSetUnion(ss->fixedSummary, skipped);
+  return ResOK;
+}
+
+
 /* RootScan -- scan root */
 
 Res RootScan(ScanState ss, Root root)
@@ -537,21 +691,27 @@ Res RootScan(ScanState ss, Root root)
 
   switch(root->var) {
   case RootAREA:
-    res = TraceScanArea(ss,
-                        root->the.area.base,
-                        root->the.area.limit,
-                        root->the.area.scan_area,
-                        root->the.area.the.closure);
+    if (rootHasPages(root))
+      res = rootScanPages(ss, root, root->the.area.the.closure);
+    else
+      res = TraceScanArea(ss,
+                          root->the.area.base,
+                          root->the.area.limit,
+                          root->the.area.scan_area,
+                          root->the.area.the.closure);
     if (res != ResOK)
       goto failScan;
     break;
 
   case RootAREA_TAGGED:
-    res = TraceScanArea(ss,
-                        root->the.area.base,
-                        root->the.area.limit,
-                        root->the.area.scan_area,
-                        &root->the.area.the.tag);
+    if (rootHasPages(root))
+      res = rootScanPages(ss, root, &root->the.area.the.tag);
+    else
+      res = TraceScanArea(ss,
+                          root->the.area.base,
+                          root->the.area.limit,
+                          root->the.area.scan_area,
+                          &root->the.area.the.tag);
     if (res != ResOK)
       goto failScan;
     break;
@@ -635,14 +795,32 @@ Bool RootOfAddr(Root *rootReturn, Arena arena, Addr addr)
 }
 
 
-/* RootAccess -- handle barrier hit on root */
+/* RootAccess -- handle barrier hit on root
+ *
+ * If the root has pages, only the page containing addr loses its
+ * protection: see <design/root/#pages.write>.
+ */
 
-void RootAccess(Root root, AccessSet mode)
+void RootAccess(Root root, Addr addr, AccessSet mode)
 {
   AVERT(Root, root);
   AVERT(AccessSet, mode);
   AVER((root->pm & mode) != AccessSetEMPTY);
   AVER(mode == AccessWRITE); /* only write protection supported */
+  AVER(root->protBase <= addr);
+  AVER(addr < root->protLimit);
+
+  if (rootHasPages(root)) {
+    Shift pageShift = root->the.area.pageShift;
+    Index i = AddrOffset(root->protBase, addr) >> pageShift;
+    Addr base = AddrAdd(root->protBase, i << pageShift);
+    root->the.area.pageSummary[i] = RefSetUNIV;
+    BTSet(root->the.area.pageDirty, i);
+    root->summary = RefSetUNIV;
+    ProtSet(base, AddrAdd(base, (Size)1 << pageShift),
+            BS_DIFF(root->pm, mode));
+    return;
+  }
 
   rootSetSummary(root, RefSetUNIV);
 
@@ -693,6 +871,7 @@ Res RootDescribe(Root root, mps_lib_FILE *stream, Count depth)
                root->mode & RootModeCONSTANT ? " CONSTANT" : "",
                root->mode & RootModePROTECTABLE ? " PROTECTABLE" : "",
                root->mode & RootModePROTECTABLE_INNER ? " INNER" : "",
+               root->mode & RootModePROTECTABLE_PAGES ? " PAGES" : "",
                "\n",
                "  protectable $S", WriteFYesNo(root->protectable),
                "  protBase $A", (WriteFA)root->protBase,
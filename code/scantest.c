@@ -0,0 +1,243 @@
+/* scantest.c: AREA SCANNER TEST
+ *
+ * $Id$
+ * Copyright (c) 2016 Ravenbrook Limited.  See end of file for license.
+ *
+ * .overview: This test case checks that the AVX2 area scanner gives
+ * the same results as the scalar area scanner, on random areas of
+ * ambiguous, masked, and tagged references.  See <code/scan.c#simd>.
+ *
+ * .copy: The test includes its own copy of the area scanners, renamed
+ * so as not to clash with those in the MPS, and with MPS_FIX2 replaced
+ * by fix2 below, so that it can choose between AVX2 and MPS_SCAN_AREA
+ * by setting scanAreaSIMD, and check each reference that reaches
+ * MPS_FIX2 without needing a trace.
+ */
+
+#include <stdio.h>              /* printf */
+#include <string.h>             /* memcpy */
+
+#include "mps.h"
+#include "testlib.h"
+
+static mps_res_t fix2(mps_ss_t ss, mps_addr_t *ref_io);
+
+#undef MPS_FIX2
+#define MPS_FIX2(ss, ref_io) fix2(ss, ref_io)
+
+#define mps_scan_area scantest_area
+#define mps_scan_area_masked scantest_area_masked
+#define mps_scan_area_tagged scantest_area_tagged
+#define mps_scan_area_tagged_or_zero scantest_area_tagged_or_zero
+
+extern mps_res_t scantest_area(mps_ss_t, void *, void *, void *);
+extern mps_res_t scantest_area_masked(mps_ss_t, void *, void *, void *);
+extern mps_res_t scantest_area_tagged(mps_ss_t, void *, void *, void *);
+extern mps_res_t scantest_area_tagged_or_zero(mps_ss_t, void *, void *,
+                                              void *);
+
+#include "scan.c"
+
+
+#define AREA_WORDS 100          /* Maximum words in an area */
+#define AREA_SLACK 4            /* Words for misaligning the area */
+#define TESTS 10000             /* Number of areas to scan */
+
+
+/* fix2 -- record the reference and change it
+ *
+ * The changed reference keeps its tag bits clear, as a fixed reference
+ * would.  After fixFail references, fail instead, to check that the
+ * scanners stop at the same reference.
+ */
+
+static mps_word_t fixLog[AREA_WORDS]; /* References that reached fix2 */
+static size_t fixCount;         /* Number of references in fixLog */
+static size_t fixFail;          /* Number of references before failure */
+static mps_word_t fixFlip;      /* Bits to flip in fixed references */
+
+static mps_res_t fix2(mps_ss_t ss, mps_addr_t *ref_io)
+{
+  (void)ss; /* unused */
+  if (fixCount == fixFail)
+    return MPS_RES_FAIL;
+  Insist(fixCount < NELEMS(fixLog));
+  fixLog[fixCount] = (mps_word_t)*ref_io;
+  ++fixCount;
+  *ref_io = (mps_addr_t)((mps_word_t)*ref_io ^ fixFlip);
+  return MPS_RES_OK;
+}
+
+
+#ifdef SCAN_AREA_AVX2
+
+/* rnd_word -- random word, with all bits random */
+
+static mps_word_t rnd_word(void)
+{
+  mps_word_t w = rnd();
+  w = (w << 31) ^ rnd();
+  w = (w << 31) ^ rnd();
+  return w;
+}
+
+
+/* Results of scanning an area with one scanner */
+
+typedef struct result_s {
+  mps_res_t res;
+  mps_word_t area[AREA_WORDS + AREA_SLACK];
+  mps_word_t ufs;
+  mps_word_t log[AREA_WORDS];
+  size_t count;
+} result_s;
+
+static void scan(result_s *result, scanAreaFunction simd,
+                 mps_area_scan_t scan_area, mps_ss_s *ss_s,
+                 const mps_word_t *area, size_t offset, size_t words,
+                 mps_scan_tag_s *tag)
+{
+  mps_word_t *base = result->area + offset;
+  memcpy(result->area, area, sizeof result->area);
+  scanAreaSIMD = simd;
+  fixCount = 0;
+  ss_s->_ufs = 0;
+  result->res = scan_area(ss_s, base, base + words, tag);
+  result->ufs = ss_s->_ufs;
+  memcpy(result->log, fixLog, sizeof result->log);
+  result->count = fixCount;
+}
+
+
+/* test -- scan a random area with each scanner and compare */
+
+static void test(mps_area_scan_t scan_area, const char *name)
+{
+  mps_word_t area[AREA_WORDS + AREA_SLACK];
+  mps_ss_s ss_s;
+  mps_scan_tag_s tag;
+  result_s scalar, simd;
+  size_t i, offset, words;
+
+  ss_s._zs = (mps_word_t)(3 + rnd() % (MPS_WORD_WIDTH - 8));
+  switch (rnd() % 4) {
+  case 0:  ss_s._w = 0; break;
+  case 1:  ss_s._w = ~(mps_word_t)0; break;
+  default: ss_s._w = rnd_word() & rnd_word(); break;
+  }
+  tag.mask = ((mps_word_t)1 << rnd() % 4) - 1;
+  tag.pattern = rnd_word() & tag.mask;
+  fixFlip = rnd_word() & ~(mps_word_t)7;
+  fixFail = rnd() % 4 == 0 ? rnd() % AREA_WORDS : AREA_WORDS;
+
+  for (i = 0; i < NELEMS(area); ++i) {
+    switch (rnd() % 4) {
+    case 0:  area[i] = 0; break;
+    case 1:  area[i] = rnd() % 64; break;
+    default: area[i] = rnd_word(); break;
+    }
+  }
+  offset = rnd() % AREA_SLACK;
+  words = rnd() % (AREA_WORDS + 1);
+
+  scan(&scalar, NULL, scan_area, &ss_s, area, offset, words,
+       &tag);
+  scan(&simd, scanAreaAVX2, scan_area, &ss_s, area, offset, words,
+       &tag);
+
+  if (simd.res != scalar.res)
+    error("%s: result %d, expected %d", name, simd.res, scalar.res);
+  if (simd.count != scalar.count)
+    error("%s: %lu references fixed, expected %lu", name,
+          (unsigned long)simd.count, (unsigned long)scalar.count);
+  for (i = 0; i < scalar.count; ++i)
+    if (simd.log[i] != scalar.log[i])
+      error("%s: reference %lu fixed was %p, expected %p", name,
+            (unsigned long)i, (void *)simd.log[i], (void *)scalar.log[i]);
+  for (i = 0; i < NELEMS(area); ++i)
+    if (simd.area[i] != scalar.area[i])
+      error("%s: word %lu scanned to %p, expected %p", name,
+            (unsigned long)i, (void *)simd.area[i],
+            (void *)scalar.area[i]);
+  if (simd.ufs != scalar.ufs)
+    error("%s: unfixed summary %p, expected %p", name,
+          (void *)simd.ufs, (void *)scalar.ufs);
+}
+
+
+int main(int argc, char *argv[])
+{
+  size_t i;
+
+  testlib_init(argc, argv);
+
+  if (!__builtin_cpu_supports("avx2")) {
+    printf("%s: processor does not support AVX2: nothing to test.\n",
+           argv[0]);
+    return 0;
+  }
+
+  for (i = 0; i < TESTS; ++i) {
+    test(scantest_area, "mps_scan_area");
+    test(scantest_area_masked, "mps_scan_area_masked");
+    test(scantest_area_tagged, "mps_scan_area_tagged");
+    test(scantest_area_tagged_or_zero, "mps_scan_area_tagged_or_zero");
+  }
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+#else /* SCAN_AREA_AVX2 not defined */
+
+int main(int argc, char *argv[])
+{
+  testlib_init(argc, argv);
+  printf("%s: no AVX2 area scanner on this platform: nothing to test.\n",
+         argv[0]);
+  return 0;
+}
+
+#endif /* SCAN_AREA_AVX2 */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (c) 2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -19,6 +19,7 @@
  */
 
 #include "tract.h"
+#include "bt.h"
 #include "mpm.h"
 
 SRCID(seg, "$Id$");
@@ -112,6 +113,26 @@ void SegFree(Seg seg)
 }
 
 
+/* segSetColour -- set the page colour of a range of a segment
+ *
+ * Segments lie within a single chunk.  See <code/tract.h#colour>.
+ */
+
+static void segSetColour(Arena arena, Addr base, Addr limit,
+                         PageColour colour)
+{
+  Chunk chunk = NULL; /* suppress "may be used uninitialized" */
+  Bool found;
+
+  found = ChunkOfAddr(&chunk, arena, base);
+  AVER(found);
+  UNUSED(found);
+  AVER(limit <= chunk->limit);
+  ChunkSetColourRange(chunk, INDEX_OF_ADDR(chunk, base),
+                      INDEX_OF_ADDR(chunk, limit), colour);
+}
+
+
 /* SegInit -- initialize a segment */
 
 static Res SegAbsInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
@@ -157,6 +178,7 @@ static Res SegAbsInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
     AVER(seg->firstTract != NULL);
   }
   AVER(addr == seg->limit);
+  segSetColour(arena, base, limit, PageColourALLOC | PageColourSEG);
 
   SetClassOfPoly(seg, CLASS(Seg));
   seg->sig = SegSig;
@@ -223,6 +245,7 @@ static void SegAbsFinish(Inst inst)
     TRACT_UNSET_SEG(tract);
   }
   AVER(addr == seg->limit);
+  segSetColour(arena, SegBase(seg), limit, PageColourALLOC);
 
   RingFinish(SegPoolRing(seg));
 
@@ -305,7 +328,9 @@ void SegSetSummary(Seg seg, RefSet summary)
   summary = RefSetUNIV;
 #endif
 
-  if (summary != SegSummary(seg))
+  /* Cards may need new summaries even if the segment doesn't: see
+     <design/seg/#card.summary>. */
+  if (summary != SegSummary(seg) || SegHasCards(seg))
     Method(Seg, seg, setSummary)(seg, summary);
 }
 
@@ -1038,6 +1063,7 @@ static Res segTrivSplit(Seg seg, Seg segHi,
 Bool GCSegCheck(GCSeg gcseg)
 {
   Seg seg;
+  TraceId ti;
   CHECKS(GCSeg, gcseg);
   seg = &gcseg->segStruct;
   CHECKD(Seg, seg);
@@ -1049,10 +1075,13 @@ Bool GCSegCheck(GCSeg gcseg)
     CHECKL(BufferRankSet(gcseg->buffer) == SegRankSet(seg));
   }
 
-  /* The segment should be on a grey ring if and only if it is grey. */
-  CHECKD_NOSIG(Ring, &gcseg->greyRing);
-  CHECKL((seg->grey == TraceSetEMPTY) ==
-         RingIsSingle(&gcseg->greyRing));
+  /* The segment should be on the grey ring for a trace if and only if
+     it is grey for that trace. */
+  for (ti = 0; ti < TraceLIMIT; ++ti) {
+    CHECKD_NOSIG(Ring, &gcseg->greyRing[ti]);
+    CHECKL((Bool)BS_IS_MEMBER(seg->grey, ti) ==
+           !RingIsSingle(&gcseg->greyRing[ti]));
+  }
 
   if (seg->rankSet == RankSetEMPTY) {
     /* <design/seg/#field.rankSet.empty> */
@@ -1061,6 +1090,16 @@ Bool GCSegCheck(GCSeg gcseg)
 
   CHECKD_NOSIG(Ring, &gcseg->genRing);
 
+  if (gcseg->cards > 0) {
+    CHECKL(gcseg->cardSummary != NULL);
+    CHECKL(gcseg->cardDirty != NULL);
+    CHECKL(ShiftCheck(gcseg->cardShift));
+    CHECKL((gcseg->cards << gcseg->cardShift) == SegSize(seg));
+  }
+  CHECKL(gcseg->cardsDirty <= gcseg->cards);
+  CHECKL(BoolCheck(gcseg->cardsScanned));
+  CHECKL(gcseg->cards > 0 || !gcseg->cardsScanned);
+
   return TRUE;
 }
 
@@ -1070,6 +1109,7 @@ Bool GCSegCheck(GCSeg gcseg)
 static Res gcSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 {
   GCSeg gcseg;
+  TraceId ti;
   Res res;
 
   /* Initialize the superclass fields first via next-method call */
@@ -1080,8 +1120,15 @@ static Res gcSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   gcseg->summary = RefSetEMPTY;
   gcseg->buffer = NULL;
-  RingInit(&gcseg->greyRing);
+  for (ti = 0; ti < TraceLIMIT; ++ti)
+    RingInit(&gcseg->greyRing[ti]);
   RingInit(&gcseg->genRing);
+  gcseg->cards = 0;
+  gcseg->cardShift = 0;
+  gcseg->cardSummary = NULL;
+  gcseg->cardDirty = NULL;
+  gcseg->cardsDirty = 0;
+  gcseg->cardsScanned = FALSE;
 
   SetClassOfPoly(seg, CLASS(GCSeg));
   gcseg->sig = GCSegSig;
@@ -1097,19 +1144,30 @@ static void gcSegFinish(Inst inst)
 {
   Seg seg = MustBeA(Seg, inst);
   GCSeg gcseg = MustBeA(GCSeg, seg);
+  TraceId ti;
 
-  if (SegGrey(seg) != TraceSetEMPTY) {
-    RingRemove(&gcseg->greyRing);
-    seg->grey = TraceSetEMPTY;
-  }
+  for (ti = 0; ti < TraceLIMIT; ++ti)
+    if (BS_IS_MEMBER(SegGrey(seg), ti))
+      RingRemove(&gcseg->greyRing[ti]);
+  seg->grey = TraceSetEMPTY;
   gcseg->summary = RefSetEMPTY;
 
+  if (gcseg->cards > 0) {
+    Arena arena = PoolArena(SegPool(seg));
+    BTDestroy(gcseg->cardDirty, arena, gcseg->cards);
+    ControlFree(arena, gcseg->cardSummary,
+                gcseg->cards * sizeof gcseg->cardSummary[0]);
+    gcseg->cards = 0;
+    gcseg->cardsDirty = 0;
+  }
+
   gcseg->sig = SigInvalid;
 
   /* Don't leave a dangling buffer allocating into hyperspace. */
   AVER(gcseg->buffer == NULL); /* <design/check/#.common> */
 
-  RingFinish(&gcseg->greyRing);
+  for (ti = 0; ti < TraceLIMIT; ++ti)
+    RingFinish(&gcseg->greyRing[ti]);
   RingFinish(&gcseg->genRing);
 
   /* finish the superclass fields last */
@@ -1130,18 +1188,22 @@ static void gcSegSetGreyInternal(Seg seg, TraceSet oldGrey, TraceSet grey)
   GCSeg gcseg;
   Arena arena;
   Rank rank;
+  TraceId ti;
  
   /* Internal method. Parameters are checked by caller */
   gcseg = SegGCSeg(seg);
   arena = PoolArena(SegPool(seg));
   seg->grey = BS_BITFIELD(Trace, grey);
 
-  /* If the segment is now grey and wasn't before, add it to the */
-  /* appropriate grey list so that TraceFindGrey can locate it */
-  /* quickly later.  If it is no longer grey and was before, */
-  /* remove it from the list. */
-  if (oldGrey == TraceSetEMPTY) {
-    if (grey != TraceSetEMPTY) {
+  /* For each trace for which the segment is now grey and wasn't */
+  /* before, add it to that trace's grey list for its rank so that */
+  /* traceFindGrey can locate it in constant time later.  For each */
+  /* trace for which it is no longer grey, remove it from the list. */
+  /* See <design/seg/#field.greyRing>. */
+  for (ti = 0; ti < TraceLIMIT; ++ti) {
+    Bool was = BS_IS_MEMBER(oldGrey, ti);
+    Bool is = BS_IS_MEMBER(grey, ti);
+    if (!was && is) {
       AVER(RankSetIsSingle(seg->rankSet));
       for(rank = RankMIN; rank < RankLIMIT; ++rank)
         if (RankSetIsMember(seg->rankSet, rank)) {
@@ -1149,18 +1211,17 @@ static void gcSegSetGreyInternal(Seg seg, TraceSet oldGrey, TraceSet grey)
              we preserve some locality of scanning, and so that we tend to
              forward objects that are closely linked to the same or nearby
              segments. */
-          RingInsert(ArenaGreyRing(arena, rank), &gcseg->greyRing);
+          RingInsert(ArenaGreyRing(arena, ti, rank), &gcseg->greyRing[ti]);
           break;
         }
       AVER(rank != RankLIMIT); /* there should've been a match */
+    } else if (was && !is) {
+      RingRemove(&gcseg->greyRing[ti]);
     }
-  } else {
-    if (grey == TraceSetEMPTY)
-      RingRemove(&gcseg->greyRing);
   }
 
   STATISTIC({
-    TraceId ti; Trace trace;
+    Trace trace;
     TraceSet diff;
 
     diff = TraceSetDiff(grey, oldGrey);
@@ -1249,6 +1310,8 @@ static void gcSegSetWhite(Seg seg, TraceSet white)
     TractSetWhite(tract, BS_BITFIELD(Trace, white));
   }
   AVER(addr == limit);
+  segSetColour(arena, SegBase(seg), limit,
+               PageColourALLOC | PageColourSEG | PageColourWHITE(white));
 
   seg->white = BS_BITFIELD(Trace, white);
 }
@@ -1299,13 +1362,64 @@ static void gcSegSetRankSet(Seg seg, RankSet rankSet)
 }
 
 
+/* gcSegCardsSetSummary -- bring the card summaries into line
+ *
+ * If the card summaries were set by the scan that computed the new
+ * summary of the segment, and that summary is their union, they are
+ * left alone.  Otherwise each card gets the new summary, since
+ * references may have been fixed without the cards being told.  See
+ * <design/seg/#card.summary>.
+ */
+
+static void gcSegCardsSetSummary(GCSeg gcseg, Arena arena, RefSet summary)
+{
+  Index i;
+
+  if (gcseg->cardsScanned) {
+    RefSet cardsSummary = RefSetEMPTY;
+    gcseg->cardsScanned = FALSE;
+    for (i = 0; i < gcseg->cards; ++i)
+      cardsSummary = RefSetUnion(cardsSummary, gcseg->cardSummary[i]);
+    if (cardsSummary == summary)
+      return;
+  }
+
+  for (i = 0; i < gcseg->cards; ++i) {
+    gcseg->cardSummary[i] = summary;
+    if (BTGet(gcseg->cardDirty, i)) {
+      Seg seg = &gcseg->segStruct;
+      Addr base = AddrAdd(SegBase(seg), (Size)i << gcseg->cardShift);
+      BTRes(gcseg->cardDirty, i);
+      AVER(gcseg->cardsDirty > 0);
+      --gcseg->cardsDirty;
+      ShieldSyncCards(arena, seg, base,
+                      AddrAdd(base, (Size)1 << gcseg->cardShift));
+    }
+  }
+}
+
+
+/* gcSegSyncWriteBarrier -- raise or lower the write barrier
+ *
+ * A segment with cards keeps its write barrier while any card has a
+ * summary smaller than the mutator's, even though the summary of the
+ * whole segment is RefSetUNIV.  See <design/seg/#card.prot>.
+ */
+
 static void gcSegSyncWriteBarrier(Seg seg, Arena arena)
 {
+  GCSeg gcseg = (GCSeg)seg;
+  Bool barrier = SegSummary(seg) != RefSetUNIV;
+  Index i;
+
   /* Can't check seg -- this function enforces invariants tested by SegCheck. */
-  if (SegSummary(seg) == RefSetUNIV)
-    ShieldLower(arena, seg, AccessWRITE);
-  else
+  for (i = 0; !barrier && i < gcseg->cards; ++i)
+    barrier = gcseg->cardSummary[i] != RefSetUNIV;
+
+  if (barrier)
     ShieldRaise(arena, seg, AccessWRITE);
+  else
+    ShieldLower(arena, seg, AccessWRITE);
 }
 
 
@@ -1329,6 +1443,7 @@ static void gcSegSetSummary(Seg seg, RefSet summary)
   AVER_CRITICAL(&gcseg->segStruct == seg);
 
   arena = PoolArena(SegPool(seg));
+  gcSegCardsSetSummary(gcseg, arena, summary);
   gcseg->summary = summary;
 
   AVER(seg->rankSet != RankSetEMPTY);
@@ -1358,6 +1473,7 @@ static void gcSegSetRankSummary(Seg seg, RankSet rankSet, RefSet summary)
   arena = PoolArena(SegPool(seg));
 
   seg->rankSet = BS_BITFIELD(Rank, rankSet);
+  gcSegCardsSetSummary(gcseg, arena, summary);
   gcseg->summary = summary;
 
   if (rankSet != RankSetEMPTY)
@@ -1365,6 +1481,202 @@ static void gcSegSetRankSummary(Seg seg, RankSet rankSet, RefSet summary)
 }
 
 
+/* SegCardsInit -- give a segment a card table
+ *
+ * Divides the segment into cards of one arena grain each, with a
+ * summary per card and a bit table of cards that the mutator has
+ * written, so that a write barrier hit only exposes one card.  Pool
+ * classes whose segments can't be split or merged may call this from
+ * their segment init method.  If it fails, the segment simply has no
+ * cards.  See <design/seg/#card>.
+ */
+
+Res SegCardsInit(Seg seg)
+{
+  GCSeg gcseg = MustBeA(GCSeg, seg);
+  Arena arena = PoolArena(SegPool(seg));
+  Shift cardShift = SizeLog2(ArenaGrainSize(arena));
+  Count cards = SegSize(seg) >> cardShift;
+  void *p;
+  Index i;
+  Res res;
+
+  AVER(gcseg->cards == 0);
+  AVER(ArenaGrainSize(arena) % ProtGranularity() == 0);
+
+#if defined(REMEMBERED_SET)
+  res = ControlAlloc(&p, arena, cards * sizeof gcseg->cardSummary[0]);
+  if (res != ResOK)
+    return res;
+  res = BTCreate(&gcseg->cardDirty, arena, cards);
+  if (res != ResOK) {
+    ControlFree(arena, p, cards * sizeof gcseg->cardSummary[0]);
+    return res;
+  }
+  BTResRange(gcseg->cardDirty, 0, cards);
+  gcseg->cardSummary = p;
+  for (i = 0; i < cards; ++i)
+    gcseg->cardSummary[i] = gcseg->summary;
+  gcseg->cardShift = cardShift;
+  gcseg->cards = cards;
+  seg->defer = 0; /* <design/seg/#card.defer> */
+  AVERT(GCSeg, gcseg);
+  return ResOK;
+#else
+  /* Without a write barrier there's nothing for cards to do. */
+  UNUSED(p);
+  UNUSED(i);
+  UNUSED(res);
+  UNUSED(cards);
+  return ResUNIMPL;
+#endif
+}
+
+
+/* SegHasCards -- does a segment have a card table? */
+
+Bool SegHasCards(Seg seg)
+{
+  return IsA(GCSeg, seg) && SegGCSeg(seg)->cards > 0;
+}
+
+
+/* SegCardIndex -- index of the card containing an address */
+
+Index SegCardIndex(Seg seg, Addr addr)
+{
+  GCSeg gcseg = SegGCSeg(seg);
+  AVER(gcseg->cards > 0);
+  AVER(SegBase(seg) <= addr);
+  AVER(addr < SegLimit(seg));
+  return AddrOffset(SegBase(seg), addr) >> gcseg->cardShift;
+}
+
+
+/* SegCardSummary -- summary of references out of a card */
+
+RefSet SegCardSummary(Seg seg, Index i)
+{
+  GCSeg gcseg = SegGCSeg(seg);
+  AVER(i < gcseg->cards);
+  return gcseg->cardSummary[i];
+}
+
+
+/* SegCardIsDirty -- has the mutator written to a card? */
+
+Bool SegCardIsDirty(Seg seg, Index i)
+{
+  GCSeg gcseg = SegGCSeg(seg);
+  AVER(i < gcseg->cards);
+  return BTGet(gcseg->cardDirty, i);
+}
+
+
+/* SegFindDirtyCards -- find the next run of dirty cards
+ *
+ * Finds the first run of dirty cards in the segment that lies at or
+ * above base, and returns its address range.  Returns FALSE if there
+ * is none, which is always the case for a segment without cards.
+ * The shield uses this to honour <design/seg/#card.prot>.
+ */
+
+Bool SegFindDirtyCards(Addr *baseReturn, Addr *limitReturn,
+                       Seg seg, Addr base)
+{
+  GCSeg gcseg;
+  Index i, j;
+
+  AVER(baseReturn != NULL);
+  AVER(limitReturn != NULL);
+  AVER(SegBase(seg) <= base);
+  AVER(base <= SegLimit(seg));
+
+  if (!IsA(GCSeg, seg))
+    return FALSE;
+  gcseg = SegGCSeg(seg);
+  if (gcseg->cardsDirty == 0)
+    return FALSE;
+
+  i = AddrOffset(SegBase(seg), base) >> gcseg->cardShift;
+  while (i < gcseg->cards && !BTGet(gcseg->cardDirty, i))
+    ++i;
+  if (i == gcseg->cards)
+    return FALSE;
+  j = i + 1;
+  while (j < gcseg->cards && BTGet(gcseg->cardDirty, j))
+    ++j;
+  *baseReturn = AddrAdd(SegBase(seg), (Size)i << gcseg->cardShift);
+  *limitReturn = AddrAdd(SegBase(seg), (Size)j << gcseg->cardShift);
+  return TRUE;
+}
+
+
+/* SegSetCardSummary -- set the summary of a card after scanning it
+ *
+ * The card is no longer dirty, and gets the segment's protection
+ * back.  This doesn't change the summary of the segment: the scan
+ * must finish with SegCardsScanned, see <design/seg/#card.summary>.
+ */
+
+void SegSetCardSummary(Seg seg, Index i, RefSet summary)
+{
+  GCSeg gcseg = SegGCSeg(seg);
+
+  AVER(i < gcseg->cards);
+  gcseg->cardSummary[i] = summary;
+  if (BTGet(gcseg->cardDirty, i)) {
+    Addr base = AddrAdd(SegBase(seg), (Size)i << gcseg->cardShift);
+    BTRes(gcseg->cardDirty, i);
+    AVER(gcseg->cardsDirty > 0);
+    --gcseg->cardsDirty;
+    ShieldSyncCards(PoolArena(SegPool(seg)), seg, base,
+                    AddrAdd(base, (Size)1 << gcseg->cardShift));
+  }
+}
+
+
+/* SegCardsScanned -- note that a scan has set every card's summary
+ *
+ * The next summary set on the segment will keep the card summaries
+ * if it is their union.  See <design/seg/#card.summary>.
+ */
+
+void SegCardsScanned(Seg seg)
+{
+  GCSeg gcseg = SegGCSeg(seg);
+
+  AVER(gcseg->cards > 0);
+  gcseg->cardsScanned = TRUE;
+}
+
+
+/* SegCardWrite -- handle a write barrier hit on one card
+ *
+ * Marks the card containing addr as dirty and asks the shield to
+ * remove write protection from that card only.  The segment keeps its write
+ * barrier, but its summary becomes RefSetUNIV, since the summary of
+ * the dirty card is now the mutator's.  See <design/seg/#card.write>.
+ */
+
+void SegCardWrite(Seg seg, Addr addr)
+{
+  GCSeg gcseg = SegGCSeg(seg);
+  Index i = SegCardIndex(seg, addr);
+  Addr base = AddrAdd(SegBase(seg), (Size)i << gcseg->cardShift);
+
+  AVER(SegRankSet(seg) != RankSetEMPTY);
+  gcseg->cardSummary[i] = RefSetUNIV;
+  gcseg->summary = RefSetUNIV;
+  if (!BTGet(gcseg->cardDirty, i)) {
+    BTSet(gcseg->cardDirty, i);
+    ++gcseg->cardsDirty;
+  }
+  ShieldSyncCards(PoolArena(SegPool(seg)), seg, base,
+                  AddrAdd(base, (Size)1 << gcseg->cardShift));
+}
+
+
 /* gcSegBuffer -- GCSeg method to return the buffer of a segment */
 
 static Bool gcSegBuffer(Buffer *bufferReturn, Seg seg)
@@ -1424,6 +1736,7 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   TraceSet grey;
   RefSet summary;
   Buffer buf;
+  TraceId ti;
   Res res;
 
   AVERT(Seg, seg);
@@ -1432,6 +1745,8 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   gcsegHi = SegGCSeg(segHi);
   AVERT(GCSeg, gcseg);
   AVERT(GCSeg, gcsegHi);
+  AVER(gcseg->cards == 0);   /* <design/seg/#card.split-merge> */
+  AVER(gcsegHi->cards == 0);
   AVER(base < mid);
   AVER(mid < limit);
   AVER(SegBase(seg) == base);
@@ -1468,7 +1783,8 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   gcSegSetGreyInternal(segHi, grey, TraceSetEMPTY);
   gcsegHi->summary = RefSetEMPTY;
   gcsegHi->sig = SigInvalid;
-  RingFinish(&gcsegHi->greyRing);
+  for (ti = 0; ti < TraceLIMIT; ++ti)
+    RingFinish(&gcsegHi->greyRing[ti]);
   RingRemove(&gcsegHi->genRing);
   RingFinish(&gcsegHi->genRing);
 
@@ -1498,12 +1814,14 @@ static Res gcSegSplit(Seg seg, Seg segHi,
   GCSeg gcseg, gcsegHi;
   Buffer buf;
   TraceSet grey;
+  TraceId ti;
   Res res;
 
   AVERT(Seg, seg);
   AVER(segHi != NULL);  /* can't check fully, it's not initialized */
   gcseg = SegGCSeg(seg);
   AVERT(GCSeg, gcseg);
+  AVER(gcseg->cards == 0);   /* <design/seg/#card.split-merge> */
   AVER(base < mid);
   AVER(mid < limit);
   AVER(SegBase(seg) == base);
@@ -1529,7 +1847,14 @@ static Res gcSegSplit(Seg seg, Seg segHi,
   gcsegHi = SegGCSeg(segHi);
   gcsegHi->summary = gcseg->summary;
   gcsegHi->buffer = NULL;
-  RingInit(&gcsegHi->greyRing);
+  gcsegHi->cards = 0;
+  gcsegHi->cardShift = 0;
+  gcsegHi->cardSummary = NULL;
+  gcsegHi->cardDirty = NULL;
+  gcsegHi->cardsDirty = 0;
+  gcsegHi->cardsScanned = FALSE;
+  for (ti = 0; ti < TraceLIMIT; ++ti)
+    RingInit(&gcsegHi->greyRing[ti]);
   RingInit(&gcsegHi->genRing);
   RingInsert(&gcseg->genRing, &gcsegHi->genRing);
   gcsegHi->sig = GCSegSig;
@@ -1571,6 +1896,7 @@ static Res gcSegDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
 
   res = WriteF(stream, depth + 2,
                "summary $W\n", (WriteFW)gcseg->summary,
+               "cards $U\n", (WriteFU)gcseg->cards,
                NULL);
   if (res != ResOK)
     return res;
@@ -210,6 +210,35 @@ static Bool SegIsExposed(Seg seg)
 }
 
 
+/* shieldProtSet -- set the hardware protection of part of a segment
+ *
+ * Sets the protection of [base, limit) to mode, except that dirty
+ * cards keep their write barrier down.  So the hardware protection of
+ * each card is always determined by SegPM and the card's dirty bit.
+ * See <design/seg/#card.prot>.
+ */
+
+static void shieldProtSet(Seg seg, Addr base, Addr limit, AccessSet mode)
+{
+  Addr dirtyBase, dirtyLimit;
+
+  if (BS_INTER(mode, AccessWRITE) != AccessSetEMPTY) {
+    while (base < limit
+           && SegFindDirtyCards(&dirtyBase, &dirtyLimit, seg, base)
+           && dirtyBase < limit) {
+      if (base < dirtyBase)
+        ProtSet(base, dirtyBase, mode);
+      if (dirtyLimit > limit)
+        dirtyLimit = limit;
+      ProtSet(dirtyBase, dirtyLimit, BS_DIFF(mode, AccessWRITE));
+      base = dirtyLimit;
+    }
+  }
+  if (base < limit)
+    ProtSet(base, limit, mode);
+}
+
+
 /* shieldSync -- synchronize a segment's protection
  *
  * See design.mps.shield.inv.prot.shield.
@@ -221,7 +250,7 @@ static void shieldSync(Shield shield, Seg seg)
 
   if (!SegIsSynced(seg)) {
     shieldSetPM(shield, seg, SegSM(seg));
-    ProtSet(SegBase(seg), SegLimit(seg), SegPM(seg));
+    shieldProtSet(seg, SegBase(seg), SegLimit(seg), SegPM(seg));
   }
 }
 
@@ -302,7 +331,7 @@ static void shieldProtLower(Shield shield, Seg seg, AccessSet mode)
 
   if (BS_INTER(SegPM(seg), mode) != AccessSetEMPTY) {
     shieldSetPM(shield, seg, BS_DIFF(SegPM(seg), mode));
-    ProtSet(SegBase(seg), SegLimit(seg), SegPM(seg));
+    shieldProtSet(seg, SegBase(seg), SegLimit(seg), SegPM(seg));
   }
 }
 
@@ -410,7 +439,21 @@ static void shieldFlushEntries(Shield shield)
   for (i = 0; i < shield->limit; ++i) {
     Seg seg = shieldDequeue(shield, i);
     if (!SegIsSynced(seg)) {
+      Addr dirtyBase, dirtyLimit;
       shieldSetPM(shield, seg, SegSM(seg));
+      if (BS_INTER(SegSM(seg), AccessWRITE) != AccessSetEMPTY
+          && SegFindDirtyCards(&dirtyBase, &dirtyLimit, seg, SegBase(seg))) {
+        /* Dirty cards break the run: see <design/seg/#card.prot>. */
+        if (base != NULL) {
+          AVER(base < limit);
+          ProtSet(base, limit, mode);
+        }
+        shieldProtSet(seg, SegBase(seg), SegLimit(seg), SegSM(seg));
+        base = NULL;
+        limit = NULL;
+        mode = AccessSetEMPTY;
+        continue;
+      }
       if (SegSM(seg) != mode || SegBase(seg) != limit) {
         if (base != NULL) {
           AVER(base < limit);
@@ -760,6 +803,29 @@ void (ShieldCover)(Arena arena, Seg seg)
 }
 
 
+/* ShieldSyncCards -- bring card protection into line
+ *
+ * Called by the segment module after changing whether the cards in
+ * [base, limit) are dirty.  The hardware protection of each card is
+ * the segment's protection mode, less write protection if the card is
+ * dirty, so this only needs to do anything if that mode includes
+ * write protection.  The shield's modes for the segment don't change.
+ * See <design/seg/#card.prot>.
+ */
+
+void (ShieldSyncCards)(Arena arena, Seg seg, Addr base, Addr limit)
+{
+  AVERT(Arena, arena);
+  AVERT(Seg, seg);
+  AVER(SegBase(seg) <= base);
+  AVER(base < limit);
+  AVER(limit <= SegLimit(seg));
+
+  if (BS_INTER(SegPM(seg), AccessWRITE) != AccessSetEMPTY)
+    shieldProtSet(seg, base, limit, SegPM(seg));
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2016 Ravenbrook Limited <http://www.ravenbrook.com/>.
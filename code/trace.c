@@ -34,17 +34,22 @@ Bool ScanStateCheck(ScanState ss)
 {
   TraceId ti;
   Trace trace;
-  ZoneSet white;
+  ZoneSet white, fineWhite;
 
   CHECKS(ScanState, ss);
   CHECKL(FUNCHECK(ss->fix));
   /* Can't check ss->fixClosure. */
   CHECKL(ScanStateZoneShift(ss) == ss->arena->zoneShift);
+  CHECKL(ss->fineZoneShift == ss->arena->fineZoneShift);
   white = ZoneSetEMPTY;
-  TRACE_SET_ITER(ti, trace, ss->traces, ss->arena)
+  fineWhite = ZoneSetEMPTY;
+  TRACE_SET_ITER(ti, trace, ss->traces, ss->arena) {
     white = ZoneSetUnion(white, ss->arena->trace[ti].white);
-  TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
+    fineWhite = ZoneSetUnion(fineWhite, ss->arena->trace[ti].fineWhite);
+  } TRACE_SET_ITER_END(ti, trace, ss->traces, ss->arena);
   CHECKL(ScanStateWhite(ss) == white);
+  CHECKL(ss->fineWhite == (ss->arena->zoneFineBits == 0
+                           ? ZoneSetUNIV : fineWhite));
   CHECKU(Arena, ss->arena);
   /* Summaries could be anything, and can't be checked. */
   CHECKL(TraceSetCheck(ss->traces));
@@ -63,6 +68,7 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
 {
   TraceId ti;
   Trace trace;
+  ZoneSet fineWhite = ZoneSetEMPTY;
 
   AVERT(TraceSet, ts);
   AVERT(Arena, arena);
@@ -83,6 +89,7 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
       AVER(ss->fix == trace->fix);
       AVER(ss->fixClosure == trace->fixClosure);
     }
+    fineWhite = ZoneSetUnion(fineWhite, trace->fineWhite);
   } TRACE_SET_ITER_END(ti, trace, ts, arena);
   AVER(ss->fix != NULL);
 
@@ -99,6 +106,10 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   ss->arena = arena;
   ss->wasMarked = TRUE;
   ScanStateSetWhite(ss, white);
+  /* The fine zone test is off unless the arena distinguishes more
+     zones than the zone test.  See <design/arena/#zone.fine>. */
+  ss->fineZoneShift = arena->fineZoneShift;
+  ss->fineWhite = arena->zoneFineBits == 0 ? ZoneSetUNIV : fineWhite;
   STATISTIC(ss->fixRefCount = (Count)0);
   STATISTIC(ss->segRefCount = (Count)0);
   STATISTIC(ss->whiteSegRefCount = (Count)0);
@@ -378,6 +389,10 @@ Res TraceAddWhite(Trace trace, Seg seg)
     /* Add the segment to the approximation of the white set if the
        pool made it white. */
     trace->white = ZoneSetUnion(trace->white, ZoneSetOfSeg(trace->arena, seg));
+    trace->fineWhite = ZoneSetUnion(trace->fineWhite,
+                                    FineZoneSetOfRange(trace->arena,
+                                                       SegBase(seg),
+                                                       SegLimit(seg)));
 
     /* if the pool is a moving GC, then condemned objects may move */
     if (PoolHasAttr(pool, AttrMOVINGGC)) {
@@ -406,6 +421,7 @@ void TraceCondemnStart(Trace trace)
   AVERT(Trace, trace);
   AVER(trace->state == TraceINIT);
   AVER(trace->white == ZoneSetEMPTY);
+  AVER(trace->fineWhite == ZoneSetEMPTY);
 
   ShieldHold(trace->arena);
 }
@@ -447,12 +463,21 @@ static Res traceScanRootRes(TraceSet ts, Rank rank, Arena arena, Root root)
   ZoneSet white;
   Res res;
   ScanStateStruct ss;
+  Bool sample;
+  Clock start = 0;
 
   white = traceSetWhiteUnion(ts, arena);
 
   ScanStateInit(&ss, ts, arena, rank, white);
 
+  /* Sample root scans like segment scans, so that both contribute to
+     the scan rate in proportion: see <code/policy.c#rate.sample>. */
+  sample = PolicyRateSample(arena);
+  if (sample)
+    start = ClockNow();
   res = RootScan(&ss, root);
+  if (sample)
+    RateAccumulate(&arena->scanRate, ss.scannedSize, start, ClockNow());
 
   traceSetUpdateCounts(ts, arena, &ss, traceAccountingPhaseRootScan);
   ScanStateFinish(&ss);
@@ -595,10 +620,10 @@ static Res traceFlip(Trace trace)
   /* achieved by read protecting all segments containing objects */
   /* which are grey for any of the flipped traces. */
   for(rank = RankMIN; rank < RankLIMIT; ++rank)
-    RING_FOR(node, ArenaGreyRing(arena, rank), nextNode) {
-      Seg seg = SegOfGreyRing(node);
-      if(TraceSetInter(SegGrey(seg), arena->flippedTraces) == TraceSetEMPTY
-          && TraceSetIsMember(SegGrey(seg), trace))
+    RING_FOR(node, ArenaGreyRing(arena, trace->ti, rank), nextNode) {
+      Seg seg = SegOfGreyRing(node, trace->ti);
+      AVER(TraceSetIsMember(SegGrey(seg), trace));
+      if(TraceSetInter(SegGrey(seg), arena->flippedTraces) == TraceSetEMPTY)
         ShieldRaise(arena, seg, AccessREAD);
     }
 
@@ -670,6 +695,7 @@ found:
   trace->arena = arena;
   trace->why = why;
   trace->white = ZoneSetEMPTY;
+  trace->fineWhite = ZoneSetEMPTY;
   trace->mayMove = ZoneSetEMPTY;
   trace->ti = ti;
   trace->state = TraceINIT;
@@ -846,7 +872,15 @@ static void traceReclaim(Trace trace)
       if(TraceSetIsMember(SegWhite(seg), trace)) {
         AVER_CRITICAL(PoolHasAttr(pool, AttrGC));
         STATISTIC(++trace->reclaimCount);
-        PoolReclaim(pool, trace, seg);
+        if (PolicyRateSample(arena)) {
+          /* Measure the reclaim rate: see <code/policy.c#rate>. */
+          Size size = SegSize(seg);
+          Clock start = ClockNow();
+          PoolReclaim(pool, trace, seg);
+          RateAccumulate(&arena->reclaimRate, size, start, ClockNow());
+        } else {
+          PoolReclaim(pool, trace, seg);
+        }
 
         /* If the segment still exists, it should no longer be white. */
         /* Note that the seg returned by this SegOfAddr may not be */
@@ -874,6 +908,7 @@ static void traceReclaim(Trace trace)
   }
 
   ArenaCompact(arena, trace);  /* let arenavm drop chunks */
+  LocusBlacklistUpdate(arena);
 
   TracePostMessage(trace);  /* trace end */
   /* Immediately pre-allocate messages for next time; failure is okay */
@@ -1002,7 +1037,6 @@ static Bool traceFindGrey(Seg *segReturn, Rank *rankReturn,
 {
   Rank rank;
   Trace trace;
-  Ring node, nextNode;
 
   AVER(segReturn != NULL);
   AVERT(TraceId, ti);
@@ -1016,32 +1050,34 @@ static Bool traceFindGrey(Seg *segReturn, Rank *rankReturn,
     /* then successively earlier ones.  Slight hack: We never    */
     /* expect to find any segments of RankAMBIG, so we use      */
     /* this as a terminating condition for the loop.            */
+    /* The grey rings are per trace (see <design/seg/#field.greyRing>), */
+    /* so any segment on one is grey for this trace and the first     */
+    /* segment found is the one to scan.                              */
     for(rank = band; rank > RankAMBIG; --rank) {
-      RING_FOR(node, ArenaGreyRing(arena, rank), nextNode) {
-        Seg seg = SegOfGreyRing(node);
+      Ring ring = ArenaGreyRing(arena, ti, rank);
+      if(!RingIsSingle(ring)) {
+        Seg seg = SegOfGreyRing(RingNext(ring), ti);
 
         AVERT(Seg, seg);
-        AVER(SegGrey(seg) != TraceSetEMPTY);
+        AVER(TraceSetIsMember(SegGrey(seg), trace));
         AVER(RankSetIsMember(SegRankSet(seg), rank));
 
-        if(TraceSetIsMember(SegGrey(seg), trace)) {
-          /* .check.band.weak */
-          AVER(band != RankWEAK || rank == band);
-          if(rank != band) {
-            traceBandFirstStretchDone(trace);
-          } else {
-            /* .check.final.one-pass */
-            AVER(traceBandFirstStretch(trace));
-          }
-          *segReturn = seg;
-          *rankReturn = rank;
-          EVENT4(TraceFindGrey, arena, ti, seg, rank);
-          return TRUE;
+        /* .check.band.weak */
+        AVER(band != RankWEAK || rank == band);
+        if(rank != band) {
+          traceBandFirstStretchDone(trace);
+        } else {
+          /* .check.final.one-pass */
+          AVER(traceBandFirstStretch(trace));
         }
+        *segReturn = seg;
+        *rankReturn = rank;
+        EVENT4(TraceFindGrey, arena, ti, seg, rank);
+        return TRUE;
       }
     }
     /* .check.ambig.not */
-    AVER(RingIsSingle(ArenaGreyRing(arena, RankAMBIG)));
+    AVER(RingIsSingle(ArenaGreyRing(arena, ti, RankAMBIG)));
     if(!traceBandAdvance(trace)) {
       /* No grey segments for this trace. */
       return FALSE;
@@ -1113,11 +1149,22 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
   } else {      /* scan it */
     ScanStateStruct ssStruct;
     ScanState ss = &ssStruct;
+    Bool sample = PolicyRateSample(arena);
+    Clock start = 0, end;
     ScanStateInit(ss, ts, arena, rank, white);
 
     /* Expose the segment to make sure we can scan it. */
     ShieldExpose(arena, seg);
+    if (sample)
+      start = ClockNow();
     res = PoolScan(&wasTotal, ss, SegPool(seg), seg);
+    if (sample) {
+      /* Measure the scan rate: see <code/policy.c#rate>. */
+      end = ClockNow();
+      RateAccumulate(&SegPool(seg)->scanRate[rank], ss->scannedSize,
+                     start, end);
+      RateAccumulate(&arena->scanRate, ss->scannedSize, start, end);
+    }
     /* Cover, regardless of result */
     ShieldCover(arena, seg);
 
@@ -1143,9 +1190,14 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
      */
     AVER(RefSetSub(ScanStateUnfixedSummary(ss), SegSummary(seg))); /* <design/check/#.common> */
 
-    /* Write barrier deferral -- see design.mps.write-barrier.deferral. */
+    /* Write barrier deferral -- see design.mps.write-barrier.deferral.
+     * Segments with cards don't defer, since a hit only exposes one
+     * card: see <design/seg/#card.defer>. */
     /* Did the segment refer to the white set? */
-    if (ZoneSetInter(ScanStateUnfixedSummary(ss), white) == ZoneSetEMPTY) {
+    if (SegHasCards(seg)) {
+      AVER(seg->defer == 0);
+    } else if (ZoneSetInter(ScanStateUnfixedSummary(ss), white)
+               == ZoneSetEMPTY) {
       /* Boring scan.  One step closer to raising the write barrier. */
       if (seg->defer > 0)
         --seg->defer;
@@ -1204,21 +1256,29 @@ static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg)
 }
 
 
-/* TraceSegAccess -- handle barrier hit on a segment */
+/* TraceSegAccess -- handle barrier hit on a segment
+ *
+ * addr is the address that was accessed, or NULL if the access is
+ * not to a particular address (see <code/protan.c>).  A write hit at
+ * an address in a segment with cards only exposes that card: see
+ * <design/seg/#card.write>.
+ */
 
-void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
+void TraceSegAccess(Arena arena, Seg seg, Addr addr, AccessSet mode)
 {
   Res res;
   AccessSet shieldHit;
-  Bool readHit, writeHit;
+  Bool readHit, writeHit, cardHit;
 
   AVERT(Arena, arena);
   AVERT(Seg, seg);
+  AVER(addr == NULL || (SegBase(seg) <= addr && addr < SegLimit(seg)));
   AVERT(AccessSet, mode);
 
   shieldHit = BS_INTER(mode, SegSM(seg));
   readHit = BS_INTER(shieldHit, AccessREAD) != AccessSetEMPTY;
   writeHit = BS_INTER(shieldHit, AccessWRITE) != AccessSetEMPTY;
+  cardHit = writeHit && addr != NULL && SegHasCards(seg);
 
   /* If it's a read access, then the segment must be grey for a trace */
   /* which is flipped. */
@@ -1227,13 +1287,14 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
 
   /* If it's a write access, then the segment must have a summary that */
   /* is smaller than the mutator's summary (which is assumed to be */
-  /* RefSetUNIV). */
-  AVER(!writeHit || SegSummary(seg) != RefSetUNIV);
+  /* RefSetUNIV), unless the segment has cards, in which case that's */
+  /* only true of the cards that haven't been written. */
+  AVER(!writeHit || cardHit || SegSummary(seg) != RefSetUNIV);
 
   EVENT3(TraceAccess, arena, seg, mode);
 
   /* Write barrier deferral -- see design.mps.write-barrier.deferral. */
-  if (writeHit)
+  if (writeHit && !SegHasCards(seg))
     seg->defer = WB_DEFER_HIT;
 
   if (readHit) {
@@ -1270,93 +1331,70 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
 
   /* The write barrier handling must come after the read barrier, */
   /* because the latter may set the summary and raise the write barrier. */
-  if (writeHit)
-    SegSetSummary(seg, RefSetUNIV);
+  if (cardHit) {
+    SegCardWrite(seg, addr);
+    /* The card must now be accessible, though the segment isn't. */
+    AVER(BS_INTER(mode, SegSM(seg)) == BS_INTER(mode, AccessWRITE)
+         || BS_INTER(mode, SegSM(seg)) == AccessSetEMPTY);
+  } else {
+    if (writeHit)
+      SegSetSummary(seg, RefSetUNIV);
 
-  /* The segment must now be accessible. */
-  AVER(BS_INTER(mode, SegSM(seg)) == AccessSetEMPTY);
+    /* The segment must now be accessible. */
+    AVER(BS_INTER(mode, SegSM(seg)) == AccessSetEMPTY);
+  }
 }
 
 
-/* _mps_fix2 (a.k.a. "TraceFix") -- second stage of fixing a reference
- *
- * _mps_fix2 is on the [critical path](../design/critical-path.txt).  A
- * one-instruction difference in the early parts of this code will have a
- * significant impact on overall run time.  The priority is to eliminate
- * irrelevant references early and fast using the colour information stored
- * in the tract table.
+/* traceFixChunk -- second stage of fixing a reference into a chunk
  *
- * The name "TraceFix" is pervasive in the MPS and its documents to describe
- * this function.  Optimisation and strict aliasing rules have meant that we
- * need to use the external name for it here.
+ * This is the part of _mps_fix2 after the chunk lookup.  It's shared
+ * with _mps_fix2_refs, which caches the chunk between references.
  */
 
-mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
+static Res traceFixChunk(ScanState ss, Chunk chunk, Ref *refIO)
 {
-  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
-  Ref ref;
-  Chunk chunk;
+  Ref ref = *refIO;
   Index i;
+  PageColour colour;
   Tract tract;
   Seg seg;
   Res res;
   Pool pool;
 
-  /* Special AVER macros are used on the critical path. */
-  /* See <design/trace/#fix.noaver> */
-  AVERT_CRITICAL(ScanState, ss);
-  AVER_CRITICAL(mps_ref_io != NULL);
-
-  ref = (Ref)*mps_ref_io;
-
-  /* The zone test should already have been passed by MPS_FIX1 in mps.h. */
-  AVER_CRITICAL(ZoneSetInter(ScanStateWhite(ss),
-                             ZoneSetAddAddr(ss->arena, ZoneSetEMPTY, ref)) !=
-                ZoneSetEMPTY);
-
-  STATISTIC(++ss->fixRefCount);
-  EVENT4(TraceFix, ss, mps_ref_io, ref, ss->rank);
-
-  /* This sequence of tests is equivalent to calling TractOfAddr(),
-   * but inlined so that we can distinguish between "not pointing to
-   * chunk" and "pointing to chunk but not to tract" so that we can
-   * check the rank in the latter case. See
-   * <design/trace/#fix.tractofaddr.inline>
-   *
-   * If compilers fail to do a good job of inlining ChunkOfAddr and
-   * TreeFind then it may become necessary to inline at least the
-   * comparison against the root of the tree. See
-   * <https://info.ravenbrook.com/mail/2014/06/11/13-32-08/0/>
-   */
-  if (!ChunkOfAddr(&chunk, ss->arena, ref))
-    /* Reference points outside MPS-managed address space: ignore. */
-    goto done;
-
+  /* The colour table answers the first two questions without
+   * touching the page table.  See <code/tract.h#colour>. */
   i = INDEX_OF_ADDR(chunk, ref);
-  if (!BTGet(chunk->allocTable, i)) {
+  colour = ChunkColour(chunk, i);
+  if ((colour & PageColourALLOC) == 0) {
     /* Reference points into a chunk but not to an allocated tract.
      * See <design/trace/#exact.legal> */
+    AVER_CRITICAL(!BTGet(chunk->allocTable, i));
     AVER_CRITICAL(ss->rank < RankEXACT); /* <design/check/#.common> */
-    goto done;
+    return ResOK;
   }
 
-  tract = PageTract(&chunk->pageTable[i]);
-  if (TraceSetInter(TractWhite(tract), ss->traces) == TraceSetEMPTY) {
+  if (TraceSetInter(PageColourWhite(colour), ss->traces) == TraceSetEMPTY) {
     /* Reference points to a tract that is not white for any of the
      * active traces. See <design/trace/#fix.tractofaddr> */
     STATISTIC({
-      if (TRACT_SEG(&seg, tract)) {
-        ++ss->segRefCount;
-        EVENT1(TraceFixSeg, seg);
+      if ((colour & PageColourSEG) != 0) {
+        tract = PageTract(&chunk->pageTable[i]);
+        if (TRACT_SEG(&seg, tract)) {
+          ++ss->segRefCount;
+          EVENT1(TraceFixSeg, seg);
+        }
       }
     });
-    goto done;
+    return ResOK;
   }
 
+  tract = PageTract(&chunk->pageTable[i]);
+  AVER_CRITICAL(TractWhite(tract) == PageColourWhite(colour));
   if (!TRACT_SEG(&seg, tract)) {
     /* Tracts without segments must not be condemned. */
     NOTREACHED;
-    goto done;
+    return ResOK;
   }
 
   STATISTIC(++ss->segRefCount);
@@ -1364,7 +1402,7 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
   EVENT1(TraceFixSeg, seg);
   EVENT0(TraceFixWhite);
   pool = TractPool(tract);
-  res = (*ss->fix)(pool, ss, seg, &ref);
+  res = (*ss->fix)(pool, ss, seg, refIO);
   if (res != ResOK) {
     /* PoolFixEmergency must not fail. */
     AVER_CRITICAL(ss->fix != PoolFixEmergency);
@@ -1372,14 +1410,88 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
      * Justification for this restriction:
      * A: it simplifies;
      * B: it's reasonable (given what may cause Fix to fail);
-     * C: the code (here) already assumes this: it returns without 
-     *    updating ss->fixedSummary.  RHSK 2007-03-21.
+     * C: the code (in the callers) already assumes this: they return
+     *    without updating ss->fixedSummary.  RHSK 2007-03-21.
      */
-    AVER_CRITICAL(ref == (Ref)*mps_ref_io);
+    AVER_CRITICAL(*refIO == ref);
     return res;
   }
 
-done:
+  return ResOK;
+}
+
+
+/* traceFineTest -- does a reference pass the fine zone test?
+ *
+ * The zone test in MPS_FIX1 distinguishes only MPS_WORD_WIDTH zones.
+ * If the client asked for more with MPS_KEY_ARENA_ZONES, then a
+ * reference that passes it must also be in a fine zone of the white
+ * set before it is worth looking up its chunk; otherwise the fine white
+ * set is ZoneSetUNIV and the test is off.  See
+ * <design/arena/#zone.fine>.
+ */
+
+#define traceFineTest(ss, ref) \
+  ((ss)->fineWhite == ZoneSetUNIV \
+   || ZoneSetIsMember((ss)->fineWhite, \
+                      (Word)(ref) >> (ss)->fineZoneShift \
+                      & (MPS_WORD_WIDTH - 1)))
+
+
+/* _mps_fix2 (a.k.a. "TraceFix") -- second stage of fixing a reference
+ *
+ * _mps_fix2 is on the [critical path](../design/critical-path.txt).  A
+ * one-instruction difference in the early parts of this code will have a
+ * significant impact on overall run time.  The priority is to eliminate
+ * irrelevant references early and fast using the colour information stored
+ * in the chunk's colour table (see <code/tract.h#colour>).
+ *
+ * The name "TraceFix" is pervasive in the MPS and its documents to describe
+ * this function.  Optimisation and strict aliasing rules have meant that we
+ * need to use the external name for it here.
+ */
+
+mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  Ref ref;
+  Chunk chunk;
+  Res res;
+
+  /* Special AVER macros are used on the critical path. */
+  /* See <design/trace/#fix.noaver> */
+  AVERT_CRITICAL(ScanState, ss);
+  AVER_CRITICAL(mps_ref_io != NULL);
+
+  ref = (Ref)*mps_ref_io;
+
+  /* The zone test should already have been passed by MPS_FIX1 in mps.h. */
+  AVER_CRITICAL(ZoneSetInter(ScanStateWhite(ss),
+                             ZoneSetAddAddr(ss->arena, ZoneSetEMPTY, ref)) !=
+                ZoneSetEMPTY);
+
+  STATISTIC(++ss->fixRefCount);
+  EVENT4(TraceFix, ss, mps_ref_io, ref, ss->rank);
+
+  /* This sequence of tests is equivalent to calling TractOfAddr(),
+   * but inlined so that we can distinguish between "not pointing to
+   * chunk" and "pointing to chunk but not to tract" so that we can
+   * check the rank in the latter case. See
+   * <design/trace/#fix.tractofaddr.inline>
+   *
+   * ChunkOfAddr usually finds the chunk in the arena's chunk map
+   * without searching the chunk tree. See <design/arena/#chunk.map>
+   * and <https://info.ravenbrook.com/mail/2014/06/11/13-32-08/0/>
+   *
+   * References that point outside MPS-managed address space are
+   * ignored, as are references that fail the fine zone test.
+   */
+  if (traceFineTest(ss, ref) && ChunkOfAddr(&chunk, ss->arena, ref)) {
+    res = traceFixChunk(ss, chunk, &ref);
+    if (res != ResOK)
+      return res;
+  }
+
   /* See <design/trace/#fix.fixed.all> */
   ss->fixedSummary = RefSetAdd(ss->arena, ss->fixedSummary, ref);
   
@@ -1388,6 +1500,62 @@ done:
 }
 
 
+/* _mps_fix2_refs -- second stage of fixing several references
+ *
+ * Fixes each of the count references whose locations are in
+ * mps_ref_ios, all of which must have passed MPS_FIX1.  This is the
+ * same as calling _mps_fix2 on each of them in turn, except that the
+ * scan state is checked once, and the chunk of the previous reference
+ * is tried before searching the chunk tree, since the fields of an
+ * object tend to refer to nearby objects.  See
+ * <design/critical-path/#fix.batch>.
+ */
+
+mps_res_t _mps_fix2_refs(mps_ss_t mps_ss, mps_addr_t **mps_ref_ios,
+                         size_t count)
+{
+  ScanState ss = PARENT(ScanStateStruct, ss_s, mps_ss);
+  Chunk chunk = NULL;
+  size_t i;
+  Res res;
+
+  AVERT_CRITICAL(ScanState, ss);
+  AVER_CRITICAL(mps_ref_ios != NULL);
+
+  for (i = 0; i < count; ++i) {
+    mps_addr_t *mps_ref_io = mps_ref_ios[i];
+    Ref ref;
+
+    AVER_CRITICAL(mps_ref_io != NULL);
+    ref = (Ref)*mps_ref_io;
+    AVER_CRITICAL(ZoneSetInter(ScanStateWhite(ss),
+                               ZoneSetAddAddr(ss->arena, ZoneSetEMPTY, ref))
+                  != ZoneSetEMPTY);
+
+    STATISTIC(++ss->fixRefCount);
+    EVENT4(TraceFix, ss, mps_ref_io, ref, ss->rank);
+
+    if (!traceFineTest(ss, ref)) {
+      /* Reference fails the fine zone test: ignore. */
+    } else if ((chunk != NULL && chunk->base <= ref && ref < chunk->limit)
+               || ChunkOfAddr(&chunk, ss->arena, ref)) {
+      res = traceFixChunk(ss, chunk, &ref);
+      if (res != ResOK)
+        return res;
+    } else {
+      /* Reference points outside MPS-managed address space: ignore. */
+      chunk = NULL;
+    }
+
+    /* See <design/trace/#fix.fixed.all> */
+    ss->fixedSummary = RefSetAdd(ss->arena, ss->fixedSummary, ref);
+    *mps_ref_io = (mps_addr_t)ref;
+  }
+
+  return ResOK;
+}
+
+
 /* traceScanSingleRefRes -- scan a single reference, with result code */
 
 static Res traceScanSingleRefRes(TraceSet ts, Rank rank, Arena arena,
@@ -1658,8 +1826,6 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
       = (trace->foundation + sSurvivors) / (unsigned long)nPolls + 1;
   }
 
-  /* TODO: compute rate of scanning here. */
-
   EVENT8(TraceStart, trace, mortality, finishingTime,
          trace->condemned, trace->notCondemned,
          trace->foundation, trace->white,
@@ -1813,15 +1979,20 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
 
   AVER(arena->busyTraces == TraceSetSingle(trace));
   oldWork = traceWork(trace);
-  endWork = oldWork + trace->quantumWork;
+  /* The policy may split the quantum to keep within the pause time. */
+  endWork = oldWork + PolicyQuantumWork(arena, trace->quantumWork);
   do {
     TraceAdvance(trace);
   } while (trace->state != TraceFINISHED && traceWork(trace) < endWork);
   newWork = traceWork(trace);
   AVER(newWork >= oldWork);
   work = newWork - oldWork;
-  if (trace->state == TraceFINISHED)
+  if (trace->state == TraceFINISHED) {
     TraceDestroyFinished(trace);
+    /* Decay spare memory here rather than at every poll, so that it
+     * stays off the allocation path.  See <design/arena/#spare.decay>. */
+    PolicyDecay(arena);
+  }
   *workReturn = work;
   return TRUE;
 }
@@ -1856,6 +2027,7 @@ Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth)
                "  state $S\n", (WriteFS)state,
                "  band $U\n", (WriteFU)trace->band,
                "  white   $B\n", (WriteFB)trace->white,
+               "  fineWhite $B\n", (WriteFB)trace->fineWhite,
                "  mayMove $B\n", (WriteFB)trace->mayMove,
                "  chain $P\n", (WriteFP)trace->chain,
                "  condemned $U\n", (WriteFU)trace->condemned,
@@ -170,6 +170,9 @@ const char *TraceStartWhyToString(int why)
   case TraceStartWhyEXTENSION:
     r = "Extension: an MPS extension started the trace.";
     break;
+  case TraceStartWhyPRESSURE:
+    r = "The system is short of memory: start full collection.";
+    break;
   default:
     NOTREACHED;
     r = "Unknown reason (internal error).";
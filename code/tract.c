@@ -147,9 +147,15 @@ Bool ChunkCheck(Chunk chunk)
   CHECKL(AddrAdd((Addr)chunk->allocTable, BTSize(chunk->pages))
          <= PageIndexBase(chunk, chunk->allocBase));
 
+  CHECKL(chunk->colourTable != NULL);
+  CHECKL((Addr)chunk->colourTable >= chunk->base);
+  /* The white set must fit under the other colour bits. */
+  CHECKL(PageColourWHITE(TraceSetUNIV) < PageColourSEG);
+
   /* check they don't overlap (knowing the order) */
   CHECKL(AddrAdd((Addr)chunk->allocTable, BTSize(chunk->pages))
-         <= (Addr)chunk->pageTable);
+         <= (Addr)chunk->colourTable);
+  CHECKL((Addr)&chunk->colourTable[chunk->pages] <= (Addr)chunk->pageTable);
 
   CHECKL(chunk->pageTable != NULL);
   CHECKL((Addr)chunk->pageTable >= chunk->base);
@@ -204,6 +210,13 @@ Res ChunkInit(Chunk chunk, Arena arena, Addr base, Addr limit, Size reserved,
     goto failAllocTable;
   chunk->allocTable = p;
 
+  /* .overhead.colour: Chunk overhead for the page colour table. */
+  res = BootAlloc(&p, boot, (size_t)pages * sizeof(PageColour),
+                  MPS_PF_ALIGN);
+  if (res != ResOK)
+    goto failColourTable;
+  chunk->colourTable = p;
+
   pageTableSize = SizeAlignUp(pages * sizeof(PageUnion), chunk->pageSize);
   chunk->pageTablePages = pageTableSize >> pageShift;
 
@@ -218,8 +231,10 @@ Res ChunkInit(Chunk chunk, Arena arena, Addr base, Addr limit, Size reserved,
   AVER(AddrIsAligned(BootAllocated(boot), chunk->pageSize));
   chunk->allocBase = (Index)(BootAllocated(boot) >> pageShift);
 
-  /* Init allocTable after class init, because it might be mapped there. */
+  /* Init allocTable and colourTable after class init, because they
+     might be mapped there. */
   BTResRange(chunk->allocTable, 0, pages);
+  ChunkSetColourRange(chunk, 0, pages, PageColourFREE);
 
   /* Check that there is some usable address space remaining in the chunk. */
   allocBase = PageIndexBase(chunk, chunk->allocBase);
@@ -247,11 +262,30 @@ failLandInsert:
   /* .no-clean: No clean-ups needed past this point for boot, as we will
      discard the chunk. */
 failClassInit:
+failColourTable:
 failAllocTable:
   return res;
 }
 
 
+/* ChunkSetColourRange -- set the colour of a range of pages
+ *
+ * See <code/tract.h#colour>.
+ */
+
+void ChunkSetColourRange(Chunk chunk, Index base, Index limit,
+                         PageColour colour)
+{
+  /* Not checking chunk, since this is called from ChunkInit. */
+  AVER(chunk != NULL);
+  AVER(base <= limit);
+  AVER(limit <= chunk->pages);
+
+  (void)mps_lib_memset(&chunk->colourTable[base], (int)colour,
+                       (size_t)(limit - base) * sizeof(PageColour));
+}
+
+
 /* ChunkFinish -- finish the generic fields of a chunk */
 
 void ChunkFinish(Chunk chunk)
@@ -323,16 +357,28 @@ TreeKey ChunkKey(Tree tree)
 Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr)
 {
   Tree tree;
+  Chunk chunk;
+  Word i;
 
   AVER_CRITICAL(chunkReturn != NULL);
   AVERT_CRITICAL(Arena, arena);
   /* addr is arbitrary */
 
+  /* Try the chunk map first: see <design/arena/#chunk.map>. */
+  i = ChunkMapIndex(arena, addr);
+  if (i < ChunkMapLENGTH) {
+    chunk = arena->chunkMap[i];
+    if (chunk != NULL && chunk->base <= addr && addr < chunk->limit) {
+      *chunkReturn = chunk;
+      return TRUE;
+    }
+  }
+
   if (TreeFind(&tree, ArenaChunkTree(arena), TreeKeyOfAddrVar(addr),
                ChunkCompare)
       == CompareEQUAL)
   {
-    Chunk chunk = ChunkOfTree(tree);
+    chunk = ChunkOfTree(tree);
     AVER_CRITICAL(chunk->base <= addr);
     AVER_CRITICAL(addr < chunk->limit);
     *chunkReturn = chunk;
@@ -466,6 +512,7 @@ void PageAlloc(Chunk chunk, Index pi, Pool pool)
   tract = PageTract(page);
   base = PageIndexBase(chunk, pi);
   BTSet(chunk->allocTable, pi);
+  chunk->colourTable[pi] = PageColourALLOC;
   TractInit(tract, pool, base);
 }
 
@@ -482,6 +529,7 @@ void PageInit(Chunk chunk, Index pi)
   page = ChunkPage(chunk, pi);
 
   BTRes(chunk->allocTable, pi);
+  chunk->colourTable[pi] = PageColourFREE;
   PageSetPool(page, NULL);
   PageSetType(page, PageStateFREE);
   RingInit(PageSpareRing(page));
@@ -128,6 +128,27 @@ typedef union PageUnion {     /* page structure */
   END
 
 
+/* PageColour -- compact per-page colour for the fix path
+ *
+ * .colour: Each chunk has a table with one byte per page, which
+ * duplicates the page's bit in the allocTable, whether its tract
+ * belongs to a segment, and the tract's white set.  The critical
+ * path in _mps_fix2 rejects most references that survive the zone
+ * test by reading only this dense table, not the allocTable and the
+ * page table, which for a typical reference are on different cache
+ * lines.  See <design/arena/#colour>.
+ */
+
+typedef unsigned char PageColour;
+
+#define PageColourFREE          ((PageColour)0)
+#define PageColourALLOC         ((PageColour)1 << 7)
+#define PageColourSEG           ((PageColour)1 << 6)
+#define PageColourWHITE(white)  ((PageColour)(white))
+#define PageColourWhite(colour) \
+  ((TraceSet)((colour) & ~(PageColourALLOC | PageColourSEG)))
+
+
 /* Chunks */
 
 
@@ -146,6 +167,7 @@ typedef struct ChunkStruct {
   Index allocBase;      /* index of first page allocatable to clients */
   Index pages;          /* index of the page after the last allocatable page */
   BT allocTable;        /* page allocation table */
+  PageColour *colourTable; /* page colour table, <code/tract.h#colour> */
   Page pageTable;       /* the page table */
   Count pageTablePages; /* number of pages occupied by page table */
   Size reserved;        /* reserved address space for chunk (including overhead
@@ -161,6 +183,7 @@ typedef struct ChunkStruct {
 #define ChunkPagesToSize(chunk, pages) ((Size)(pages) << (chunk)->pageShift)
 #define ChunkSizeToPages(chunk, size) ((Count)((size) >> (chunk)->pageShift))
 #define ChunkPage(chunk, pi) (&(chunk)->pageTable[pi])
+#define ChunkColour(chunk, pi) RVALUE((chunk)->colourTable[pi])
 #define ChunkOfTree(tree) PARENT(ChunkStruct, chunkTree, tree)
 #define ChunkReserved(chunk) RVALUE((chunk)->reserved)
 
@@ -168,11 +191,22 @@ extern Bool ChunkCheck(Chunk chunk);
 extern Res ChunkInit(Chunk chunk, Arena arena, Addr base, Addr limit,
                      Size reserved, BootBlock boot);
 extern void ChunkFinish(Chunk chunk);
+extern void ChunkSetColourRange(Chunk chunk, Index base, Index limit,
+                                PageColour colour);
 extern Compare ChunkCompare(Tree tree, TreeKey key);
 extern TreeKey ChunkKey(Tree tree);
 extern Bool ChunkCacheEntryCheck(ChunkCacheEntry entry);
 extern void ChunkCacheEntryInit(ChunkCacheEntry entry);
 extern Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr);
+
+/* ChunkMapIndex -- index of the chunk map entry for an address
+ *
+ * The result is ChunkMapLENGTH or more if the address is not covered
+ * by the map.  See <design/arena/#chunk.map>.
+ */
+
+#define ChunkMapIndex(arena, addr) \
+  (((Word)(addr) - (Word)(arena)->chunkMapBase) >> (arena)->chunkMapShift)
 extern Res ChunkNodeDescribe(Tree node, mps_lib_FILE *stream);
 
 
@@ -26,6 +26,7 @@ Bool VMCheck(VM vm)
   CHECKL(vm->block != NULL);
   CHECKL((Addr)vm->block <= vm->base);
   CHECKL(vm->mapped <= vm->reserved);
+  CHECKL(BoolCheck(vm->hugePages));
   return TRUE;
 }
 
@@ -26,6 +26,8 @@ typedef struct VMStruct {
   Addr base, limit;             /* aligned boundaries of reserved space */
   Size reserved;                /* total reserved address space */
   Size mapped;                  /* total mapped memory */
+  Bool hugePages;               /* base aligned for huge pages? */
+  Word nodeIds;                 /* set of online NUMA node ids */
 } VMStruct;
 
 
@@ -36,6 +38,7 @@ typedef struct VMStruct {
 #define VMMapped(vm) RVALUE((vm)->mapped)
 
 extern Size PageSize(void);
+extern Count NodeCount(void);
 extern Size (VMPageSize)(VM vm);
 extern Bool VMCheck(VM vm);
 extern Res VMParamFromArgs(void *params, size_t paramSize, ArgList args);
@@ -45,6 +48,9 @@ extern Addr (VMBase)(VM vm);
 extern Addr (VMLimit)(VM vm);
 extern Res VMMap(VM vm, Addr base, Addr limit);
 extern void VMUnmap(VM vm, Addr base, Addr limit);
+extern Res VMRemap(VM vm, Addr base, Addr limit, VM src, Addr srcBase);
+extern void VMAdviseHuge(VM vm, Addr base, Addr limit, Bool huge);
+extern Res VMBind(VM vm, Addr base, Addr limit, Index node);
 extern Size (VMReserved)(VM vm);
 extern Size (VMMapped)(VM vm);
 extern void VMCopy(VM dest, VM src);
@@ -20,6 +20,17 @@ Size PageSize(void)
 }
 
 
+/* NodeCount -- return the number of NUMA nodes
+ *
+ * There is no NUMA in the ANSI fake VM, so there is one node.
+ */
+
+Count NodeCount(void)
+{
+  return 1;
+}
+
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
   AVER(params != NULL);
@@ -71,6 +82,8 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit < AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = (Size)0;
+  vm->hugePages = FALSE;
+  vm->nodeIds = 0;
  
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -147,6 +160,48 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMRemap -- move mapped memory from one place to another
+ *
+ * Not implemented: the caller falls back to unmapping and mapping.
+ */
+
+Res VMRemap(VM vm, Addr base, Addr limit, VM src, Addr srcBase)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVERT(VM, src);
+  AVER(srcBase != (Addr)0);
+  return ResUNIMPL;
+}
+
+
+/* VMAdviseHuge -- advise on huge pages for a range of memory
+ *
+ * There are no huge pages in the ANSI fake VM.
+ */
+
+void VMAdviseHuge(VM vm, Addr base, Addr limit, Bool huge)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVERT(Bool, huge);
+}
+
+
+/* VMBind -- prefer a NUMA node for a range of memory
+ *
+ * See NodeCount.
+ */
+
+Res VMBind(VM vm, Addr base, Addr limit, Index node)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  UNUSED(node);
+  return ResUNIMPL;
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2014 Ravenbrook Limited <http://www.ravenbrook.com/>.
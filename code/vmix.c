@@ -51,6 +51,13 @@
 /* for getpagesize(3) */
 #include <unistd.h>
 
+#if defined(MPS_OS_LI)
+/* for open(2), syscall(2) and mbind(2) */
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
 
 #if !defined(MPS_OS_FR) && !defined(MPS_OS_XC) && !defined(MPS_OS_LI)
 #error "vmix.c is Unix-like specific, currently MPS_OS_FR XC LI"
@@ -75,20 +82,106 @@ Size PageSize(void)
 }
 
 
+/* nodesOnline -- return the set of online NUMA node ids
+ *
+ * On Linux, parse the list in sysfs, which has the form "0-3" or
+ * "0,2-3".  Ids that don't fit in a Word are left out.  Elsewhere,
+ * and if anything goes wrong, the set is empty.
+ */
+
+static Word nodesOnline(void)
+{
+  Word ids = 0;
+#if defined(MPS_OS_LI)
+  char buf[256];
+  ssize_t len;
+  int fd;
+
+  fd = open("/sys/devices/system/node/online", O_RDONLY);
+  if (fd < 0)
+    return 0;
+  len = read(fd, buf, sizeof buf - 1);
+  (void)close(fd);
+  if (len > 0) {
+    ssize_t i = 0;
+    while (i < len && '0' <= buf[i] && buf[i] <= '9') {
+      unsigned long first = 0, last;
+      while (i < len && '0' <= buf[i] && buf[i] <= '9')
+        first = first * 10 + (unsigned long)(buf[i++] - '0');
+      last = first;
+      if (i < len && buf[i] == '-') {
+        ++i;
+        last = 0;
+        while (i < len && '0' <= buf[i] && buf[i] <= '9')
+          last = last * 10 + (unsigned long)(buf[i++] - '0');
+      }
+      if (last < first)
+        break;
+      for (; first <= last && first < MPS_WORD_WIDTH; ++first)
+        ids |= (Word)1 << first;
+      if (i < len && buf[i] == ',')
+        ++i;
+    }
+  }
+#endif
+  return ids;
+}
+
+
+/* NodeCount -- return the number of NUMA nodes
+ *
+ * Count the online nodes.  If there are none, there's one node.  See
+ * <design/arena/#numa>.
+ */
+
+Count NodeCount(void)
+{
+  Word ids = nodesOnline();
+  Count nodes = 0;
+
+  for (; ids != 0; ids &= ids - 1)
+    ++nodes;
+  return nodes > 0 ? nodes : 1;
+}
+
+
+typedef struct VMParamsStruct {
+  Bool hugePages;
+} VMParamsStruct, *VMParams;
+
+static const VMParamsStruct vmParamsDefaults = {
+  /* .hugePages = */ ARENA_DEFAULT_HUGE_PAGES,
+};
+
 Res VMParamFromArgs(void *params, size_t paramSize, ArgList args)
 {
+  VMParams vmParams;
+  ArgStruct arg;
+
   AVER(params != NULL);
   AVERT(ArgList, args);
-  UNUSED(paramSize);
+  AVER(paramSize >= sizeof(VMParamsStruct));
+
+  vmParams = (VMParams)params;
+  (void)mps_lib_memcpy(vmParams, &vmParamsDefaults, sizeof(VMParamsStruct));
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_HUGE_PAGES))
+    vmParams->hugePages = BOOLOF(arg.val.b);
   return ResOK;
 }
 
 
-/* VMInit -- reserve some virtual address space, and create a VM structure */
+/* VMInit -- reserve some virtual address space, and create a VM structure
+ *
+ * .huge.align: If the client asked for huge pages, the base is aligned
+ * to VM_HUGE_PAGE_SIZE (or the grain size, if larger) so that the
+ * operating system can back whole huge pages of the reservation.  See
+ * <design/arena/#huge>.
+ */
 
 Res VMInit(VM vm, Size size, Size grainSize, void *params)
 {
-  Size pageSize, reserved;
+  VMParams vmParams = params;
+  Size pageSize, reserved, align;
   void *vbase;
 
   AVER(vm != NULL);
@@ -101,12 +194,16 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   /* Grains must consist of whole pages. */
   AVER(grainSize % pageSize == 0);
 
+  align = grainSize;
+  if (vmParams->hugePages && align < VM_HUGE_PAGE_SIZE)
+    align = VM_HUGE_PAGE_SIZE;
+
   /* Check that the rounded-up sizes will fit in a Size. */
   size = SizeRoundUp(size, grainSize);
   if (size < grainSize || size > (Size)(size_t)-1)
     return ResRESOURCE;
-  reserved = size + grainSize - pageSize;
-  if (reserved < grainSize || reserved > (Size)(size_t)-1)
+  reserved = size + align - pageSize;
+  if (reserved < align || reserved > (Size)(size_t)-1)
     return ResRESOURCE;
 
   /* See .assume.not-last. */
@@ -124,12 +221,14 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
 
   vm->pageSize = pageSize;
   vm->block = vbase;
-  vm->base = AddrAlignUp(vbase, grainSize);
+  vm->base = AddrAlignUp(vbase, align);
   vm->limit = AddrAdd(vm->base, size);
   AVER(vm->base < vm->limit);  /* .assume.not-last */
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = 0;
+  vm->hugePages = vmParams->hugePages;
+  vm->nodeIds = nodesOnline();
 
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -223,6 +322,173 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMRemap -- move mapped memory from one place to another
+ *
+ * Move the mapped pages at srcBase in the VM src to the unmapped range
+ * from base to limit in vm (which may be the same VM), keeping their
+ * contents, and reserve the source range again.  This reuses memory
+ * without returning it to the operating system and then faulting in
+ * fresh zeroed pages.  Only Linux can do this; elsewhere return
+ * ResUNIMPL and the caller falls back to unmapping and mapping.  See
+ * <design/arena/#spare.remap>.
+ */
+
+Res VMRemap(VM vm, Addr base, Addr limit, VM src, Addr srcBase)
+{
+  Size size;
+
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVER(base >= VMBase(vm));
+  AVER(limit <= VMLimit(vm));
+  AVER(AddrIsAligned(base, vm->pageSize));
+  AVER(AddrIsAligned(limit, vm->pageSize));
+  AVERT(VM, src);
+  AVER(srcBase >= VMBase(src));
+  AVER(AddrIsAligned(srcBase, src->pageSize));
+
+  size = AddrOffset(base, limit);
+  AVER(AddrAdd(srcBase, size) <= VMLimit(src));
+  AVER(size <= VMMapped(src));
+
+#if defined(MPS_OS_LI) && defined(MREMAP_MAYMOVE) && defined(MREMAP_FIXED)
+  {
+    void *addr = MAP_FAILED;
+
+#if defined(MREMAP_DONTUNMAP)
+    /* .remap.dontunmap: Leave an empty mapping at the source, so that
+       no other mmap can take the address space before it is reserved
+       again.  Older kernels don't support this flag. */
+    addr = mremap((void *)srcBase, (size_t)size, (size_t)size,
+                  MREMAP_MAYMOVE | MREMAP_FIXED | MREMAP_DONTUNMAP,
+                  (void *)base);
+#endif
+    if (addr == MAP_FAILED)
+      addr = mremap((void *)srcBase, (size_t)size, (size_t)size,
+                    MREMAP_MAYMOVE | MREMAP_FIXED, (void *)base);
+    if (addr == MAP_FAILED) {
+      AVER(errno == ENOMEM || errno == EINVAL); /* .assume.mmap.err */
+      return ResMEMORY;
+    }
+    AVER(addr == (void *)base);
+
+    /* see <design/vmo1/#fun.unmap.offset> */
+    addr = mmap((void *)srcBase, (size_t)size,
+                PROT_NONE, MAP_ANON | MAP_PRIVATE | MAP_FIXED,
+                -1, 0);
+    AVER(addr == (void *)srcBase);
+  }
+
+  src->mapped -= size;
+  vm->mapped += size;
+  AVER(VMMapped(vm) <= VMReserved(vm));
+
+  EVENT3(VMUnmap, src, srcBase, AddrAdd(srcBase, size));
+  EVENT3(VMMap, vm, base, limit);
+  return ResOK;
+#else
+  return ResUNIMPL;
+#endif
+}
+
+
+/* VMAdviseHuge -- advise on huge pages for a range of memory
+ *
+ * If the VM was created for huge pages, ask the operating system to
+ * back the range with transparent huge pages (if huge is TRUE) or not
+ * to (if FALSE).  The advice is lost when the range is unmapped.
+ * Operating systems without transparent huge pages ignore it.  See
+ * <design/arena/#huge>.
+ */
+
+void VMAdviseHuge(VM vm, Addr base, Addr limit, Bool huge)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVER(base >= VMBase(vm));
+  AVER(limit <= VMLimit(vm));
+  AVERT(Bool, huge);
+
+  if (!vm->hugePages)
+    return;
+#if defined(MADV_HUGEPAGE) && defined(MADV_NOHUGEPAGE)
+  {
+    /* Advice is only a hint, so failure is ignored. */
+    (void)madvise((void *)base, (size_t)AddrOffset(base, limit),
+                  huge ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+  }
+#endif
+}
+
+
+#if defined(MPS_OS_LI) && defined(SYS_mbind)
+
+/* nodeId -- return the id of the NUMA node with a given index
+ *
+ * The arena numbers its nodes from zero, but the online node ids may
+ * be sparse, so index i means the i'th online node.  Indexes beyond
+ * the online nodes (a faked topology) get ids beyond the last online
+ * node, which the operating system rejects.
+ */
+
+static Index nodeId(VM vm, Index node)
+{
+  Index id, seen = 0, next = 0;
+
+  for (id = 0; id < MPS_WORD_WIDTH; ++id) {
+    if ((vm->nodeIds >> id) & 1) {
+      if (seen == node)
+        return id;
+      ++seen;
+      next = id + 1;
+    }
+  }
+  return next + (node - seen);
+}
+
+#endif /* defined(MPS_OS_LI) && defined(SYS_mbind) */
+
+
+/* VMBind -- prefer a NUMA node for a range of memory
+ *
+ * Set the memory policy of a mapped range so that its pages are
+ * preferably allocated on the node with the given index (see nodeId)
+ * when first touched.  The
+ * policy is lost when the range is unmapped, so the arena binds each
+ * mapping afresh.  Return ResUNIMPL if the operating system has no
+ * memory policy, or ResFAIL if it rejects the node.  See
+ * <design/arena/#numa>.
+ */
+
+Res VMBind(VM vm, Addr base, Addr limit, Index node)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVER(base >= VMBase(vm));
+  AVER(limit <= VMLimit(vm));
+  AVER(AddrIsAligned(base, vm->pageSize));
+  AVER(AddrIsAligned(limit, vm->pageSize));
+  AVER(node < MPS_WORD_WIDTH);
+
+#if defined(MPS_OS_LI) && defined(SYS_mbind)
+  {
+    Index id = nodeId(vm, node);
+    unsigned long mask;
+    if (id >= MPS_WORD_WIDTH)
+      return ResFAIL;
+    mask = 1ul << id;
+    if (syscall(SYS_mbind, (void *)base, (size_t)AddrOffset(base, limit),
+                MPOL_PREFERRED, &mask, (unsigned long)MPS_WORD_WIDTH + 1,
+                0) != 0)
+      return ResFAIL;
+    return ResOK;
+  }
+#else
+  return ResUNIMPL;
+#endif
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2014 Ravenbrook Limited <http://www.ravenbrook.com/>.
@@ -66,6 +66,18 @@ Size PageSize(void)
 }
 
 
+/* NodeCount -- return the number of NUMA nodes
+ *
+ * NUMA placement is not implemented on Windows, so the arena
+ * treats it as having one node.
+ */
+
+Count NodeCount(void)
+{
+  return 1;
+}
+
+
 typedef struct VMParamsStruct {
   Bool topDown;
 } VMParamsStruct, *VMParams;
@@ -139,6 +151,8 @@ Res VMInit(VM vm, Size size, Size grainSize, void *params)
   AVER(vm->limit <= AddrAdd((Addr)vm->block, reserved));
   vm->reserved = reserved;
   vm->mapped = 0;
+  vm->hugePages = FALSE;
+  vm->nodeIds = 0;
 
   vm->sig = VMSig;
   AVERT(VM, vm);
@@ -227,6 +241,50 @@ void VMUnmap(VM vm, Addr base, Addr limit)
 }
 
 
+/* VMRemap -- move mapped memory from one place to another
+ *
+ * Windows can't move committed pages between addresses, so the
+ * caller falls back to unmapping and mapping.
+ */
+
+Res VMRemap(VM vm, Addr base, Addr limit, VM src, Addr srcBase)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVERT(VM, src);
+  AVER(srcBase != (Addr)0);
+  return ResUNIMPL;
+}
+
+
+/* VMAdviseHuge -- advise on huge pages for a range of memory
+ *
+ * Windows large pages need a privilege and can't be committed
+ * piecemeal, so MPS_KEY_ARENA_HUGE_PAGES has no effect here.
+ */
+
+void VMAdviseHuge(VM vm, Addr base, Addr limit, Bool huge)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  AVERT(Bool, huge);
+}
+
+
+/* VMBind -- prefer a NUMA node for a range of memory
+ *
+ * See NodeCount.
+ */
+
+Res VMBind(VM vm, Addr base, Addr limit, Index node)
+{
+  AVERT(VM, vm);
+  AVER(base < limit);
+  UNUSED(node);
+  return ResUNIMPL;
+}
+
+
 /* C. COPYRIGHT AND LICENSE
  *
  * Copyright (C) 2001-2014 Ravenbrook Limited <http://www.ravenbrook.com/>.